@@ -0,0 +1,806 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+#include "archiveindex.h"
+
+#include <assert.h>
+#include <sys/stat.h>
+
+#include <qdatastream.h>
+#include <qdatetime.h>
+#include <qfile.h>
+#include <qfileinfo.h>
+
+#include <kfilterdev.h>
+#include <kmdcodec.h>
+#include <kstandarddirs.h>
+#include <kurl.h>
+
+#include "workerpool.h"
+
+// Increase the version if the format of the cached index changes.
+#define INDEX_MAGIC   0xD3A1C0DE
+#define INDEX_VERSION 1
+
+// Maximum number of archive indices, which are kept in memory.
+#define MAX_ARCHIVES 4
+
+/**
+ * @brief Builds the index of one archive by a thread of the worker pool.
+ *
+ * The indexer first tries to read the cached index. If no valid
+ * cached index is available, the archive is read once from the
+ * beginning to the end and the index is written to the cache.
+ *
+ * All data which requires access to the KDE services (mime types,
+ * filter plugins, standard directories) is prepared by ArchiveIndex
+ * in the GUI thread.
+ */
+class ArchiveIndexer : public WorkerJob
+{
+public:
+    ArchiveIndexer(const QString& archivePath,
+                   const QString& mimeType,
+                   QIODevice* device,
+                   const QString& cacheFile);
+    virtual ~ArchiveIndexer();
+
+    const QString& archivePath() const { return m_archivePath; }
+
+    /**
+     * Returns the created archive index and passes the ownership
+     * to the caller. 0 is returned if the archive could not be read.
+     */
+    ArchiveIndex::Archive* takeArchive();
+
+protected:
+    virtual void run();
+
+private:
+    bool readCache();
+    void writeCache();
+    bool readTar();
+    bool readZip();
+
+    /** Appends the entry and assures that all parent directories are available. */
+    void addEntry(ArchiveIndex::Entry& entry);
+
+    /** Creates the directory → entries map after all entries have been added. */
+    void createChildren();
+
+    static QString cleanPath(const QString& path);
+    static KIO::filesize_t tarNumber(const char* buffer, int length);
+
+    QString m_archivePath;
+    QIODevice* m_device;
+    QString m_cacheFile;
+    ArchiveIndex::Archive* m_archive;
+
+    /** Maps the path of each added directory to its index inside the entries. */
+    QMap<QString, uint> m_knownDirs;
+};
+
+ArchiveIndexer::ArchiveIndexer(const QString& archivePath,
+                               const QString& mimeType,
+                               QIODevice* device,
+                               const QString& cacheFile) :
+    m_archivePath(archivePath),
+    m_device(device),
+    m_cacheFile(cacheFile),
+    m_archive(0)
+{
+    m_archive = new ArchiveIndex::Archive();
+    m_archive->mimeType = mimeType;
+
+    const QFileInfo info(archivePath);
+    m_archive->archiveSize = info.size();
+    m_archive->archiveMTime = info.lastModified().toTime_t();
+}
+
+ArchiveIndexer::~ArchiveIndexer()
+{
+    delete m_device;
+    m_device = 0;
+
+    delete m_archive;
+    m_archive = 0;
+}
+
+ArchiveIndex::Archive* ArchiveIndexer::takeArchive()
+{
+    ArchiveIndex::Archive* archive = m_archive;
+    m_archive = 0;
+    return archive;
+}
+
+void ArchiveIndexer::run()
+{
+    if (readCache()) {
+        createChildren();
+    }
+    else {
+        const bool isZip = (m_archive->mimeType == "application/x-zip");
+        const bool ok = isZip ? readZip() : readTar();
+        if (ok) {
+            writeCache();
+            createChildren();
+        }
+        else {
+            delete m_archive;
+            m_archive = 0;
+        }
+    }
+}
+
+bool ArchiveIndexer::readCache()
+{
+    QFile file(m_cacheFile);
+    if (!file.open(IO_ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    Q_UINT32 magic = 0;
+    Q_UINT32 version = 0;
+    stream >> magic >> version;
+    if ((magic != INDEX_MAGIC) || (version != INDEX_VERSION)) {
+        return false;
+    }
+
+    QString path;
+    Q_UINT64 archiveSize = 0;
+    Q_UINT32 archiveMTime = 0;
+    Q_UINT32 count = 0;
+    stream >> path >> archiveSize >> archiveMTime >> count;
+    if ((path != m_archivePath) ||
+        (archiveSize != m_archive->archiveSize) ||
+        (archiveMTime != static_cast<Q_UINT32>(m_archive->archiveMTime))) {
+        // the archive has been modified since the index has been written
+        return false;
+    }
+
+    m_archive->entries.reserve(count);
+    for (Q_UINT32 i = 0; (i < count) && !stream.atEnd(); ++i) {
+        ArchiveIndex::Entry entry;
+        Q_UINT64 offset = 0;
+        Q_UINT64 size = 0;
+        Q_UINT32 mtime = 0;
+        Q_UINT32 mode = 0;
+        stream >> entry.path >> offset >> size >> mtime >> mode >> entry.linkDest;
+        entry.offset = offset;
+        entry.size = size;
+        entry.mtime = mtime;
+        entry.mode = mode;
+        m_archive->entries.append(entry);
+    }
+
+    return m_archive->entries.count() == count;
+}
+
+void ArchiveIndexer::writeCache()
+{
+    QFile file(m_cacheFile);
+    if (!file.open(IO_WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    const QValueVector<ArchiveIndex::Entry>& entries = m_archive->entries;
+    stream << static_cast<Q_UINT32>(INDEX_MAGIC)
+           << static_cast<Q_UINT32>(INDEX_VERSION)
+           << m_archivePath
+           << static_cast<Q_UINT64>(m_archive->archiveSize)
+           << static_cast<Q_UINT32>(m_archive->archiveMTime)
+           << static_cast<Q_UINT32>(entries.count());
+
+    QValueVector<ArchiveIndex::Entry>::ConstIterator it = entries.begin();
+    const QValueVector<ArchiveIndex::Entry>::ConstIterator end = entries.end();
+    while (it != end) {
+        stream << (*it).path
+               << static_cast<Q_UINT64>((*it).offset)
+               << static_cast<Q_UINT64>((*it).size)
+               << static_cast<Q_UINT32>((*it).mtime)
+               << static_cast<Q_UINT32>((*it).mode)
+               << (*it).linkDest;
+        ++it;
+    }
+    file.close();
+}
+
+bool ArchiveIndexer::readTar()
+{
+    // The tar file is read as stream: only the 512 byte headers are read,
+    // the data of the members is skipped. For compressed archives skipping
+    // requires decompressing, but this is done only once per archive.
+    if ((m_device == 0) || !m_device->open(IO_ReadOnly)) {
+        return false;
+    }
+
+    const int blockSize = 512;
+    char header[blockSize];
+
+    QString longName;
+    QString longLink;
+    QString paxPath;
+    QString paxLink;
+    KIO::filesize_t paxSize = 0;
+    bool hasPaxSize = false;
+
+    KIO::filesize_t pos = 0;
+    while (m_device->readBlock(header, blockSize) == blockSize) {
+        if (isCancelled()) {
+            return false;
+        }
+        pos += blockSize;
+
+        if (header[0] == '\0') {
+            // an empty block marks the end of the archive
+            break;
+        }
+
+        // verify the checksum, which is calculated with spaces instead of the checksum field
+        const KIO::filesize_t checksum = tarNumber(&header[148], 8);
+        unsigned long sum = 0;
+        for (int i = 0; i < blockSize; ++i) {
+            sum += ((i >= 148) && (i < 156)) ? ' ' : static_cast<unsigned char>(header[i]);
+        }
+        if (sum != checksum) {
+            // A partial index would be cached permanently, hence the
+            // archive is listed by the I/O slave instead.
+            return false;
+        }
+
+        const char type = header[156];
+        KIO::filesize_t size = tarNumber(&header[124], 12);
+        if (hasPaxSize && (type != 'x') && (type != 'g')) {
+            size = paxSize;
+        }
+        const KIO::filesize_t paddedSize = ((size + blockSize - 1) / blockSize) * blockSize;
+
+        if ((type == 'L') || (type == 'K') || (type == 'x')) {
+            // GNU long names and PAX headers store their data inside the
+            // member and apply to the following header
+            if (paddedSize > 1024 * 1024) {
+                return false;
+            }
+            QByteArray data(static_cast<int>(paddedSize));
+            if (m_device->readBlock(data.data(), paddedSize) != static_cast<Q_LONG>(paddedSize)) {
+                return false;
+            }
+            pos += paddedSize;
+
+            if (type == 'L') {
+                longName = QFile::decodeName(QCString(data.data(), size + 1));
+            }
+            else if (type == 'K') {
+                longLink = QFile::decodeName(QCString(data.data(), size + 1));
+            }
+            else {
+                // PAX records have the format "<length> <key>=<value>\n"
+                uint recordPos = 0;
+                while (recordPos < size) {
+                    const char* record = data.data() + recordPos;
+                    const uint recordLength = strtoul(record, 0, 10);
+                    if ((recordLength == 0) || (recordLength > size - recordPos)) {
+                        break;
+                    }
+                    const QCString line(record, recordLength);  // without the trailing newline
+                    const int keyStart = line.find(' ') + 1;
+                    const int valueStart = line.find('=') + 1;
+                    if ((keyStart > 0) && (valueStart > keyStart)) {
+                        const QCString key(line.mid(keyStart, valueStart - keyStart - 1));
+                        const QCString value(line.mid(valueStart));
+                        if (key == "path") {
+                            paxPath = QString::fromUtf8(value);
+                        }
+                        else if (key == "linkpath") {
+                            paxLink = QString::fromUtf8(value);
+                        }
+                        else if (key == "size") {
+                            paxSize = value.toULongLong();
+                            hasPaxSize = true;
+                        }
+                    }
+                    recordPos += recordLength;
+                }
+            }
+            continue;
+        }
+
+        if (type == 'g') {
+            // global PAX headers are not respected
+            m_device->at(pos + paddedSize);
+            pos += paddedSize;
+            continue;
+        }
+
+        ArchiveIndex::Entry entry;
+        if (!paxPath.isEmpty()) {
+            entry.path = paxPath;
+        }
+        else if (!longName.isEmpty()) {
+            entry.path = longName;
+        }
+        else {
+            QCString name(&header[0], 101);
+            const bool isUStar = (strncmp(&header[257], "ustar", 5) == 0);
+            if (isUStar && (header[345] != '\0')) {
+                const QCString prefix(&header[345], 156);
+                name = prefix + '/' + name;
+            }
+            entry.path = QFile::decodeName(name);
+        }
+
+        if (!paxLink.isEmpty()) {
+            entry.linkDest = paxLink;
+        }
+        else if (!longLink.isEmpty()) {
+            entry.linkDest = longLink;
+        }
+        else {
+            entry.linkDest = QFile::decodeName(QCString(&header[157], 101));
+        }
+
+        entry.offset = pos;
+        entry.size = size;
+        entry.mtime = static_cast<time_t>(tarNumber(&header[136], 12));
+
+        const mode_t permissions = static_cast<mode_t>(tarNumber(&header[100], 8)) & 07777;
+        switch (type) {
+            case '5': entry.mode = S_IFDIR | permissions; entry.size = 0; break;
+            case '2': entry.mode = S_IFLNK | permissions; entry.size = 0; break;
+            default:  entry.mode = S_IFREG | permissions; break;
+        }
+        if (entry.path.endsWith("/")) {
+            entry.mode = S_IFDIR | permissions;
+        }
+
+        addEntry(entry);
+
+        longName = QString::null;
+        longLink = QString::null;
+        paxPath = QString::null;
+        paxLink = QString::null;
+        hasPaxSize = false;
+
+        // skip the member data
+        if (S_ISREG(entry.mode) && (paddedSize > 0)) {
+            pos += paddedSize;
+            if (!m_device->at(pos)) {
+                return false;
+            }
+        }
+    }
+
+    m_device->close();
+    return true;
+}
+
+bool ArchiveIndexer::readZip()
+{
+    // Zip files contain a central directory at the end of the file, hence
+    // no streaming pass is required. Zip64 archives are not supported.
+    if ((m_device == 0) || !m_device->open(IO_ReadOnly)) {
+        return false;
+    }
+
+    // search the 'end of central directory' record, which is followed
+    // by a comment of up to 64 KB
+    const int eocdSize = 22;
+    const Q_ULONG fileSize = m_device->size();
+    if (fileSize < static_cast<Q_ULONG>(eocdSize)) {
+        return false;
+    }
+    const Q_ULONG searchSize = QMIN(fileSize, static_cast<Q_ULONG>(eocdSize + 0xFFFF));
+    QByteArray tail(static_cast<int>(searchSize));
+    m_device->at(fileSize - searchSize);
+    if (m_device->readBlock(tail.data(), searchSize) != static_cast<Q_LONG>(searchSize)) {
+        return false;
+    }
+
+    #define ZIP_UINT16(p) (static_cast<uint>(static_cast<unsigned char>((p)[0])) | \
+                           (static_cast<uint>(static_cast<unsigned char>((p)[1])) << 8))
+    #define ZIP_UINT32(p) (ZIP_UINT16(p) | (ZIP_UINT16((p) + 2) << 16))
+
+    int eocd = static_cast<int>(searchSize) - eocdSize;
+    while ((eocd >= 0) && (ZIP_UINT32(tail.data() + eocd) != 0x06054b50)) {
+        --eocd;
+    }
+    if (eocd < 0) {
+        return false;
+    }
+
+    const char* record = tail.data() + eocd;
+    const uint entryCount = ZIP_UINT16(record + 10);
+    const uint directorySize = ZIP_UINT32(record + 12);
+    const uint directoryOffset = ZIP_UINT32(record + 16);
+    if ((directoryOffset > fileSize) || (directorySize > fileSize - directoryOffset)) {
+        // the record is damaged or has been crafted
+        return false;
+    }
+
+    QByteArray directory(directorySize);
+    m_device->at(directoryOffset);
+    if (m_device->readBlock(directory.data(), directorySize) != static_cast<Q_LONG>(directorySize)) {
+        return false;
+    }
+
+    m_archive->entries.reserve(entryCount);
+    uint pos = 0;
+    for (uint i = 0; (i < entryCount) && (pos + 46 <= directorySize); ++i) {
+        const char* header = directory.data() + pos;
+        if (ZIP_UINT32(header) != 0x02014b50) {
+            break;
+        }
+
+        const uint madeBy = ZIP_UINT16(header + 4);
+        const uint dosTime = ZIP_UINT16(header + 12);
+        const uint dosDate = ZIP_UINT16(header + 14);
+        const uint nameLength = ZIP_UINT16(header + 28);
+        const uint extraLength = ZIP_UINT16(header + 30);
+        const uint commentLength = ZIP_UINT16(header + 32);
+        const uint externalAttributes = ZIP_UINT32(header + 38);
+        const uint headerSize = 46 + nameLength + extraLength + commentLength;
+        if (headerSize > directorySize - pos) {
+            return false;
+        }
+
+        // QCString copies at most nameLength bytes and appends the terminating zero
+        ArchiveIndex::Entry entry;
+        entry.path = QFile::decodeName(QCString(header + 46, nameLength + 1));
+        entry.size = ZIP_UINT32(header + 24);
+        entry.offset = ZIP_UINT32(header + 42);
+
+        const QDateTime dateTime(QDate(1980 + (dosDate >> 9), (dosDate >> 5) & 0x0f, dosDate & 0x1f),
+                                 QTime(dosTime >> 11, (dosTime >> 5) & 0x3f, (dosTime & 0x1f) * 2));
+        entry.mtime = dateTime.isValid() ? dateTime.toTime_t() : 0;
+
+        const bool isDir = entry.path.endsWith("/");
+        const bool isUnix = ((madeBy >> 8) == 3);
+        if (isUnix && ((externalAttributes >> 16) != 0)) {
+            entry.mode = static_cast<mode_t>(externalAttributes >> 16);
+        }
+        else {
+            entry.mode = isDir ? (S_IFDIR | 0755) : (S_IFREG | 0644);
+        }
+        if (isDir) {
+            entry.size = 0;
+        }
+
+        addEntry(entry);
+        pos += headerSize;
+    }
+
+    #undef ZIP_UINT32
+    #undef ZIP_UINT16
+
+    m_device->close();
+    return true;
+}
+
+void ArchiveIndexer::addEntry(ArchiveIndex::Entry& entry)
+{
+    entry.path = cleanPath(entry.path);
+    if (entry.path.isEmpty()) {
+        return;
+    }
+
+    // Archives don't need to contain entries for directories. Create
+    // the missing parent directories so that each entry can be reached.
+    int slashIndex = entry.path.find('/');
+    while (slashIndex > 0) {
+        const QString dirPath(entry.path.left(slashIndex));
+        if (!m_knownDirs.contains(dirPath)) {
+            m_knownDirs.insert(dirPath, m_archive->entries.count());
+
+            ArchiveIndex::Entry dirEntry;
+            dirEntry.path = dirPath;
+            dirEntry.offset = 0;
+            dirEntry.size = 0;
+            dirEntry.mtime = entry.mtime;
+            dirEntry.mode = S_IFDIR | 0755;
+            m_archive->entries.append(dirEntry);
+        }
+        slashIndex = entry.path.find('/', slashIndex + 1);
+    }
+
+    if (S_ISDIR(entry.mode)) {
+        QMap<QString, uint>::ConstIterator it = m_knownDirs.find(entry.path);
+        if (it != m_knownDirs.end()) {
+            // replace the implicitly created directory by the real one
+            m_archive->entries[it.data()] = entry;
+            return;
+        }
+        m_knownDirs.insert(entry.path, m_archive->entries.count());
+    }
+
+    m_archive->entries.append(entry);
+}
+
+void ArchiveIndexer::createChildren()
+{
+    m_knownDirs.clear();
+
+    QMap<QString, QValueList<uint> >& children = m_archive->children;
+    children.insert(QString(""), QValueList<uint>());
+
+    const uint count = m_archive->entries.count();
+    for (uint i = 0; i < count; ++i) {
+        const ArchiveIndex::Entry& entry = m_archive->entries[i];
+        const int slashIndex = entry.path.findRev('/');
+        const QString dirPath((slashIndex < 0) ? QString("") : entry.path.left(slashIndex));
+        children[dirPath].append(i);
+
+        if (S_ISDIR(entry.mode) && !children.contains(entry.path)) {
+            children.insert(entry.path, QValueList<uint>());
+        }
+    }
+}
+
+QString ArchiveIndexer::cleanPath(const QString& path)
+{
+    QString cleaned(path);
+    while (cleaned.startsWith("./")) {
+        cleaned.remove(0, 2);
+    }
+    while (cleaned.startsWith("/")) {
+        cleaned.remove(0, 1);
+    }
+    while (cleaned.endsWith("/")) {
+        cleaned.truncate(cleaned.length() - 1);
+    }
+    return (cleaned == ".") ? QString::null : cleaned;
+}
+
+KIO::filesize_t ArchiveIndexer::tarNumber(const char* buffer, int length)
+{
+    KIO::filesize_t value = 0;
+
+    if (static_cast<unsigned char>(buffer[0]) & 0x80) {
+        // GNU base-256 encoding, which is used for sizes > 8 GB
+        value = static_cast<unsigned char>(buffer[0]) & 0x7f;
+        for (int i = 1; i < length; ++i) {
+            value = (value << 8) | static_cast<unsigned char>(buffer[i]);
+        }
+        return value;
+    }
+
+    // octal number, which might have leading spaces and is terminated
+    // by a space or a null character
+    int i = 0;
+    while ((i < length) && (buffer[i] == ' ')) {
+        ++i;
+    }
+    while ((i < length) && (buffer[i] >= '0') && (buffer[i] <= '7')) {
+        value = (value << 3) + (buffer[i] - '0');
+        ++i;
+    }
+    return value;
+}
+
+ArchiveIndex& ArchiveIndex::instance()
+{
+    static ArchiveIndex* instance = 0;
+    if (instance == 0) {
+        instance = new ArchiveIndex();
+    }
+    return *instance;
+}
+
+void ArchiveIndex::requestIndex(const QString& archivePath, const QString& mimeType)
+{
+    if (!isSupported(mimeType) || hasIndex(archivePath) ||
+        (m_pendingIndexers.find(archivePath) != 0)) {
+        return;
+    }
+
+    // The filter device must be created inside the GUI thread, as the
+    // lookup of the decompression filter uses the KDE service database.
+    QString filterMimeType;
+    if (mimeType == "application/x-tgz") {
+        filterMimeType = "application/x-gzip";
+    }
+    else if (mimeType == "application/x-tbz") {
+        filterMimeType = "application/x-bzip2";
+    }
+    QIODevice* device = KFilterDev::deviceForFile(archivePath, filterMimeType);
+
+    ArchiveIndexer* indexer = new ArchiveIndexer(archivePath,
+                                                 mimeType,
+                                                 device,
+                                                 cacheFile(archivePath));
+    m_pendingIndexers.insert(archivePath, indexer);
+    WorkerPool::instance().enqueue(indexer, WorkerJob::MetaData);
+}
+
+bool ArchiveIndex::hasIndex(const QString& archivePath) const
+{
+    return m_archives.find(archivePath) != 0;
+}
+
+bool ArchiveIndex::listDirectory(const KURL& url, KFileItemList& items)
+{
+    const QString protocol(url.protocol());
+    if ((protocol != "tar") && (protocol != "zip")) {
+        return false;
+    }
+
+    QString innerPath;
+    QString archivePath;
+    Archive* archive = findArchive(url.path(-1), innerPath, archivePath);
+    if (archive == 0) {
+        return false;
+    }
+
+    // assure that the archive has not been modified since the index has been created
+    const QFileInfo info(archivePath);
+    if ((static_cast<KIO::filesize_t>(info.size()) != archive->archiveSize) ||
+        (info.lastModified().toTime_t() != static_cast<uint>(archive->archiveMTime))) {
+        const QString mimeType(archive->mimeType);
+        m_archives.remove(archivePath);
+        m_recentlyUsed.remove(archivePath);
+        requestIndex(archivePath, mimeType);
+        return false;
+    }
+
+    QMap<QString, QValueList<uint> >::ConstIterator childrenIt = archive->children.find(innerPath);
+    if (childrenIt == archive->children.end()) {
+        // the URL does not represent a directory of the archive
+        return false;
+    }
+
+    m_recentlyUsed.remove(archivePath);
+    m_recentlyUsed.append(archivePath);
+
+    KURL dirURL(url);
+    dirURL.adjustPath(+1);
+
+    const QValueList<uint>& children = childrenIt.data();
+    QValueList<uint>::ConstIterator it = children.begin();
+    const QValueList<uint>::ConstIterator end = children.end();
+    while (it != end) {
+        const Entry& entry = archive->entries[*it];
+
+        KIO::UDSEntry udsEntry;
+        KIO::UDSAtom atom;
+
+        atom.m_uds = KIO::UDS_NAME;
+        atom.m_str = entry.path.section('/', -1);
+        udsEntry.append(atom);
+
+        atom.m_uds = KIO::UDS_FILE_TYPE;
+        atom.m_long = entry.mode & S_IFMT;
+        udsEntry.append(atom);
+
+        atom.m_uds = KIO::UDS_ACCESS;
+        atom.m_long = entry.mode & 07777;
+        udsEntry.append(atom);
+
+        atom.m_uds = KIO::UDS_SIZE;
+        atom.m_long = entry.size;
+        udsEntry.append(atom);
+
+        atom.m_uds = KIO::UDS_MODIFICATION_TIME;
+        atom.m_long = entry.mtime;
+        udsEntry.append(atom);
+
+        if (S_ISLNK(entry.mode)) {
+            atom.m_uds = KIO::UDS_LINK_DEST;
+            atom.m_str = entry.linkDest;
+            udsEntry.append(atom);
+        }
+
+        items.append(new KFileItem(udsEntry, dirURL, true, true));
+        ++it;
+    }
+
+    return true;
+}
+
+bool ArchiveIndex::isSupported(const QString& mimeType)
+{
+    return (mimeType == "application/x-tar") ||
+           (mimeType == "application/x-tgz") ||
+           (mimeType == "application/x-tbz") ||
+           (mimeType == "application/x-zip");
+}
+
+ArchiveIndex::ArchiveIndex() :
+    QObject(0)
+{
+    m_archives.setAutoDelete(true);
+
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotJobFinished(WorkerJob*)));
+}
+
+ArchiveIndex::~ArchiveIndex()
+{
+    QDictIterator<ArchiveIndexer> it(m_pendingIndexers);
+    while (it.current() != 0) {
+        WorkerPool::instance().cancel(it.current());
+        ++it;
+    }
+    m_pendingIndexers.clear();
+}
+
+void ArchiveIndex::slotJobFinished(WorkerJob* job)
+{
+    QDictIterator<ArchiveIndexer> it(m_pendingIndexers);
+    while ((it.current() != 0) && (static_cast<WorkerJob*>(it.current()) != job)) {
+        ++it;
+    }
+    if (it.current() == 0) {
+        // the job is no archive indexer
+        return;
+    }
+
+    // the indexer is deleted by the worker pool
+    ArchiveIndexer* indexer = it.current();
+    const QString archivePath(indexer->archivePath());
+    m_pendingIndexers.remove(archivePath);
+
+    Archive* archive = indexer->takeArchive();
+    if (archive == 0) {
+        return;
+    }
+
+    m_archives.replace(archivePath, archive);
+    m_recentlyUsed.remove(archivePath);
+    m_recentlyUsed.append(archivePath);
+    while (m_recentlyUsed.count() > MAX_ARCHIVES) {
+        m_archives.remove(m_recentlyUsed.first());
+        m_recentlyUsed.pop_front();
+    }
+
+    emit indexReady(archivePath);
+}
+
+ArchiveIndex::Archive* ArchiveIndex::findArchive(const QString& path,
+                                                 QString& innerPath,
+                                                 QString& archivePath) const
+{
+    QDictIterator<Archive> it(m_archives);
+    while (it.current() != 0) {
+        const QString currentPath(it.currentKey());
+        if (path == currentPath) {
+            innerPath = "";
+            archivePath = currentPath;
+            return it.current();
+        }
+        if (path.startsWith(currentPath + '/')) {
+            innerPath = path.mid(currentPath.length() + 1);
+            archivePath = currentPath;
+            return it.current();
+        }
+        ++it;
+    }
+
+    return 0;
+}
+
+QString ArchiveIndex::cacheFile(const QString& archivePath) const
+{
+    KMD5 md5(QFile::encodeName(archivePath));
+    QString fileName(KGlobal::dirs()->saveLocation("cache", "d3lphin/archives/"));
+    fileName.append(QString::fromLatin1(md5.hexDigest()));
+    return fileName;
+}
+
+#include "archiveindex.moc"
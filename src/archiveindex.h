@@ -0,0 +1,161 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+#ifndef ARCHIVEINDEX_H
+#define ARCHIVEINDEX_H
+
+#include <qobject.h>
+#include <qdict.h>
+#include <qmap.h>
+#include <qstringlist.h>
+#include <qvaluelist.h>
+#include <qvaluevector.h>
+
+#include <kfileitem.h>
+#include <kio/global.h>
+
+class KURL;
+class ArchiveIndexer;
+class WorkerJob;
+
+/**
+ * @brief Keeps a persistent index of the members of local tar and zip archives.
+ *
+ * Browsing inside an archive is done by the 'tar' and 'zip' protocols, which
+ * must open (and for compressed tar files decompress) the archive from the
+ * beginning for each listed directory. The archive index reads the archive once
+ * by a streaming pass inside the WorkerPool and remembers the path, the offset,
+ * the size and the modification time of each member. The index is stored inside
+ * the cache directory of Dolphin and reused as long as the archive has not been
+ * modified.
+ *
+ * As soon as an index is available, DolphinView lists the directories of the
+ * archive by ArchiveIndex::listDirectory() instead of using the I/O slaves, which
+ * only costs O(entries in the directory). If no index is available (yet), the
+ * caller falls back to the I/O slaves.
+ *
+ * Sample code:
+ * \code
+ * ArchiveIndex& index = ArchiveIndex::instance();
+ * index.requestIndex("/tmp/logs.tar.gz", "application/x-tgz");
+ * ...
+ * KFileItemList items;
+ * if (index.listDirectory(KURL("tar:/tmp/logs.tar.gz/var/log"), items)) {
+ *     // the items are owned by the caller
+ * }
+ * \endcode
+ */
+class ArchiveIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** Describes one member of an archive. */
+    struct Entry
+    {
+        /** Path of the member relative to the archive root (no leading slash). */
+        QString path;
+
+        /**
+         * For tar files: offset of the member data inside the uncompressed tar
+         * stream. For zip files: offset of the local file header.
+         */
+        KIO::filesize_t offset;
+
+        KIO::filesize_t size;
+        time_t mtime;
+        mode_t mode;
+        QString linkDest;
+    };
+
+    static ArchiveIndex& instance();
+
+    /**
+     * Requests an index for the local archive \a archivePath having the
+     * MIME type \a mimeType. If a valid index is already available or is
+     * currently being built, nothing happens. Otherwise the index is loaded
+     * from the cache or built in a background thread. The signal
+     * ArchiveIndex::indexReady() is emitted as soon as the index is available.
+     */
+    void requestIndex(const QString& archivePath, const QString& mimeType);
+
+    /** Returns true, if an index is available for the archive \a archivePath. */
+    bool hasIndex(const QString& archivePath) const;
+
+    /**
+     * Creates the items for the directory \a url, which must use the 'tar'
+     * or 'zip' protocol, and appends them to \a items. The created items are
+     * owned by the caller. False is returned, if no index is available for
+     * the archive or if \a url does not represent a directory of the archive.
+     */
+    bool listDirectory(const KURL& url, KFileItemList& items);
+
+    /**
+     * Returns true, if archives of the MIME type \a mimeType can be indexed.
+     */
+    static bool isSupported(const QString& mimeType);
+
+signals:
+    /** Is emitted if the index for the archive \a archivePath is available. */
+    void indexReady(const QString& archivePath);
+
+protected:
+    ArchiveIndex();
+    virtual ~ArchiveIndex();
+
+private slots:
+    /** Takes over the index of the archive indexer \a job, which has been finished. */
+    void slotJobFinished(WorkerJob* job);
+
+private:
+    /** Contains the index of one archive. */
+    struct Archive
+    {
+        QString mimeType;
+        KIO::filesize_t archiveSize;
+        time_t archiveMTime;
+        QValueVector<Entry> entries;
+
+        /** Maps a directory path to the indices of its entries inside 'entries'. */
+        QMap<QString, QValueList<uint> > children;
+    };
+
+    /**
+     * Returns the archive, which contains the path \a path. The inner path of
+     * the archive is written to \a innerPath. 0 is returned if no index for
+     * the path is available.
+     */
+    Archive* findArchive(const QString& path, QString& innerPath, QString& archivePath) const;
+
+    /**
+     * Returns the name of the file, where the index for \a archivePath is
+     * cached.
+     */
+    QString cacheFile(const QString& archivePath) const;
+
+    friend class ArchiveIndexer;  // allow to use Archive
+
+    QDict<Archive> m_archives;
+    QDict<ArchiveIndexer> m_pendingIndexers;
+
+    /** Archive paths ordered by the last access, the most recent one is the last element. */
+    QStringList m_recentlyUsed;
+};
+
+#endif
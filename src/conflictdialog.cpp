@@ -0,0 +1,146 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "conflictdialog.h"
+
+#include <qcheckbox.h>
+#include <qfile.h>
+#include <qlabel.h>
+#include <qlayout.h>
+#include <qlistbox.h>
+#include <qradiobutton.h>
+#include <qvbuttongroup.h>
+
+#include <klocale.h>
+
+#include "verificationlog.h"
+
+// Maximum number of conflicting items, which are listed by the dialog.
+#define MAX_LISTED_ITEMS 500
+
+ConflictDialog::ConflictDialog(const QValueVector<ConflictScanJob::Conflict>& conflicts,
+                               const KURL& dest) :
+    KDialogBase(Plain, i18n("Items Already Exist"),
+                Ok|Cancel, Ok),
+    m_conflicts(conflicts),
+    m_destPath(dest.path(-1))
+{
+    setButtonOK(KGuiItem(i18n("Continue"), "apply"));
+
+    QVBoxLayout* topLayout = new QVBoxLayout(plainPage(), 0, spacingHint());
+    topLayout->setMargin(KDialog::marginHint());
+
+    const int count = conflicts.count();
+    QLabel* infoLabel = new QLabel(i18n("1 item already exists in %1:",
+                                        "%n items already exist in %1:",
+                                        count).arg(dest.prettyURL()),
+                                   plainPage());
+
+    QListBox* itemsBox = new QListBox(plainPage());
+    const int listedCount = QMIN(count, MAX_LISTED_ITEMS);
+    for (int i = 0; i < listedCount; ++i) {
+        itemsBox->insertItem(QFile::decodeName(conflicts[i].path));
+    }
+    if (count > listedCount) {
+        itemsBox->insertItem(i18n("... and 1 more item", "... and %n more items", count - listedCount));
+    }
+
+    QVButtonGroup* actionGroup = new QVButtonGroup(i18n("Existing Items"), plainPage());
+    m_overwrite = new QRadioButton(i18n("Overwrite all"), actionGroup);
+    m_overwriteOlder = new QRadioButton(i18n("Overwrite only older items"), actionGroup);
+    m_overwriteNewer = new QRadioButton(i18n("Overwrite only newer items"), actionGroup);
+    m_skip = new QRadioButton(i18n("Skip all"), actionGroup);
+    m_rename = new QRadioButton(i18n("Keep both by renaming the new items"), actionGroup);
+    m_overwriteOlder->setChecked(true);
+
+    m_skipIdentical = new QCheckBox(i18n("Skip files having the same size and modification time"),
+                                    plainPage());
+    m_skipIdentical->setChecked(true);
+
+    topLayout->addWidget(infoLabel);
+    topLayout->addWidget(itemsBox);
+    topLayout->addWidget(actionGroup);
+    topLayout->addWidget(m_skipIdentical);
+}
+
+ConflictDialog::~ConflictDialog()
+{
+}
+
+ConflictResolutions ConflictDialog::resolutions() const
+{
+    const bool skipIdentical = m_skipIdentical->isChecked();
+    const VerificationLog& log = VerificationLog::instance();
+
+    ConflictResolutions resolutions;
+    QValueVector<ConflictScanJob::Conflict>::ConstIterator it = m_conflicts.begin();
+    const QValueVector<ConflictScanJob::Conflict>::ConstIterator end = m_conflicts.end();
+    while (it != end) {
+        const ConflictScanJob::Conflict& conflict = *it;
+
+        ConflictResolution resolution;
+        resolution.action = ConflictResolution::Skip;
+        if (m_overwrite->isChecked()) {
+            resolution.action = ConflictResolution::Overwrite;
+        }
+        else if (m_overwriteOlder->isChecked()) {
+            if (conflict.sourceMTime > conflict.destMTime) {
+                resolution.action = ConflictResolution::Overwrite;
+            }
+        }
+        else if (m_overwriteNewer->isChecked()) {
+            if (conflict.sourceMTime < conflict.destMTime) {
+                resolution.action = ConflictResolution::Overwrite;
+            }
+        }
+        else if (m_rename->isChecked()) {
+            resolution.action = ConflictResolution::Rename;
+        }
+
+        const bool isSameType = (conflict.sourceIsDir == conflict.destIsDir);
+        if (!isSameType && (resolution.action == ConflictResolution::Overwrite)) {
+            // a folder is never replaced by a file or vice versa, both are kept
+            resolution.action = ConflictResolution::Rename;
+        }
+
+        const bool isIdentical = isSameType &&
+                                 (conflict.sourceSize == conflict.destSize) &&
+                                 (conflict.sourceMTime == conflict.destMTime);
+        if (skipIdentical && isIdentical) {
+            resolution.action = ConflictResolution::Skip;
+        }
+
+        if (isSameType && !conflict.destIsDir &&
+            log.hasFailed(m_destPath + '/' + QFile::decodeName(conflict.path))) {
+            // the existing file is a corrupted copy
+            resolution.action = ConflictResolution::Overwrite;
+        }
+
+        if (resolution.action == ConflictResolution::Rename) {
+            resolution.newName = conflict.suggestedName;
+        }
+        resolutions.insert(conflict.path, resolution);
+        ++it;
+    }
+
+    return resolutions;
+}
+
+#include "conflictdialog.moc"
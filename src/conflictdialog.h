@@ -0,0 +1,72 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef CONFLICTDIALOG_H
+#define CONFLICTDIALOG_H
+
+#include <kdialogbase.h>
+#include <kurl.h>
+
+#include "conflictscanjob.h"
+
+class QCheckBox;
+class QRadioButton;
+
+/**
+ * @brief Asks the user once how all conflicts of a transfer should be resolved.
+ *
+ * The dialog lists the items, which already exist inside the destination,
+ * and offers to overwrite all of them, to overwrite only older or newer
+ * items, to skip them or to rename the copied items automatically. Files
+ * having the same size and modification time can be skipped in any case.
+ * Files, which did not pass the verification of a previous copy operation
+ * (see VerificationLog), are always overwritten.
+ * \code
+ * ConflictDialog dialog(conflicts, dest);
+ * if (dialog.exec() == QDialog::Accepted) {
+ *     const ConflictResolutions resolutions(dialog.resolutions());
+ *     ...
+ * }
+ * \endcode
+ */
+class ConflictDialog : public KDialogBase
+{
+    Q_OBJECT
+
+public:
+    ConflictDialog(const QValueVector<ConflictScanJob::Conflict>& conflicts,
+                   const KURL& dest);
+    virtual ~ConflictDialog();
+
+    /** Returns the resolutions for all conflicts corresponding to the choice of the user. */
+    ConflictResolutions resolutions() const;
+
+private:
+    QValueVector<ConflictScanJob::Conflict> m_conflicts;
+    QString m_destPath;
+    QRadioButton* m_overwrite;
+    QRadioButton* m_overwriteOlder;
+    QRadioButton* m_overwriteNewer;
+    QRadioButton* m_skip;
+    QRadioButton* m_rename;
+    QCheckBox* m_skipIdentical;
+};
+
+#endif
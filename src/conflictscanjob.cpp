@@ -0,0 +1,183 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "conflictscanjob.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <kde_file.h>
+
+ConflictScanJob::ConflictScanJob(const QValueVector<QCString>& sourcePaths, const QCString& destDir) :
+    m_destDir(destDir.copy())
+{
+    m_sourcePaths.reserve(sourcePaths.count());
+    QValueVector<QCString>::ConstIterator it = sourcePaths.begin();
+    const QValueVector<QCString>::ConstIterator end = sourcePaths.end();
+    while (it != end) {
+        m_sourcePaths.append((*it).copy());
+        ++it;
+    }
+}
+
+ConflictScanJob::~ConflictScanJob()
+{
+}
+
+void ConflictScanJob::run()
+{
+    NameSet destNames;
+    readNames(m_destDir, destNames);
+    if (destNames.isEmpty()) {
+        return;
+    }
+
+    NameSet sourceNames;
+    QValueVector<QCString>::ConstIterator it = m_sourcePaths.begin();
+    const QValueVector<QCString>::ConstIterator end = m_sourcePaths.end();
+    for (it = m_sourcePaths.begin(); it != end; ++it) {
+        sourceNames.insert((*it).mid((*it).findRev('/') + 1), true);
+    }
+
+    for (it = m_sourcePaths.begin(); (it != end) && !isCancelled(); ++it) {
+        const QCString name((*it).mid((*it).findRev('/') + 1));
+        if (destNames.contains(name)) {
+            compare(*it, m_destDir, name, name, destNames, sourceNames);
+        }
+    }
+}
+
+void ConflictScanJob::compare(const QCString& sourcePath,
+                              const QCString& destDir,
+                              const QCString& name,
+                              const QCString& relativePath,
+                              NameSet& destNames,
+                              const NameSet& sourceNames)
+{
+    QCString destPath(destDir);
+    destPath += '/';
+    destPath += name;
+
+    KDE_struct_stat sourceBuf;
+    KDE_struct_stat destBuf;
+    if ((KDE_lstat(sourcePath, &sourceBuf) != 0) || (KDE_lstat(destPath, &destBuf) != 0)) {
+        // the item has been removed in the meantime
+        return;
+    }
+
+    const bool sourceIsDir = S_ISDIR(sourceBuf.st_mode);
+    const bool destIsDir = S_ISDIR(destBuf.st_mode);
+    if (sourceIsDir && destIsDir) {
+        if (relativePath == name) {
+            m_mergedFolders.append(name);
+        }
+
+        // merge the folders by comparing their items
+        NameSet childDestNames;
+        readNames(destPath, childDestNames);
+        if (childDestNames.isEmpty()) {
+            return;
+        }
+
+        NameSet childSourceNames;
+        readNames(sourcePath, childSourceNames);
+
+        NameSet::ConstIterator it = childSourceNames.begin();
+        const NameSet::ConstIterator end = childSourceNames.end();
+        while ((it != end) && !isCancelled()) {
+            const QCString& childName = it.key();
+            if (childDestNames.contains(childName)) {
+                QCString childSourcePath(sourcePath);
+                childSourcePath += '/';
+                childSourcePath += childName;
+                QCString childRelativePath(relativePath);
+                childRelativePath += '/';
+                childRelativePath += childName;
+                compare(childSourcePath, destPath, childName, childRelativePath,
+                        childDestNames, childSourceNames);
+            }
+            ++it;
+        }
+        return;
+    }
+
+    Conflict conflict;
+    conflict.path = relativePath;
+    conflict.suggestedName = suggestName(name, destNames, sourceNames);
+    destNames.insert(conflict.suggestedName, true);
+    conflict.sourceIsDir = sourceIsDir;
+    conflict.destIsDir = destIsDir;
+    conflict.sourceSize = sourceBuf.st_size;
+    conflict.destSize = destBuf.st_size;
+    conflict.sourceMTime = sourceBuf.st_mtime;
+    conflict.destMTime = destBuf.st_mtime;
+    m_conflicts.append(conflict);
+}
+
+void ConflictScanJob::readNames(const QCString& path, NameSet& names)
+{
+    DIR* dir = ::opendir(path);
+    if (dir == 0) {
+        return;
+    }
+
+    KDE_struct_dirent* dirEntry = 0;
+    while ((dirEntry = KDE_readdir(dir)) != 0) {
+        const char* name = dirEntry->d_name;
+        if ((qstrcmp(name, ".") != 0) && (qstrcmp(name, "..") != 0)) {
+            names.insert(QCString(name), true);
+        }
+    }
+    ::closedir(dir);
+}
+
+QCString ConflictScanJob::suggestName(const QCString& name,
+                                      const NameSet& destNames,
+                                      const NameSet& sourceNames)
+{
+    // Like KIO::RenameDlg a number is appended to the base name: 'image.png'
+    // gets 'image_1.png', 'image_1.png' gets 'image_2.png'.
+    QCString baseName(name);
+    QCString suffix;
+    const int dotIndex = name.find('.', 1);
+    if (dotIndex > 0) {
+        baseName = name.left(dotIndex);
+        suffix = name.mid(dotIndex);
+    }
+
+    int number = 1;
+    const int underscoreIndex = baseName.findRev('_');
+    if (underscoreIndex >= 0) {
+        bool ok = false;
+        const int oldNumber = baseName.mid(underscoreIndex + 1).toInt(&ok);
+        if (ok) {
+            baseName.truncate(underscoreIndex);
+            number = oldNumber + 1;
+        }
+    }
+
+    QCString newName;
+    do {
+        newName = baseName + '_' + QCString().setNum(number) + suffix;
+        ++number;
+    } while (destNames.contains(newName) || sourceNames.contains(newName));
+
+    return newName;
+}
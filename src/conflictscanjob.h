@@ -0,0 +1,131 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef CONFLICTSCANJOB_H
+#define CONFLICTSCANJOB_H
+
+#include <qcstring.h>
+#include <qmap.h>
+#include <qvaluevector.h>
+
+#include <kio/global.h>
+
+#include "workerpool.h"
+
+/** Describes how an item, which already exists inside the destination, is handled. */
+struct ConflictResolution
+{
+    enum Action
+    {
+        Overwrite,
+        Skip,
+        Rename
+    };
+
+    Action action;
+
+    /** New name of the item inside the destination, if the action is Rename. */
+    QCString newName;
+};
+
+/** Maps the path of an item relative to the destination folder to its resolution. */
+typedef QMap<QCString, ConflictResolution> ConflictResolutions;
+
+/**
+ * @brief Finds all conflicts of a copy or move operation before it is started.
+ *
+ * KIO::copy() and KIO::move() ask the user what should be done each time
+ * an existing item is reached, so that a large transfer waits until the
+ * user answers. The conflict scan job is executed by the WorkerPool before
+ * a local transfer is started and compares the source items with the items
+ * of the destination folder. Folders, which exist in the source and in the
+ * destination, are merged: only their items are compared. The found
+ * conflicts are presented at once by the ConflictDialog, which returns
+ * a ConflictResolution for each conflict. The resolutions are applied by
+ * LocalCopyJob and LocalMoveJob without asking the user again.
+ */
+class ConflictScanJob : public WorkerJob
+{
+public:
+    /** Describes an item, which exists in the source and in the destination. */
+    struct Conflict
+    {
+        /** Path relative to the destination folder. */
+        QCString path;
+
+        /** Name, which is neither used inside the destination nor inside the source folder. */
+        QCString suggestedName;
+
+        bool sourceIsDir;
+        bool destIsDir;
+        KIO::filesize_t sourceSize;
+        KIO::filesize_t destSize;
+        time_t sourceMTime;
+        time_t destMTime;
+    };
+
+    /**
+     * Compares the items \a sourcePaths, which are given by absolute
+     * paths, with the items of the folder \a destDir.
+     */
+    ConflictScanJob(const QValueVector<QCString>& sourcePaths, const QCString& destDir);
+    virtual ~ConflictScanJob();
+
+    /** Returns the found conflicts in the order of the source items. */
+    const QValueVector<Conflict>& conflicts() const { return m_conflicts; }
+
+    /**
+     * Returns the names of the source folders, which are merged with an
+     * existing folder of the destination folder.
+     */
+    const QValueVector<QCString>& mergedFolders() const { return m_mergedFolders; }
+
+protected:
+    virtual void run();
+
+private:
+    typedef QMap<QCString, bool> NameSet;
+
+    /**
+     * Compares the item \a sourcePath with the item \a name of the folder
+     * \a destDir. \a destNames contains the names of the items inside
+     * \a destDir, \a sourceNames the names of the items, which are
+     * copied into \a destDir. Suggested names are added to \a destNames.
+     */
+    void compare(const QCString& sourcePath,
+                 const QCString& destDir,
+                 const QCString& name,
+                 const QCString& relativePath,
+                 NameSet& destNames,
+                 const NameSet& sourceNames);
+
+    /** Adds the names of the items of the folder \a path to \a names. */
+    void readNames(const QCString& path, NameSet& names);
+
+    /** Returns a name based on \a name, which is not contained in \a destNames and \a sourceNames. */
+    static QCString suggestName(const QCString& name, const NameSet& destNames, const NameSet& sourceNames);
+
+    QValueVector<QCString> m_sourcePaths;
+    QCString m_destDir;
+    QValueVector<Conflict> m_conflicts;
+    QValueVector<QCString> m_mergedFolders;
+};
+
+#endif
@@ -42,6 +42,11 @@ DetailsViewSettingsPage::DetailsViewSettingsPage(QWidget *parent) :
     m_permissionsBox(0),
     m_ownerBox(0),
     m_groupBox(0),
+    m_itemsBox(0),
+    m_dimensionsBox(0),
+    m_durationBox(0),
+    m_pagesBox(0),
+    m_folderSizesBox(0),
     m_smallIconSize(0),
     m_mediumIconSize(0),
     m_largeIconSize(0)
@@ -74,6 +79,23 @@ DetailsViewSettingsPage::DetailsViewSettingsPage(QWidget *parent) :
     m_groupBox = new QCheckBox(i18n("Group"), visibleColumnsLayout);
     m_groupBox->setChecked(settings->isColumnEnabled(DolphinDetailsView::GroupColumn));
 
+    m_itemsBox = new QCheckBox(i18n("Items"), visibleColumnsLayout);
+    m_itemsBox->setChecked(settings->isColumnEnabled(DolphinDetailsView::ItemsColumn));
+
+    // the meta information columns are filled in the background
+    QHBox* metaInfoColumnsLayout = new QHBox(columnsGroup);
+    m_dimensionsBox = new QCheckBox(i18n("Dimensions"), metaInfoColumnsLayout);
+    m_dimensionsBox->setChecked(settings->isColumnEnabled(DolphinDetailsView::DimensionsColumn));
+
+    m_durationBox = new QCheckBox(i18n("Duration"), metaInfoColumnsLayout);
+    m_durationBox->setChecked(settings->isColumnEnabled(DolphinDetailsView::DurationColumn));
+
+    m_pagesBox = new QCheckBox(i18n("Pages"), metaInfoColumnsLayout);
+    m_pagesBox->setChecked(settings->isColumnEnabled(DolphinDetailsView::PagesColumn));
+
+    m_folderSizesBox = new QCheckBox(i18n("Calculate folder sizes"), columnsGroup);
+    m_folderSizesBox->setChecked(settings->isFolderSizesEnabled());
+
     // Create "Icon" properties
     QButtonGroup* iconSizeGroup = new QButtonGroup(3, Qt::Horizontal, i18n("Icon Size"), this);
     iconSizeGroup->setSizePolicy(sizePolicy);
@@ -138,6 +160,15 @@ void DetailsViewSettingsPage::applySettings()
                                m_ownerBox->isChecked());
     settings->setColumnEnabled(DolphinDetailsView::GroupColumn,
                                m_groupBox->isChecked());
+    settings->setColumnEnabled(DolphinDetailsView::ItemsColumn,
+                               m_itemsBox->isChecked());
+    settings->setColumnEnabled(DolphinDetailsView::DimensionsColumn,
+                               m_dimensionsBox->isChecked());
+    settings->setColumnEnabled(DolphinDetailsView::DurationColumn,
+                               m_durationBox->isChecked());
+    settings->setColumnEnabled(DolphinDetailsView::PagesColumn,
+                               m_pagesBox->isChecked());
+    settings->setFolderSizesEnabled(m_folderSizesBox->isChecked());
 
     int iconSize = KIcon::SizeSmall;
     if (m_mediumIconSize->isChecked()) {
@@ -54,6 +54,11 @@ private:
     QCheckBox* m_permissionsBox;
     QCheckBox* m_ownerBox;
     QCheckBox* m_groupBox;
+    QCheckBox* m_itemsBox;
+    QCheckBox* m_dimensionsBox;
+    QCheckBox* m_durationBox;
+    QCheckBox* m_pagesBox;
+    QCheckBox* m_folderSizesBox;
     QRadioButton* m_smallIconSize;
     QRadioButton* m_mediumIconSize;
     QRadioButton* m_largeIconSize;
@@ -0,0 +1,96 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "dirlisterpool.h"
+
+#include <kurl.h>
+#include <assert.h>
+
+#include "dolphin.h"
+#include "dolphindirlister.h"
+
+DirListerPool& DirListerPool::instance()
+{
+    static DirListerPool* instance = 0;
+    if (instance == 0) {
+        instance = new DirListerPool();
+    }
+    return *instance;
+}
+
+DolphinDirLister* DirListerPool::acquire(const KURL& url)
+{
+    const QString urlKey(key(url));
+    QMap<QString, Entry>::Iterator it = m_entries.find(urlKey);
+    if (it != m_entries.end()) {
+        ++it.data().refCount;
+        return it.data().lister;
+    }
+
+    DolphinDirLister* lister = new DolphinDirLister();
+    lister->setAutoUpdate(true);
+    lister->setMainWindow(&Dolphin::mainWin());
+    // The hidden files are always listed and filtered by the views. This
+    // allows to toggle the hidden files without listing the directory again.
+    lister->setShowingDotFiles(true);
+
+    Entry entry;
+    entry.lister = lister;
+    entry.refCount = 1;
+    m_entries.insert(urlKey, entry);
+
+    return lister;
+}
+
+void DirListerPool::release(DolphinDirLister* lister)
+{
+    QMap<QString, Entry>::Iterator it = m_entries.begin();
+    while (it != m_entries.end()) {
+        if (it.data().lister == lister) {
+            assert(it.data().refCount > 0);
+            --it.data().refCount;
+            if (it.data().refCount == 0) {
+                m_entries.remove(it);
+
+                // The lister might currently emit a signal, which
+                // resulted in releasing it. Hence it is deleted later.
+                lister->stop();
+                lister->deleteLater();
+            }
+            return;
+        }
+        ++it;
+    }
+
+    assert(false);  // the lister has not been acquired from the pool
+}
+
+DirListerPool::DirListerPool()
+{
+}
+
+DirListerPool::~DirListerPool()
+{
+}
+
+QString DirListerPool::key(const KURL& url)
+{
+    return url.url(-1);
+}
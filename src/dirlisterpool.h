@@ -0,0 +1,92 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef DIRLISTERPOOL_H
+#define DIRLISTERPOOL_H
+
+#include <qmap.h>
+#include <qstring.h>
+
+class KURL;
+class DolphinDirLister;
+
+/**
+ * @brief Shares the dir listers between views showing the same directory.
+ *
+ * If both views of a split view show the same directory, each view had its
+ * own dir lister, which listed and watched the directory a second time.
+ * The pool hands out one reference counted dir lister per URL, so that all
+ * views showing the URL are informed by the same lister about new, changed
+ * and deleted items. The items are owned by the lister and shared between
+ * the views. Sorting, filtering and the selection are applied by each view
+ * independently.
+ *
+ * A dir lister of the pool is only used for one URL. It shows the hidden
+ * files and has no name filter, as both are applied by the views.
+ *
+ * Sample code:
+ * \code
+ * DirListerPool& pool = DirListerPool::instance();
+ * DolphinDirLister* lister = pool.acquire(url);
+ * if (lister->url().isEmpty()) {
+ *     // the directory is not listed yet by another view
+ *     lister->openURL(url);
+ * }
+ * ...
+ * pool.release(lister);
+ * \endcode
+ */
+class DirListerPool
+{
+public:
+    static DirListerPool& instance();
+
+    /**
+     * Returns the dir lister for the URL \a url and increases its reference
+     * count. If no lister is available for the URL yet, a new lister is
+     * created, which has not opened the URL.
+     */
+    DolphinDirLister* acquire(const KURL& url);
+
+    /**
+     * Decreases the reference count of the lister \a lister, which has been
+     * returned by DirListerPool::acquire(). The lister gets deleted as soon
+     * as it is not used anymore.
+     */
+    void release(DolphinDirLister* lister);
+
+protected:
+    DirListerPool();
+    virtual ~DirListerPool();
+
+private:
+    struct Entry
+    {
+        DolphinDirLister* lister;
+        int refCount;
+    };
+
+    /** Returns the key of \a url inside m_entries. */
+    static QString key(const KURL& url);
+
+    QMap<QString, Entry> m_entries;
+};
+
+#endif
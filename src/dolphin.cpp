@@ -51,9 +51,12 @@
 #include <kservice.h>
 #include <kstandarddirs.h>
 #include <krun.h>
+#include <konq_operations.h>
 
 #include <qclipboard.h>
+#include <qdir.h>
 #include <qdragobject.h>
+#include <qtimer.h>
 
 #include "urlnavigator.h"
 #include "viewpropertiesdialog.h"
@@ -66,6 +69,9 @@
 #include "dolphinsettings.h"
 #include "sidebars.h"
 #include "sidebarssettings.h"
+#include "localdeletejob.h"
+#include "verificationlog.h"
+#include "transferscheduler.h"
 
 
 Dolphin& Dolphin::mainWin()
@@ -101,6 +107,33 @@ void Dolphin::setActiveView(DolphinView* view)
     emit activeViewChanged();
 }
 
+void Dolphin::emptyTrash()
+{
+    const QString text(i18n("Do you really want to empty the Deleted Items Folder? "
+                            "All items will be deleted."));
+    const bool empty = KMessageBox::warningContinueCancel(this,
+                                                          text,
+                                                          QString::null,
+                                                          KGuiItem(i18n("Empty"), SmallIcon("trashcan_empty"))
+                                                         ) == KMessageBox::Continue;
+    if (!empty) {
+        return;
+    }
+
+    // Only the files of the local trash folder are deleted by the LocalDeleteJob.
+    // The trash I/O slave deletes the info files and the trash folders on other
+    // devices afterwards and updates the state of the trash.
+    const QString filesPath(KGlobal::dirs()->localxdgdatadir() + "Trash/files");
+    if (!QDir(filesPath).exists()) {
+        KonqOperations::emptyTrash();
+        return;
+    }
+
+    KIO::Job* job = new LocalDeleteJob(KURL::List(KURL::fromPathOrURL(filesPath)), true);
+    connect(job, SIGNAL(result(KIO::Job*)),
+            this, SLOT(slotTrashEmptied(KIO::Job*)));
+}
+
 void Dolphin::dropURLs(const KURL::List& urls,
                        const KURL& destination)
 {
@@ -174,23 +207,31 @@ void Dolphin::refreshViews()
     DolphinSettings& settings = DolphinSettings::instance();
     KURL url;
     for (int i = PrimaryIdx; i <= SecondaryIdx; ++i) {
-       if (m_view[i] != 0) {
+        if (m_view[i] != 0) {
             url = m_view[i]->url();
-
-            // delete view instance...
-            m_view[i]->close();
-            m_view[i]->deleteLater();
-            m_view[i] = 0;
         }
 
         if (split || (i == PrimaryIdx)) {
-            // ... and recreate it
             ViewProperties props(url);
-            m_view[i] = new DolphinView(m_splitter,
-                                        url,
-                                        props.viewMode(),
-                                        props.isShowHiddenFilesEnabled());
-            m_view[i]->show();
+            if (m_view[i] == 0) {
+                m_view[i] = new DolphinView(m_splitter,
+                                            url,
+                                            props.viewMode(),
+                                            props.isShowHiddenFilesEnabled());
+                m_view[i]->show();
+            }
+            else {
+                // Apply the settings to the existing view, so that
+                // the directory does not need to be listed again.
+                m_view[i]->setMode(props.viewMode());
+                m_view[i]->setShowHiddenFilesEnabled(props.isShowHiddenFilesEnabled());
+                m_view[i]->refreshSettings();
+            }
+        }
+        else if (m_view[i] != 0) {
+            m_view[i]->close();
+            m_view[i]->deleteLater();
+            m_view[i] = 0;
         }
 
         rightSidebarSettings* rightsidebarSettings = settings.rightsidebar();
@@ -237,6 +278,13 @@ void Dolphin::slotShowHiddenFilesChanged()
     showHiddenFilesAction->setChecked(m_activeView->isShowHiddenFilesEnabled());
 }
 
+void Dolphin::slotFlatViewChanged()
+{
+    KToggleAction* flatViewAction =
+        static_cast<KToggleAction*>(actionCollection()->action("flat_view"));
+    flatViewAction->setChecked(m_activeView->isFlatViewEnabled());
+}
+
 void Dolphin::slotShowFilterBarChanged()
 {
     KToggleAction* showFilterBarAction =
@@ -276,12 +324,17 @@ void Dolphin::slotSortOrderChanged(Qt::SortOrder order)
 
 void Dolphin::slotSelectionChanged()
 {
+    // The selection histograms are already up to date, as they are updated by
+    // the views for each item, where the selection state has been changed. The
+    // status bar, the actions and the sidebars can read the selection totals
+    // without iterating the selection.
+    assert(m_view[PrimaryIdx] != 0);
+
     updateEditActions();
 
-    assert(m_view[PrimaryIdx] != 0);
-    int selectedURLsCount = m_view[PrimaryIdx]->selectedURLs().count();
+    int selectedURLsCount = m_view[PrimaryIdx]->selectionHistogram().itemCount();
     if (m_view[SecondaryIdx] != 0) {
-        selectedURLsCount += m_view[SecondaryIdx]->selectedURLs().count();
+        selectedURLsCount += m_view[SecondaryIdx]->selectionHistogram().itemCount();
     }
 
     KAction* compareFilesAction = actionCollection()->action("compare_files");
@@ -552,7 +605,13 @@ void Dolphin::deleteItems()
                                                         KGuiItem(i18n("Delete"), SmallIcon("editdelete"))
                                                        ) == KMessageBox::Continue;
     if (del) {
-        KIO::Job* job = KIO::del(list);
+        KIO::Job* job = 0;
+        if (LocalDeleteJob::canDelete(list)) {
+            job = new LocalDeleteJob(list);
+        }
+        else {
+            job = KIO::del(list);
+        }
         connect(job, SIGNAL(result(KIO::Job*)),
                 this, SLOT(slotHandleJobError(KIO::Job*)));
         connect(job, SIGNAL(result(KIO::Job*)),
@@ -605,6 +664,12 @@ void Dolphin::slotDeleteFileFinished(KIO::Job* job)
     }
 }
 
+void Dolphin::slotTrashEmptied(KIO::Job* job)
+{
+    slotHandleJobError(job);
+    KonqOperations::emptyTrash();
+}
+
 void Dolphin::slotUndoAvailable(bool available)
 {
     KAction* undoAction = actionCollection()->action(KStdAction::stdName(KStdAction::Undo));
@@ -754,6 +819,21 @@ void Dolphin::invertSelection()
     clearStatusBar();
     m_activeView->invertSelection();
 }
+
+void Dolphin::selectItems()
+{
+    clearStatusBar();
+
+    bool ok = false;
+    const QString pattern = KInputDialog::getText(i18n("Select Items"),
+                                                  i18n("Select all items matching this pattern:"),
+                                                  "*",
+                                                  &ok,
+                                                  this);
+    if (ok && !pattern.isEmpty()) {
+        m_activeView->selectItems(pattern);
+    }
+}
 void Dolphin::setIconsView()
 {
     m_activeView->setMode(DolphinView::IconsView);
@@ -857,6 +937,15 @@ void Dolphin::showHiddenFiles()
     m_activeView->setShowHiddenFilesEnabled(show);
 }
 
+void Dolphin::toggleFlatView()
+{
+    clearStatusBar();
+
+    const KToggleAction* flatViewAction =
+        static_cast<KToggleAction*>(actionCollection()->action("flat_view"));
+    m_activeView->setFlatViewEnabled(flatViewAction->isChecked());
+}
+
 void Dolphin::showFilterBar()
 {
     const KToggleAction* showFilterBarAction =
@@ -1047,8 +1136,10 @@ void Dolphin::addUndoOperation(KIO::Job* job)
             DolphinStatusBar* statusBar = m_activeView->statusBar();
             switch (command.type()) {
                 case DolphinCommand::Copy:
-                    statusBar->setMessage(i18n("Copy operation completed."),
-                                          DolphinStatusBar::OperationCompleted);
+                    if (!updateVerificationLog(job, command)) {
+                        statusBar->setMessage(i18n("Copy operation completed."),
+                                              DolphinStatusBar::OperationCompleted);
+                    }
                     break;
                 case DolphinCommand::Move:
                     statusBar->setMessage(i18n("Move operation completed."),
@@ -1150,6 +1241,12 @@ void Dolphin::init()
     updatePasteAction();
     updateGoActions();
 
+    connect(&TransferScheduler::instance(), SIGNAL(transferStarted(KIO::Job*, const DolphinCommand&)),
+            this, SLOT(slotTransferStarted(KIO::Job*, const DolphinCommand&)));
+
+    // offer to resume the transfers, which have been interrupted by closing Dolphin
+    QTimer::singleShot(0, &TransferScheduler::instance(), SLOT(resumeInterruptedTransfers()));
+
     setupCreateNewMenuActions();
 
     loadSettings();
@@ -1231,6 +1328,10 @@ void Dolphin::setupActions()
                 this, SLOT(invertSelection()),
                 actionCollection(), "invert_selection");
 
+    new KAction(i18n("Select Items..."), "Ctrl+Shift+S",
+                this, SLOT(selectItems()),
+                actionCollection(), "select_items");
+
     // setup 'View' menu
     KStdAction::zoomIn(this,
                        SLOT(zoomIn()),
@@ -1280,6 +1381,10 @@ void Dolphin::setupActions()
                       this, SLOT(showHiddenFiles()),
                       actionCollection(), "show_hidden_files");
 
+    new KToggleAction(i18n("Flat View"), 0,
+                      this, SLOT(toggleFlatView()),
+                      actionCollection(), "flat_view");
+
     KToggleAction* splitAction = new KToggleAction(i18n("Split View"), "F10",
                                                    this, SLOT(toggleSplitView()),
                                                    actionCollection(), "split_view");
@@ -1465,8 +1570,8 @@ void Dolphin::updateHistory()
 
 void Dolphin::updateEditActions()
 {
-    const KFileItemList* list = m_activeView->selectedItems();
-    if ((list == 0) || (*list).isEmpty()) {
+    const MimeTypeHistogram& histogram = m_activeView->selectionHistogram();
+    if (histogram.itemCount() == 0) {
         stateChanged("has_no_selection");
     }
     else {
@@ -1474,21 +1579,11 @@ void Dolphin::updateEditActions()
 
         KAction* renameAction = actionCollection()->action("rename");
         if (renameAction != 0) {
-            renameAction->setEnabled(list->count() >= 1);
+            renameAction->setEnabled(histogram.itemCount() >= 1);
         }
 
-        bool enableMoveToTrash = true;
-
-        KFileItemListIterator it(*list);
-        KFileItem* item = 0;
-        while ((item = it.current()) != 0) {
-            const KURL& url = item->url();
-            // only enable the 'Move to Trash' action for local files
-            if (!url.isLocalFile()) {
-                enableMoveToTrash = false;
-            }
-            ++it;
-        }
+        // only enable the 'Move to Trash' action for local files
+        const bool enableMoveToTrash = (histogram.nonLocalCount() == 0);
 
         KAction* moveToTrashAction = actionCollection()->action("move_to_trash");
         moveToTrashAction->setEnabled(enableMoveToTrash);
@@ -1539,6 +1634,10 @@ void Dolphin::updateViewActions()
         static_cast<KToggleAction*>(actionCollection()->action("show_hidden_files"));
     showHiddenFilesAction->setChecked(m_activeView->isShowHiddenFilesEnabled());
 
+    KToggleAction* flatViewAction =
+        static_cast<KToggleAction*>(actionCollection()->action("flat_view"));
+    flatViewAction->setChecked(m_activeView->isFlatViewEnabled());
+
     KToggleAction* splitAction = static_cast<KToggleAction*>(actionCollection()->action("split_view"));
     splitAction->setChecked(m_view[SecondaryIdx] != 0);
 
@@ -1581,30 +1680,95 @@ void Dolphin::updateViewProperties(const KURL::List& urls)
 
 void Dolphin::copyURLs(const KURL::List& source, const KURL& dest)
 {
-    KIO::Job* job = KIO::copy(source, dest);
-    addPendingUndoJob(job, DolphinCommand::Copy, source, dest);
+    // the job is created by the scheduler, see Dolphin::slotTransferStarted()
+    TransferScheduler::instance().enqueue(DolphinCommand(DolphinCommand::Copy, source, dest));
 }
 
 void Dolphin::moveURLs(const KURL::List& source, const KURL& dest)
 {
-    KIO::Job* job = KIO::move(source, dest);
-    addPendingUndoJob(job, DolphinCommand::Move, source, dest);
+    TransferScheduler::instance().enqueue(DolphinCommand(DolphinCommand::Move, source, dest));
+}
+
+void Dolphin::slotTransferStarted(KIO::Job* job, const DolphinCommand& command)
+{
+    // the command contains the names of the items, which are written by the job
+    addPendingUndoJob(job, command);
 }
 
 void Dolphin::addPendingUndoJob(KIO::Job* job,
                                 DolphinCommand::Type commandType,
                                 const KURL::List& source,
                                 const KURL& dest)
+{
+    addPendingUndoJob(job, DolphinCommand(commandType, source, dest));
+}
+
+void Dolphin::addPendingUndoJob(KIO::Job* job, const DolphinCommand& command)
 {
     connect(job, SIGNAL(result(KIO::Job*)),
             this, SLOT(addUndoOperation(KIO::Job*)));
 
     UndoInfo undoInfo;
     undoInfo.id = job->progressId();
-    undoInfo.command = DolphinCommand(commandType, source, dest);
+    undoInfo.command = command;
     m_pendingUndoJobs.append(undoInfo);
 }
 
+bool Dolphin::updateVerificationLog(KIO::Job* job, const DolphinCommand& command)
+{
+    const QMap<QString, QString> metaData = job->metaData();
+    if (!metaData.contains("verified")) {
+        return false;
+    }
+
+    KURL::List failedFiles;
+    QMap<QString, QString>::ConstIterator it = metaData.begin();
+    const QMap<QString, QString>::ConstIterator end = metaData.end();
+    while (it != end) {
+        if (it.key().startsWith("verifyFailed-")) {
+            failedFiles.append(KURL(it.data()));
+        }
+        ++it;
+    }
+
+    // Only the items, which have been written by the copy operation, are
+    // updated: skipped items are left out and renamed items use their new name.
+    KURL::List copiedItems;
+    const QStringList& destNames = command.destNames();
+    QStringList::ConstIterator nameIt = destNames.begin();
+    const KURL::List& source = command.source();
+    KURL::List::ConstIterator sourceIt = source.begin();
+    const KURL::List::ConstIterator sourceEnd = source.end();
+    while (sourceIt != sourceEnd) {
+        const QString name(destNames.isEmpty() ? (*sourceIt).fileName() : *nameIt++);
+        if (!name.isEmpty()) {
+            KURL destURL(command.destination());
+            destURL.addPath(name);
+            copiedItems.append(destURL);
+        }
+        ++sourceIt;
+    }
+    VerificationLog::instance().update(copiedItems, failedFiles);
+
+    DolphinStatusBar* statusBar = m_activeView->statusBar();
+    const int failedCount = failedFiles.count();
+    if (failedCount == 0) {
+        statusBar->setMessage(i18n("Copy operation completed, all files have been verified."),
+                              DolphinStatusBar::OperationCompleted);
+    }
+    else if (failedCount == 1) {
+        statusBar->setMessage(i18n("The copy of '%1' differs from its source.").arg(failedFiles.first().path()),
+                              DolphinStatusBar::Error);
+    }
+    else {
+        statusBar->setMessage(i18n("The copies of %1 files differ from their sources, e. g. '%2'.")
+                                  .arg(failedCount).arg(failedFiles.first().path()),
+                              DolphinStatusBar::Error);
+    }
+
+    return true;
+}
+
 void Dolphin::clearStatusBar()
 {
     m_activeView->statusBar()->clear();
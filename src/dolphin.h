@@ -112,11 +112,19 @@ public:
     //const QPtrList<KAction>& linkToDeviceActions() const { return m_linkToDeviceActions; }
 
     /**
-     * Refreshs the views of the main window by recreating them dependent from
-     * the given Dolphin settings.
+     * Refreshs the views of the main window dependent from the given Dolphin
+     * settings. Existing views are updated in place without listing their
+     * directories again.
      */
     void refreshViews();
 
+    /**
+     * Empties the trash after a confirmation of the user. The files of
+     * the local trash folder are deleted by a LocalDeleteJob, the remaining
+     * items are deleted by the trash I/O slave.
+     */
+    void emptyTrash();
+
 signals:
     /**
      * Is send if the active view has been changed in
@@ -154,6 +162,9 @@ public slots:
     /** Updates the state of the 'Show hidden files' menu action. */
     void slotShowHiddenFilesChanged();
 
+    /** Updates the state of the 'Flat View' menu action. */
+    void slotFlatViewChanged();
+
     /** Updates the state of the 'Show filter bar' menu action. */
     void slotShowFilterBarChanged();
 
@@ -221,6 +232,12 @@ private slots:
      */
     void slotDeleteFileFinished(KIO::Job* job);
 
+    /**
+     * Lets the trash I/O slave finish the emptying of the trash after the
+     * files of the local trash folder have been deleted by the job \a job.
+     */
+    void slotTrashEmptied(KIO::Job* job);
+
     /**
      * Updates the state of the 'Undo' menu action dependent
      * from the parameter \a available.
@@ -267,6 +284,12 @@ private slots:
      */
     void invertSelection();
 
+    /**
+     * Asks the user for a wildcard pattern and adds all items of
+     * the active view matching to the pattern to the selection.
+     */
+    void selectItems();
+
     /** The current active view is switched to the icons mode. */
     void setIconsView();
 
@@ -307,6 +330,12 @@ private slots:
      */
     void showHiddenFiles();
 
+    /**
+     * Enables or disables the flat view of the active view dependent
+     * from the current state of the 'Flat View' menu toggle action.
+     */
+    void toggleFlatView();
+
     /**
      * Switches between showing and hiding of the filter bar dependent
      * from the current state of the 'Show Filter Bar' menu toggle action.
@@ -364,6 +393,13 @@ private slots:
      */
     void addUndoOperation(KIO::Job* job);
 
+    /**
+     * Registers the job \a job, which has been started by the
+     * TransferScheduler for the operation \a command, as pending
+     * undo job.
+     */
+    void slotTransferStarted(KIO::Job* job, const DolphinCommand& command);
+
 
     void toggleleftSidebar();
     void togglerightSidebar();
@@ -394,6 +430,16 @@ private:
                            DolphinCommand::Type commandType,
                            const KURL::List& source,
                            const KURL& dest);
+    void addPendingUndoJob(KIO::Job* job, const DolphinCommand& command);
+
+    /**
+     * Records the result of the verification of the copy operation \a command,
+     * which has been executed by the job \a job, in the VerificationLog and shows
+     * it in the status bar. False is returned, if the copied files have not
+     * been verified.
+     */
+    bool updateVerificationLog(KIO::Job* job, const DolphinCommand& command);
+
     void clearStatusBar();
     void openleftSidebar();
     void openrightSidebar();
@@ -42,6 +42,9 @@
 #include "dolphinview.h"
 #include "editbookmarkdialog.h"
 #include "dolphinsettings.h"
+#include "servicemenuindex.h"
+#include "mimetypehistogram.h"
+#include "openwithcache.h"
 
 
 DolphinContextMenu::DolphinContextMenu(DolphinView* parent,
@@ -155,7 +158,7 @@ void DolphinContextMenu::openViewportContextMenu()
 
     int id = popup->exec(m_pos);
     if (id == emptyID) {
-        KonqOperations::emptyTrash();
+        dolphin.emptyTrash();
     }
     else if (id == propertiesID) {
         new KPropertiesDialog(dolphin.activeView()->url());
@@ -289,41 +292,25 @@ int DolphinContextMenu::insertOpenWithItems(KPopupMenu* popup,
     // are listed which are registered to open the item. As last entry "Other..." will be
     // attached which allows to select a custom application. If no applications are registered
     // no sub menu is created at all, only "Open With..." will be offered.
-    const KFileItemList* list = m_dolphinView->selectedItems();
-    assert(list != 0);
-
-    bool insertOpenWithItems = true;
+    const MimeTypeHistogram& histogram = m_dolphinView->selectionHistogram();
     const QString contextMimeType(m_fileInfo->mimetype());
-    KFileItemListIterator mimeIt(*list);
-    KFileItem* item = 0;
-    while (insertOpenWithItems && ((item = mimeIt.current()) != 0)) {
-        insertOpenWithItems = (contextMimeType == item->mimetype());
-        ++mimeIt;
-    }
+    const bool insertOpenWithItems = (histogram.itemCount() == 0) ||
+                                     (histogram.commonMimeType() == contextMimeType);
 
     int openWithID = -1;
 
     if (insertOpenWithItems) {
         // fill the 'Open with' sub menu with application types
-        const KMimeType::Ptr mimePtr = KMimeType::findByURL(m_fileInfo->url());
-        KTrader::OfferList offers = KTrader::self()->query(mimePtr->name(),
-                                                           "Type == 'Application'");
+        const QValueVector<OpenWithCache::Offer>& offers = OpenWithCache::instance().offers(contextMimeType);
         int index = openWithIDStart;
         if (offers.count() > 0) {
-            KTrader::OfferList::Iterator it;
             KPopupMenu* openWithMenu = new KPopupMenu();
-            for(it = offers.begin(); it != offers.end(); ++it) {
-                // The offer list from the KTrader returns duplicate
-                // application entries. Although this seems to be a configuration
-                // problem outside the scope of Dolphin, duplicated entries just
-                // will be skipped here.
-                const QString appName((*it)->name());
-                if (!containsEntry(openWithMenu, appName)) {
-                    openWithMenu->insertItem((*it)->pixmap(KIcon::Small),
-                                            appName, index);
-                    openWithVector.append(*it);
-                    ++index;
-                }
+            QValueVector<OpenWithCache::Offer>::ConstIterator it;
+            for (it = offers.begin(); it != offers.end(); ++it) {
+                // the cached offers don't contain duplicated applications
+                openWithMenu->insertItem((*it).icon, (*it).service->name(), index);
+                openWithVector.append((*it).service);
+                ++index;
             }
 
             openWithMenu->insertSeparator();
@@ -357,90 +344,36 @@ void DolphinContextMenu::insertActionItems(KPopupMenu* popup,
 
     int actionsIndex = 0;
 
-    QStringList dirs = KGlobal::dirs()->findDirs("data", "d3lphin/servicemenus/");
-
     KPopupMenu* menu = 0;
-    for (QStringList::ConstIterator dirIt = dirs.begin(); dirIt != dirs.end(); ++dirIt) {
-        QDir dir(*dirIt);
-        QStringList entries = dir.entryList("*.desktop", QDir::Files);
-
-        for (QStringList::ConstIterator entryIt = entries.begin(); entryIt != entries.end(); ++entryIt) {
-            KSimpleConfig cfg(*dirIt + *entryIt, true);
-            cfg.setDesktopGroup();
-            if ((cfg.hasKey("Actions") || cfg.hasKey("X-KDE-GetActionMenu")) && cfg.hasKey("ServiceTypes")) {
-                const QStringList types = cfg.readListEntry("ServiceTypes");
-                for (QStringList::ConstIterator it = types.begin(); it != types.end(); ++it) {
-                    // check whether the mime type is equal or whether the
-                    // mimegroup (e. g. image/*) is supported
-
-                    bool insert = false;
-                    if ((*it) == "all/allfiles") {
-                        // The service type is valid for all files, but not for directories.
-                        // Check whether the selected items only consist of files...
-                        const KFileItemList* list = m_dolphinView->selectedItems();
-                        assert(list != 0);
-
-                        KFileItemListIterator mimeIt(*list);
-                        KFileItem* item = 0;
-                        insert = true;
-                        while (insert && ((item = mimeIt.current()) != 0)) {
-                            insert = !item->isDir();
-                            ++mimeIt;
-                        }
-                    }
-
-                    if (!insert) {
-                        // Check whether the MIME types of all selected files match
-                        // to the mimetype of the service action. As soon as one MIME
-                        // type does not match, no service menu is shown at all.
-                        const KFileItemList* list = m_dolphinView->selectedItems();
-                        assert(list != 0);
-
-                        KFileItemListIterator mimeIt(*list);
-                        KFileItem* item = 0;
-                        insert = true;
-                        while (insert && ((item = mimeIt.current()) != 0)) {
-                            const QString mimeType((*mimeIt)->mimetype());
-                            const QString mimeGroup(mimeType.left(mimeType.find('/')));
-
-                            insert  = (*it == mimeType) ||
-                                      ((*it).right(1) == "*") &&
-                                      ((*it).left((*it).find('/')) == mimeGroup);
-                            ++mimeIt;
-                        }
-                    }
-
-                    if (insert) {
-                        menu = actionsMenu;
-
-                        const QString submenuName = cfg.readEntry( "X-KDE-Submenu" );
-                        if (!submenuName.isEmpty()) {
-                            menu = new KPopupMenu();
-                            actionsMenu->insertItem(submenuName, menu, submenuID);
-                        }
-
-                        QValueList<KDEDesktopMimeType::Service> userServices =
-                            KDEDesktopMimeType::userDefinedServices(*dirIt + *entryIt, true);
-
-                        QValueList<KDEDesktopMimeType::Service>::Iterator serviceIt;
-                        for (serviceIt = userServices.begin(); serviceIt != userServices.end(); ++serviceIt) {
-                            KDEDesktopMimeType::Service service = (*serviceIt);
-                            if (!service.m_strIcon.isEmpty()) {
-                                menu->insertItem(SmallIcon(service.m_strIcon),
-                                                 service.m_strName,
-                                                 actionsIDStart + actionsIndex);
-                            }
-                            else {
-                                menu->insertItem(service.m_strName,
-                                                 actionsIDStart + actionsIndex);
-                            }
-                            actionsVector.append(service);
-                            ++actionsIndex;
-                        }
-                    }
-                }
+    const MimeTypeHistogram& histogram = m_dolphinView->selectionHistogram();
+    const QValueList<ServiceMenuIndex::Menu> serviceMenus = ServiceMenuIndex::instance().menus(histogram);
+    QValueList<ServiceMenuIndex::Menu>::ConstIterator menuIt = serviceMenus.begin();
+    while (menuIt != serviceMenus.end()) {
+        menu = actionsMenu;
+
+        const QString& submenuName = (*menuIt).submenuName;
+        if (!submenuName.isEmpty()) {
+            menu = new KPopupMenu();
+            actionsMenu->insertItem(submenuName, menu, submenuID);
+        }
+
+        const QValueList<KDEDesktopMimeType::Service>& userServices = (*menuIt).services;
+        QValueList<KDEDesktopMimeType::Service>::ConstIterator serviceIt;
+        for (serviceIt = userServices.begin(); serviceIt != userServices.end(); ++serviceIt) {
+            const KDEDesktopMimeType::Service& service = (*serviceIt);
+            if (!service.m_strIcon.isEmpty()) {
+                menu->insertItem(SmallIcon(service.m_strIcon),
+                                 service.m_strName,
+                                 actionsIDStart + actionsIndex);
+            }
+            else {
+                menu->insertItem(service.m_strName,
+                                 actionsIDStart + actionsIndex);
             }
+            actionsVector.append(service);
+            ++actionsIndex;
         }
+        ++menuIt;
     }
 
     const int itemsCount = actionsMenu->count();
@@ -476,19 +409,3 @@ void DolphinContextMenu::insertActionItems(KPopupMenu* popup,
         popup->insertItem(i18n("Actions"), actionsMenu);
     }
 }
-
-bool DolphinContextMenu::containsEntry(const KPopupMenu* menu,
-                                       const QString& entryName) const
-{
-    assert(menu != 0);
-
-    const uint count = menu->count();
-    for (uint i = 0; i < count; ++i) {
-        const int id = menu->idAt(i);
-        if (menu->text(id) == entryName) {
-            return true;
-        }
-    }
-
-    return false;
-}
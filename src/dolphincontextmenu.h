@@ -97,13 +97,6 @@ private:
     void insertActionItems(KPopupMenu* popup,
                           QValueVector<KDEDesktopMimeType::Service>& actionsVector);
 
-    /**
-     * Returns true, if 'menu' contains already
-     * an entry with the name 'entryName'.
-     */
-    bool containsEntry(const KPopupMenu* menu,
-                       const QString& entryName) const;
-
     enum {
         restoreID       =   80,	
         emptyID         =   85,
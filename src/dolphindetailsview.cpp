@@ -27,6 +27,7 @@
 #include <qclipboard.h>
 #include <qpainter.h>
 #include <klocale.h>
+#include <kmimetype.h>
 #include <kglobalsettings.h>
 #include <qscrollbar.h>
 #include <qcursor.h>
@@ -40,18 +41,36 @@
 #include "dolphinsettings.h"
 #include "dolphinstatusbar.h"
 #include "dolphindetailsviewsettings.h"
+#include "foldersizeservice.h"
+#include "itemcountservice.h"
+#include "metainfoservice.h"
 
 DolphinDetailsView::DolphinDetailsView(DolphinView* parent) :
     KFileDetailView(parent, 0),
     m_dolphinView(parent),
+    m_iconSize(0),
     m_resizeTimer(0),
     m_scrollTimer(0),
+    m_visibleItemsTimer(0),
+    m_requestHiddenMetaInfo(false),
     m_rubber(0)
 {
     m_resizeTimer = new QTimer(this);
     connect(m_resizeTimer, SIGNAL(timeout()),
             this, SLOT(updateColumnsWidth()));
 
+    m_visibleItemsTimer = new QTimer(this);
+    connect(m_visibleItemsTimer, SIGNAL(timeout()),
+            this, SLOT(slotUpdateVisibleItems()));
+    connect(this, SIGNAL(contentsMoving(int, int)),
+            this, SLOT(scheduleVisibleItemsUpdate()));
+    connect(&FolderSizeService::instance(), SIGNAL(sizeAvailable(const QString&, KIO::filesize_t, bool)),
+            this, SLOT(slotFolderSizeAvailable(const QString&, KIO::filesize_t, bool)));
+    connect(&ItemCountService::instance(), SIGNAL(countAvailable(const QString&)),
+            this, SLOT(slotItemCountAvailable(const QString&)));
+    connect(&MetaInfoService::instance(), SIGNAL(metaInfoAvailable(const QString&)),
+            this, SLOT(slotMetaInfoAvailable(const QString&)));
+
     setAcceptDrops(true);
     setSelectionMode(KFile::Extended);
     setHScrollBarMode(QScrollView::AlwaysOff);
@@ -61,6 +80,17 @@ DolphinDetailsView::DolphinDetailsView(DolphinView* parent) :
         setColumnAlignment(i, Qt::AlignHCenter);
     }
 
+    // KFileDetailView provides no columns for the number of items inside
+    // a folder and for the meta information of files
+    addColumn(i18n("Items"));
+    setColumnAlignment(ItemsColumn, Qt::AlignRight);
+    addColumn(i18n("Dimensions"));
+    setColumnAlignment(DimensionsColumn, Qt::AlignHCenter);
+    addColumn(i18n("Duration"));
+    setColumnAlignment(DurationColumn, Qt::AlignRight);
+    addColumn(i18n("Pages"));
+    setColumnAlignment(PagesColumn, Qt::AlignRight);
+
     Dolphin& dolphin = Dolphin::mainWin();
 
     connect(this, SIGNAL(onItem(QListViewItem*)),
@@ -96,6 +126,8 @@ DolphinDetailsView::DolphinDetailsView(DolphinView* parent) :
 
 DolphinDetailsView::~DolphinDetailsView()
 {
+    ItemCountService::instance().cancelRequests(this);
+
     delete m_rubber;
     m_rubber = 0;
 }
@@ -119,12 +151,16 @@ void DolphinDetailsView::endItemUpdates()
     int index = 0;
     const QValueList<URLNavigator::HistoryElem> history = m_dolphinView->urlHistory(index);
     if (!history.isEmpty()) {
-        KFileView* fileView = static_cast<KFileView*>(this);
-        fileView->setCurrentItem(history[index].currentFileName());
+        KFileItem* fileItem = m_dolphinView->itemByName(history[index].currentFileName());
+        if (fileItem != 0) {
+            setCurrentItem(fileItem);
+        }
         setContentsPos(history[index].contentsX(), history[index].contentsY());
     }
 
     updateColumnsWidth();
+    m_requestHiddenMetaInfo = true;
+    scheduleVisibleItemsUpdate();
 }
 
 void DolphinDetailsView::insertItem(KFileItem* fileItem)
@@ -147,6 +183,16 @@ void DolphinDetailsView::insertItem(KFileItem* fileItem)
     }
 
     fileItem->setExtraData(this, item);
+
+    if (fileItem->isDir()) {
+        if (isFolderSizeShown()) {
+            updateFolderSizeText(item);
+        }
+        updateItemCountText(item);
+    }
+    else if (isMetaInfoShown()) {
+        updateMetaInfoText(item);
+    }
 }
 
 bool DolphinDetailsView::isOnFilename(const QListViewItem* item, const QPoint& pos) const
@@ -160,18 +206,45 @@ void DolphinDetailsView::refreshSettings()
     const DolphinDetailsViewSettings* settings = DolphinSettings::instance().detailsView();
     assert(settings != 0);
 
-    for (int i = DolphinDetailsView::GroupColumn; i >= DolphinDetailsView::NameColumn; --i) {
+    // Disabled columns are not removed but get a width of 0. This allows to
+    // enable them again without recreating the view and its items.
+    for (int i = DolphinDetailsView::NameColumn; i <= DolphinDetailsView::PagesColumn; ++i) {
+        setColumnWidthMode(i, QListView::Manual);
         if (!settings->isColumnEnabled(i)) {
-            removeColumn(i);
+            setColumnWidth(i, 0);
         }
     }
 
     QFont adjustedFont(font());
     adjustedFont.setFamily(settings->fontFamily());
     adjustedFont.setPointSize(settings->fontSize());
-    setFont(adjustedFont);
+    if (adjustedFont != font()) {
+        setFont(adjustedFont);
+    }
+
+    // Update the icons of the existing items. The pixmaps for a specific
+    // size are cached by the icon loader, so only the first item of each
+    // MIME type results in loading an icon.
+    const int iconSize = settings->iconSize();
+    if (iconSize != m_iconSize) {
+        m_iconSize = iconSize;
+        for (QListViewItem* item = firstChild(); item != 0; item = item->nextSibling()) {
+            KFileItem* fileItem = static_cast<KFileListViewItem*>(item)->fileInfo();
+            item->setPixmap(NameColumn, fileItem->pixmap(iconSize));
+        }
+    }
+
+    // the folder sizes, the items column and the meta information
+    // columns might have been enabled or disabled
+    for (QListViewItem* item = firstChild(); item != 0; item = item->nextSibling()) {
+        updateFolderSizeText(item);
+        updateItemCountText(item);
+        updateMetaInfoText(item);
+    }
+    m_requestHiddenMetaInfo = true;
+    scheduleVisibleItemsUpdate();
 
-    updateView(true);
+    updateColumnsWidth();
 }
 
 void DolphinDetailsView::zoomIn()
@@ -416,6 +489,28 @@ void DolphinDetailsView::contentsMouseMoveEvent(QMouseEvent* event)
     }
 }
 
+void DolphinDetailsView::keyPressEvent(QKeyEvent* event)
+{
+    // The type-ahead search of QListView compares each item with the typed
+    // text. Use the name index of the Dolphin view instead, which also stays
+    // fast for large directories.
+    const QString text(event->text());
+    const bool isModified = (event->state() & (ControlButton | AltButton)) != 0;
+    if (!isModified && !text.isEmpty() && text[0].isPrint() && !text[0].isSpace()) {
+        KFileItem* fileItem = m_dolphinView->typeAheadItem(text);
+        if (fileItem != 0) {
+            clearSelection();
+            setCurrentItem(fileItem);
+            setSelected(fileItem, true);
+            ensureItemVisible(fileItem);
+        }
+        event->accept();
+        return;
+    }
+
+    KFileDetailView::keyPressEvent(event);
+}
+
 void DolphinDetailsView::contentsMouseReleaseEvent(QMouseEvent* event)
 {
     if (m_rubber != 0) {
@@ -598,9 +693,17 @@ void DolphinDetailsView::slotAutoScroll()
 
 void DolphinDetailsView::updateColumnsWidth()
 {
+    const DolphinDetailsViewSettings* settings = DolphinSettings::instance().detailsView();
+    assert(settings != 0);
+
     const int columnCount = columns();
     int requiredWidth = 0;
     for (int i = 1; i < columnCount; ++i) {
+        if (!settings->isColumnEnabled(i)) {
+            setColumnWidth(i, 0);
+            continue;
+        }
+
         // When a directory contains no items, a minimum width for
         // the column must be available, so that the header is readable.
         // TODO: use header data instead of the hardcoded 64 value...
@@ -667,6 +770,228 @@ void DolphinDetailsView::slotHeaderClicked(int /* section */)
     }
 }
 
+void DolphinDetailsView::scheduleVisibleItemsUpdate()
+{
+    const DolphinDetailsViewSettings* settings = DolphinSettings::instance().detailsView();
+    if (isFolderSizeShown() || settings->isColumnEnabled(ItemsColumn) || isMetaInfoShown()) {
+        m_visibleItemsTimer->start(200, true);
+    }
+}
+
+void DolphinDetailsView::slotUpdateVisibleItems()
+{
+    const bool showFolderSizes = isFolderSizeShown();
+    const bool showItemCounts = DolphinSettings::instance().detailsView()->isColumnEnabled(ItemsColumn);
+    const bool showMetaInfo = isMetaInfoShown();
+
+    // The items of folders, which have been scrolled out of the view, don't need to be
+    // counted anymore. The requests for the still visible folders are renewed below.
+    ItemCountService& itemCounts = ItemCountService::instance();
+    itemCounts.cancelRequests(this);
+    if (!showFolderSizes && !showItemCounts && !showMetaInfo) {
+        return;
+    }
+
+    FolderSizeService& folderSizes = FolderSizeService::instance();
+    const int height = visibleHeight();
+    QListViewItem* item = itemAt(QPoint(0, 0));
+    while ((item != 0) && (itemRect(item).top() < height)) {
+        const KFileItem* fileItem = static_cast<KFileListViewItem*>(item)->fileInfo();
+        if (fileItem->isDir() && fileItem->url().isLocalFile()) {
+            const QString path(fileItem->url().path(-1));
+            if (showFolderSizes) {
+                // the requests are cancelled by the view if another directory is shown
+                folderSizes.requestSize(path, WorkerJob::MetaData, m_dolphinView);
+            }
+            if (showItemCounts) {
+                itemCounts.requestCount(path, fileItem->time(KIO::UDS_MODIFICATION_TIME), this);
+            }
+        }
+        else if (showMetaInfo) {
+            requestMetaInfo(item, WorkerJob::Preview);
+        }
+        item = item->itemBelow();
+    }
+
+    if (showMetaInfo && m_requestHiddenMetaInfo) {
+        // The meta information of the other items is read after the visible
+        // items, so that scrolling shows the information without delay. Requests
+        // for items, which are already requested, are ignored by the service.
+        m_requestHiddenMetaInfo = false;
+        for (item = firstChild(); item != 0; item = item->nextSibling()) {
+            requestMetaInfo(item, WorkerJob::MetaData);
+        }
+    }
+}
+
+void DolphinDetailsView::slotFolderSizeAvailable(const QString& path,
+                                                 KIO::filesize_t size,
+                                                 bool isComplete)
+{
+    if (!isFolderSizeShown()) {
+        return;
+    }
+
+    QListViewItem* item = itemByPath(path);
+    if (item != 0) {
+        // a size, which is still calculated, is marked by a trailing '+'
+        QString sizeText(KIO::convertSize(size));
+        sizeText.append(isComplete ? " " : "+ ");
+        item->setText(SizeColumn, sizeText);
+    }
+}
+
+void DolphinDetailsView::slotItemCountAvailable(const QString& path)
+{
+    QListViewItem* item = itemByPath(path);
+    if (item != 0) {
+        updateItemCountText(item);
+    }
+}
+
+void DolphinDetailsView::slotMetaInfoAvailable(const QString& path)
+{
+    QListViewItem* item = itemByPath(path);
+    if (item != 0) {
+        updateMetaInfoText(item);
+
+        // the meta information might require wider columns
+        if (!m_resizeTimer->isActive()) {
+            m_resizeTimer->start(500, true);
+        }
+    }
+}
+
+bool DolphinDetailsView::isFolderSizeShown() const
+{
+    const DolphinDetailsViewSettings* settings = DolphinSettings::instance().detailsView();
+    return settings->isFolderSizesEnabled() && settings->isColumnEnabled(SizeColumn);
+}
+
+void DolphinDetailsView::updateFolderSizeText(QListViewItem* item)
+{
+    const KFileItem* fileItem = static_cast<KFileListViewItem*>(item)->fileInfo();
+    if (!fileItem->isDir()) {
+        return;
+    }
+
+    QString sizeText(" - ");
+    KIO::filesize_t size = 0;
+    if (isFolderSizeShown() &&
+        fileItem->url().isLocalFile() &&
+        FolderSizeService::instance().folderSize(fileItem->url().path(-1), size)) {
+        sizeText = KIO::convertSize(size);
+        sizeText.append(" ");
+    }
+    item->setText(SizeColumn, sizeText);
+}
+
+void DolphinDetailsView::updateItemCountText(QListViewItem* item)
+{
+    const KFileItem* fileItem = static_cast<KFileListViewItem*>(item)->fileInfo();
+    if (!fileItem->isDir() || !fileItem->url().isLocalFile()) {
+        return;
+    }
+
+    QString countText;
+    uint count = 0;
+    if (DolphinSettings::instance().detailsView()->isColumnEnabled(ItemsColumn) &&
+        ItemCountService::instance().itemCount(fileItem->url().path(-1),
+                                               fileItem->time(KIO::UDS_MODIFICATION_TIME),
+                                               m_dolphinView->isShowHiddenFilesEnabled(),
+                                               count)) {
+        countText = QString::number(count);
+        countText.append(" ");
+    }
+    item->setText(ItemsColumn, countText);
+}
+
+bool DolphinDetailsView::isMetaInfoShown() const
+{
+    const DolphinDetailsViewSettings* settings = DolphinSettings::instance().detailsView();
+    return settings->isColumnEnabled(DimensionsColumn) ||
+           settings->isColumnEnabled(DurationColumn) ||
+           settings->isColumnEnabled(PagesColumn);
+}
+
+void DolphinDetailsView::updateMetaInfoText(QListViewItem* item)
+{
+    const KFileItem* fileItem = static_cast<KFileListViewItem*>(item)->fileInfo();
+    if (fileItem->isDir() || !fileItem->url().isLocalFile()) {
+        return;
+    }
+
+    const MetaInfoJob::Info* info = 0;
+    if (isMetaInfoShown()) {
+        info = MetaInfoService::instance().metaInfo(fileItem->url().path());
+        if ((info != 0) && (info->mtime != fileItem->time(KIO::UDS_MODIFICATION_TIME))) {
+            // the file has been modified since the meta information has been read
+            info = 0;
+        }
+    }
+
+    for (int column = DimensionsColumn; column <= PagesColumn; ++column) {
+        QString text;
+        if (info != 0) {
+            const int index = info->keys.findIndex(metaInfoKey(column));
+            if (index >= 0) {
+                text = info->values[index];
+            }
+        }
+        item->setText(column, text);
+    }
+}
+
+void DolphinDetailsView::requestMetaInfo(QListViewItem* item, WorkerJob::Priority priority)
+{
+    KFileItem* fileItem = static_cast<KFileListViewItem*>(item)->fileInfo();
+    if (fileItem->isDir() || !fileItem->url().isLocalFile()) {
+        return;
+    }
+
+    // KFileItem::mimetype() might read the content of the file to determine
+    // an unknown MIME type, which blocks the GUI thread for large directories.
+    // The MIME type, which is derived from the file name, is sufficient to
+    // choose the meta info plugin.
+    const QString mimeType(fileItem->isMimeTypeKnown() ?
+                           fileItem->mimetype() :
+                           KMimeType::findByURL(fileItem->url(), 0, true, true)->name());
+
+    // the requests are cancelled by the view if another directory is shown
+    MetaInfoService::instance().requestMetaInfo(fileItem->url().path(),
+                                                mimeType,
+                                                fileItem->time(KIO::UDS_MODIFICATION_TIME),
+                                                priority,
+                                                m_dolphinView);
+}
+
+const char* DolphinDetailsView::metaInfoKey(int column)
+{
+    switch (column) {
+        case DimensionsColumn: return "Dimensions";
+        case DurationColumn:   return "Length";
+        case PagesColumn:      return "Pages";
+        default: break;
+    }
+    return 0;
+}
+
+QListViewItem* DolphinDetailsView::itemByPath(const QString& path) const
+{
+    const KURL url(path);
+    const KURL& viewURL = m_dolphinView->url();
+    if (!viewURL.isLocalFile() || (url.directory() != viewURL.path(-1))) {
+        return 0;
+    }
+
+    KFileItem* fileItem = m_dolphinView->itemByName(url.fileName());
+    if (fileItem == 0) {
+        return 0;
+    }
+
+    return static_cast<QListViewItem*>(const_cast<void*>(fileItem->extraData(this)));
+}
+
 DolphinDetailsView::DolphinListViewItem::DolphinListViewItem(QListView* parent,
                                                              KFileItem* fileItem) :
     KFileListViewItem(parent, fileItem)
@@ -687,28 +1012,24 @@ DolphinDetailsView::DolphinListViewItem::DolphinListViewItem(QListView* parent,
         sizeText.append(" ");
         setText(SizeColumn, sizeText);
     }
-
-    // Dolphin allows to remove specific columns, but the base class KFileListViewItem
-    // is not aware about this (or at least the class KFileDetailView does not react on
-    // QListView::remove()). Therefore the columns are rearranged here.
-    const DolphinDetailsViewSettings* settings = DolphinSettings::instance().detailsView();
-    assert(settings != 0);
-
-    int column_idx = DateColumn;    // the columns for 'name' and 'size' cannot get removed
-    for (int i = DolphinDetailsView::DateColumn; i <= DolphinDetailsView::GroupColumn; ++i) {
-        if (column_idx < i) {
-            setText(column_idx, text(i));
-        }
-        if (settings->isColumnEnabled(i)) {
-            ++column_idx;
-        }
-    }
 }
 
 DolphinDetailsView::DolphinListViewItem::~DolphinListViewItem()
 {
 }
 
+void DolphinDetailsView::DolphinListViewItem::setSelected(bool select)
+{
+    // QListView emits the signal selectionChanged() after the item has been
+    // updated, hence the histogram is updated afterwards.
+    const bool wasSelected = isSelected();
+    KFileListViewItem::setSelected(select);
+    if (isSelected() != wasSelected) {
+        DolphinDetailsView* view = static_cast<DolphinDetailsView*>(listView());
+        view->m_dolphinView->updateSelection(fileInfo(), !wasSelected);
+    }
+}
+
 void DolphinDetailsView::DolphinListViewItem::paintCell(QPainter* painter,
                                                         const QColorGroup& colorGroup,
                                                         int column,
@@ -748,7 +1069,16 @@ void DolphinDetailsView::DolphinListViewItem::paintCell(QPainter* painter,
         }
     }
 
-    if (column < listView()->columns() - 1) {
+    // disabled columns have a width of 0 (see DolphinDetailsView::refreshSettings())
+    bool isLastColumn = true;
+    for (int i = column + 1; i < view->columns(); ++i) {
+        if (view->columnWidth(i) > 0) {
+            isLastColumn = false;
+            break;
+        }
+    }
+
+    if ((cellWidth > 0) && !isLastColumn) {
         // draw a separator between columns
         painter->setPen(KGlobalSettings::buttonBackground());
         painter->drawLine(cellWidth - 1, 0, cellWidth - 1, height() - 1);
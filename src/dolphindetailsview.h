@@ -23,6 +23,7 @@
 
 #include <kfiledetailview.h>
 #include <itemeffectsmanager.h>
+#include "workerpool.h"
 
 class QRect;
 class QTimer;
@@ -30,7 +31,10 @@ class DolphinView;
 
 /**
  * @brief Represents the details view which shows the name, size,
- * date, permissions, owner and group of an item.
+ * date, permissions, owner and group of an item. For folders
+ * optionally the number of contained items is shown. For files
+ * optionally the dimensions, the duration and the number of pages
+ * are shown, which are read by the MetaInfoService.
  *
  * The width of the columns are automatically adjusted in a way
  * that full available width of the view is used by stretching the width
@@ -53,7 +57,11 @@ public:
         DateColumn        = 2,
         PermissionsColumn = 3,
         OwnerColumn       = 4,
-        GroupColumn       = 5
+        GroupColumn       = 5,
+        ItemsColumn       = 6,
+        DimensionsColumn  = 7,
+        DurationColumn    = 8,
+        PagesColumn       = 9
     };
 
     DolphinDetailsView(DolphinView* parent);
@@ -77,7 +85,8 @@ public:
 
     /**
      * Reads out the dolphin settings for the details view and refreshs
-     * the details view.
+     * the details view. The columns, the font and the icon size are
+     * applied to the existing items.
      */
     // TODO: Other view implementations use a similar interface. When using
     // Interview in Qt4 this method should be moved to a base class (currently
@@ -148,6 +157,9 @@ protected:
     /** @see KFileDetailView::contentsMouseMoveEvent() */
     virtual void contentsMouseMoveEvent(QMouseEvent* event);
 
+    /** @see KFileDetailView::keyPressEvent() */
+    virtual void keyPressEvent(QKeyEvent* event);
+
     /** @see KFileDetailView::contentsMouseReleaseEvent() */
     virtual void contentsMouseReleaseEvent(QMouseEvent* event);
 
@@ -175,6 +187,37 @@ private slots:
                          const QString& name,
                          int column);
 
+    /**
+     * Requests the folder sizes and item counts for the visible
+     * items after a short delay.
+     */
+    void scheduleVisibleItemsUpdate();
+
+    /**
+     * Requests the calculation of the sizes of all visible local
+     * folders, if folder sizes are shown, and the number of items inside
+     * the visible local folders, if the items column is shown. Pending
+     * item counts of folders, which are not visible anymore, are cancelled.
+     * If meta information columns are shown, the meta information of the
+     * visible files is requested first and the meta information of all
+     * other files with a lower priority.
+     */
+    void slotUpdateVisibleItems();
+
+    /**
+     * Shows the size \a size of the folder \a path, if the folder is
+     * part of the view.
+     */
+    void slotFolderSizeAvailable(const QString& path,
+                                 KIO::filesize_t size,
+                                 bool isComplete);
+
+    /** Shows the number of items inside the folder \a path, if the folder is part of the view. */
+    void slotItemCountAvailable(const QString& path);
+
+    /** Shows the meta information of the file \a path, if the file is part of the view. */
+    void slotMetaInfoAvailable(const QString& path);
+
     /**
      * Is invoked when a section from the header has
      * been clicked and stores the sort column and sort
@@ -197,13 +240,73 @@ private:
         virtual void paintFocus(QPainter* painter,
                                 const QColorGroup& colorGroup,
                                 const QRect& rect);
+
+        /**
+         * Informs the Dolphin view about the changed selection state, so
+         * that the selection histogram can be updated for this item only.
+         */
+        virtual void setSelected(bool select);
     };
 
     DolphinView* m_dolphinView;
+    int m_iconSize;
     QTimer* m_resizeTimer;
     QTimer* m_scrollTimer;
+    QTimer* m_visibleItemsTimer;
+
+    /**
+     * Is true, if the meta information of the items, which are not
+     * visible, has not been requested yet for the shown directory.
+     */
+    bool m_requestHiddenMetaInfo;
     QRect* m_rubber;
 
+    /**
+     * Returns true, if the size column shows the sizes of the folders
+     * (see DolphinDetailsViewSettings::isFolderSizesEnabled()).
+     */
+    bool isFolderSizeShown() const;
+
+    /**
+     * Shows the cached folder size of the item \a item inside the size
+     * column. If no size is known or if no folder sizes are shown,
+     * " - " is shown for folders.
+     */
+    void updateFolderSizeText(QListViewItem* item);
+
+    /**
+     * Shows the cached number of items inside the folder of the item \a item
+     * inside the items column.
+     */
+    void updateItemCountText(QListViewItem* item);
+
+    /** Returns true, if at least one meta information column is shown. */
+    bool isMetaInfoShown() const;
+
+    /**
+     * Shows the cached meta information of the file of the item \a item
+     * inside the meta information columns.
+     */
+    void updateMetaInfoText(QListViewItem* item);
+
+    /**
+     * Requests the meta information of the file of the item \a item with
+     * the priority \a priority.
+     */
+    void requestMetaInfo(QListViewItem* item, WorkerJob::Priority priority);
+
+    /**
+     * Returns the key of the meta information, which is shown inside
+     * the column \a column.
+     */
+    static const char* metaInfoKey(int column);
+
+    /**
+     * Returns the item of the view, which represents the path \a path.
+     * 0 is returned if the path is not part of the shown directory.
+     */
+    QListViewItem* itemByPath(const QString& path) const;
+
     /**
      * Returns the width of the filename in pixels including
      * the icon. It is assured that the returned width is
@@ -25,6 +25,7 @@
 
 DolphinDetailsViewSettings::DolphinDetailsViewSettings() :
     m_columnEnabled(0),
+    m_folderSizesEnabled(false),
     m_iconSize(0),
     m_fontSize(0)
 {
@@ -38,6 +39,10 @@ DolphinDetailsViewSettings::DolphinDetailsViewSettings() :
     const bool showPermissions = config->readBoolEntry("Show Permissions", false);
     const bool showOwner = config->readBoolEntry("Show Owner", false);
     const bool showGroup = config->readBoolEntry("Show Group", false);
+    const bool showItems = config->readBoolEntry("Show Items", false);
+    const bool showDimensions = config->readBoolEntry("Show Dimensions", false);
+    const bool showDuration = config->readBoolEntry("Show Duration", false);
+    const bool showPages = config->readBoolEntry("Show Pages", false);
 
     setColumnEnabled(DolphinDetailsView::NameColumn, showName);
     setColumnEnabled(DolphinDetailsView::SizeColumn, showSize);
@@ -45,6 +50,12 @@ DolphinDetailsViewSettings::DolphinDetailsViewSettings() :
     setColumnEnabled(DolphinDetailsView::PermissionsColumn, showPermissions);
     setColumnEnabled(DolphinDetailsView::OwnerColumn, showOwner);
     setColumnEnabled(DolphinDetailsView::GroupColumn, showGroup);
+    setColumnEnabled(DolphinDetailsView::ItemsColumn, showItems);
+    setColumnEnabled(DolphinDetailsView::DimensionsColumn, showDimensions);
+    setColumnEnabled(DolphinDetailsView::DurationColumn, showDuration);
+    setColumnEnabled(DolphinDetailsView::PagesColumn, showPages);
+
+    m_folderSizesEnabled = config->readBoolEntry("Show Folder Sizes", false);
 
     // read icon size
     m_iconSize = config->readNumEntry("Icon Size", KIcon::SizeSmall);
@@ -102,6 +113,15 @@ void DolphinDetailsViewSettings::save()
                        isColumnEnabled(DolphinDetailsView::OwnerColumn));
     config->writeEntry("Show Group",
                        isColumnEnabled(DolphinDetailsView::GroupColumn));
+    config->writeEntry("Show Items",
+                       isColumnEnabled(DolphinDetailsView::ItemsColumn));
+    config->writeEntry("Show Dimensions",
+                       isColumnEnabled(DolphinDetailsView::DimensionsColumn));
+    config->writeEntry("Show Duration",
+                       isColumnEnabled(DolphinDetailsView::DurationColumn));
+    config->writeEntry("Show Pages",
+                       isColumnEnabled(DolphinDetailsView::PagesColumn));
+    config->writeEntry("Show Folder Sizes", m_folderSizesEnabled);
     config->writeEntry("Icon Size", m_iconSize);
     config->writeEntry("Font Size", m_fontSize);
     config->writeEntry("Font Family", m_fontFamily);
@@ -30,6 +30,7 @@
  *
  * The following properties are stored:
  * - enabled columns
+ * - calculation of the folder sizes for the size column
  * - sorted column
  * - sort order for the sorted column
  * - icon size
@@ -49,6 +50,13 @@ public:
     void setColumnEnabled(int column, bool enable);
     bool isColumnEnabled(int column) const;
 
+    /**
+     * If enabled, the size column shows the recursive size of the visible
+     * folders, which is calculated by the FolderSizeService.
+     */
+    void setFolderSizesEnabled(bool enabled) { m_folderSizesEnabled = enabled; }
+    bool isFolderSizesEnabled() const { return m_folderSizesEnabled; }
+
     void setIconSize(int size) { m_iconSize = size; }
     int iconSize() const { return m_iconSize; }
 
@@ -63,6 +71,7 @@ public:
 
 private:
     int m_columnEnabled;
+    bool m_folderSizesEnabled;
     int m_iconSize;
     int m_fontSize;
     QString m_fontFamily;
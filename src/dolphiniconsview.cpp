@@ -121,8 +121,10 @@ void DolphinIconsView::endItemUpdates()
     int index = 0;
     const QValueList<URLNavigator::HistoryElem> history = m_dolphinView->urlHistory(index);
     if (!history.isEmpty()) {
-        KFileView* fileView = static_cast<KFileView*>(this);
-        fileView->setCurrentItem(history[index].currentFileName());
+        KFileItem* fileItem = m_dolphinView->itemByName(history[index].currentFileName());
+        if (fileItem != 0) {
+            setCurrentItem(fileItem);
+        }
         setContentsPos(history[index].contentsX(), history[index].contentsY());
     }
 }
@@ -163,6 +165,8 @@ void DolphinIconsView::refreshSettings()
             setPreviewSize(size);
         }
     }
+
+    arrangeItemsInGrid();
 }
 
 void DolphinIconsView::zoomIn()
@@ -242,6 +246,20 @@ void DolphinIconsView::arrangeItemsInGrid( bool updated )
     }
 }
 
+void DolphinIconsView::insertItem(KFileItem* fileItem)
+{
+    KFileView::insertItem(fileItem);
+
+    // Creating an item results in a repaint, which is suppressed like
+    // in KFileIconView::insertItem(). The pixmap, the sorting key and the
+    // preview size are initialized by KFileIconView::updateView().
+    setUpdatesEnabled(false);
+    DolphinIconViewItem* item = new DolphinIconViewItem(this, fileItem);
+    fileItem->setExtraData(this, item);
+    updateView(fileItem);
+    setUpdatesEnabled(true);
+}
+
 void DolphinIconsView::setContextPixmap(void* context,
                                         const QPixmap& pixmap)
 {
@@ -277,6 +295,28 @@ void DolphinIconsView::contentsMousePressEvent(QMouseEvent* event)
     m_dolphinView->statusBar()->clear();
 }
 
+void DolphinIconsView::keyPressEvent(QKeyEvent* event)
+{
+    // The type-ahead search of QIconView compares each item with the typed
+    // text. Use the name index of the Dolphin view instead, which also stays
+    // fast for large directories.
+    const QString text(event->text());
+    const bool isModified = (event->state() & (ControlButton | AltButton)) != 0;
+    if (!isModified && !text.isEmpty() && text[0].isPrint() && !text[0].isSpace()) {
+        KFileItem* fileItem = m_dolphinView->typeAheadItem(text);
+        if (fileItem != 0) {
+            clearSelection();
+            setCurrentItem(fileItem);
+            setSelected(fileItem, true);
+            ensureItemVisible(fileItem);
+        }
+        event->accept();
+        return;
+    }
+
+    KFileIconView::keyPressEvent(event);
+}
+
 void DolphinIconsView::contentsMouseReleaseEvent(QMouseEvent* event)
 {
     KFileIconView::contentsMouseReleaseEvent(event);
@@ -497,4 +537,30 @@ int DolphinIconsView::decreasedIconSize(int size) const
     return decSize;
 }
 
+DolphinIconsView::DolphinIconViewItem::DolphinIconViewItem(QIconView* parent,
+                                                           KFileItem* fileItem) :
+    KFileIconViewItem(parent, fileItem)
+{
+}
+
+DolphinIconsView::DolphinIconViewItem::~DolphinIconViewItem()
+{
+}
+
+void DolphinIconsView::DolphinIconViewItem::setSelected(bool select, bool callback)
+{
+    // QIconViewItem::setSelected() emits the signal selectionChanged() of the
+    // view, hence the histogram must be updated before. The conditions
+    // match the ones of QIconViewItem::setSelected().
+    QIconView* view = iconView();
+    const bool changed = (view != 0) &&
+                         (view->selectionMode() != QIconView::NoSelection) &&
+                         isSelectable() &&
+                         (isSelected() != select);
+    if (changed) {
+        static_cast<DolphinIconsView*>(view)->m_dolphinView->updateSelection(fileInfo(), select);
+    }
+    KFileIconViewItem::setSelected(select, callback);
+}
+
 #include "dolphiniconsview.moc"
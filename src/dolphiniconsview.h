@@ -80,6 +80,9 @@ public:
     /** @see ItemEffectsManager::isZoomOutPossible() */
     virtual bool isZoomOutPossible() const;
 
+    /** @see KFileView::insertItem */
+    virtual void insertItem(KFileItem* fileItem);
+
 public slots:
     /**
      * Bypass a layout issue in KFileIconView in combination with previews.
@@ -114,6 +117,9 @@ protected:
     /** @see KFileIconView::contentsMousePressEvent */
     virtual void contentsMousePressEvent(QMouseEvent* event);
 
+    /** @see KFileIconView::keyPressEvent */
+    virtual void keyPressEvent(QKeyEvent* event);
+
     /** @see KFileIconView::contentsMouseReleaseEvent */
     virtual void contentsMouseReleaseEvent(QMouseEvent* event);
 
@@ -154,6 +160,19 @@ private slots:
     void slotUpdateDisabledItems();
 
 private:
+    class DolphinIconViewItem : public KFileIconViewItem {
+    public:
+        DolphinIconViewItem(QIconView* parent,
+                            KFileItem* fileItem);
+        virtual ~DolphinIconViewItem();
+
+        /**
+         * Informs the Dolphin view about the changed selection state, so
+         * that the selection histogram can be updated for this item only.
+         */
+        virtual void setSelected(bool select, bool callback);
+    };
+
     int m_previewIconSize;
     LayoutMode m_layoutMode;
     DolphinView* m_dolphinView;
@@ -51,7 +51,9 @@ void DolphinSettings::setHomeURL(const KURL& url)
 DolphinSettings::DolphinSettings() :
     m_defaultMode(DolphinView::IconsView),
     m_isViewSplit(false),
-    m_isURLEditable(false)
+    m_isURLEditable(false),
+    m_isVerifyCopies(false),
+    m_flatViewMaxDepth(0)
 {
     KConfig* config = kapp->config();
     config->setGroup("General");
@@ -60,6 +62,9 @@ DolphinSettings::DolphinSettings() :
     m_isViewSplit = config->readBoolEntry("Split View", false);
     m_isSaveView = config->readBoolEntry("Save View", false);
     m_isURLEditable = config->readBoolEntry("Editable URL", false);
+    m_isVerifyCopies = config->readBoolEntry("Verify Copies", false);
+    m_flatViewMaxDepth = config->readNumEntry("Flat View Max Depth", 0);
+    m_flatViewPatterns = config->readEntry("Flat View Patterns");
 
     m_iconsView = new DolphinIconsViewSettings(DolphinIconsView::Icons);
     m_previewsView = new DolphinIconsViewSettings(DolphinIconsView::Previews);
@@ -126,6 +131,9 @@ void DolphinSettings::save()
     config->writeEntry("Split View", m_isViewSplit);
     config->writeEntry("Save View", m_isSaveView);
     config->writeEntry("Editable URL", m_isURLEditable);
+    config->writeEntry("Verify Copies", m_isVerifyCopies);
+    config->writeEntry("Flat View Max Depth", m_flatViewMaxDepth);
+    config->writeEntry("Flat View Patterns", m_flatViewPatterns);
 
     m_iconsView->save();
     m_previewsView->save();
@@ -43,6 +43,7 @@ class rightSidebarSettings;
  * - default view mode
  * - URL navigator state (editable or not)
  * - split view
+ * - verifying of copied files
  * - bookmarks
  * - properties for icons and details view
  */
@@ -65,6 +66,28 @@ public:
     void setSaveView(bool yes) { m_isSaveView = yes; }
     bool isSaveView() const { return m_isSaveView; }
 
+    /**
+     * If enabled, local copies are read again after copying and compared
+     * with their sources (see LocalCopyJob::setVerifyEnabled()).
+     */
+    void setVerifyCopiesEnabled(bool verify) { m_isVerifyCopies = verify; }
+    bool isVerifyCopiesEnabled() const { return m_isVerifyCopies; }
+
+    /**
+     * Sets the maximum depth of the sub directories, which are listed by
+     * the flat view (see DolphinView::setFlatViewEnabled()). 0 means that
+     * the depth is unlimited.
+     */
+    void setFlatViewMaxDepth(int depth) { m_flatViewMaxDepth = depth; }
+    int flatViewMaxDepth() const { return m_flatViewMaxDepth; }
+
+    /**
+     * Sets the space separated wildcard patterns (e. g. "*.cpp *.h") of the
+     * files, which are listed by the flat view. An empty string lists all files.
+     */
+    void setFlatViewPatterns(const QString& patterns) { m_flatViewPatterns = patterns; }
+    const QString& flatViewPatterns() const { return m_flatViewPatterns; }
+
 
     DolphinIconsViewSettings* iconsView(DolphinIconsView::LayoutMode mode) const;
 
@@ -99,6 +122,9 @@ private:
     bool m_isViewSplit;
     bool m_isURLEditable;
     bool m_isSaveView;
+    bool m_isVerifyCopies;
+    int m_flatViewMaxDepth;
+    QString m_flatViewPatterns;
     KURL m_homeURL;
     DolphinIconsViewSettings* m_iconsView;
     DolphinIconsViewSettings* m_previewsView;
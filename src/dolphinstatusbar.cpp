@@ -27,11 +27,13 @@
 #include "dolphinview.h"
 #include "statusbarmessagelabel.h"
 #include "statusbarspaceinfo.h"
+#include "statusbartransferinfo.h"
 
 DolphinStatusBar::DolphinStatusBar(DolphinView* parent) :
     QHBox(parent),
     m_messageLabel(0),
     m_spaceInfo(0),
+    m_transferInfo(0),
     m_progressBar(0),
     m_progress(100)
 {
@@ -41,6 +43,8 @@ DolphinStatusBar::DolphinStatusBar(DolphinView* parent) :
     m_spaceInfo = new StatusBarSpaceInfo(this);
     m_spaceInfo->setURL(parent->url());
 
+    m_transferInfo = new StatusBarTransferInfo(this);
+
     m_progressText = new QLabel(this);
     m_progressText->hide();
 
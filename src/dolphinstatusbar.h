@@ -27,6 +27,7 @@ class QLabel;
 class QTimer;
 class StatusBarMessageLabel;
 class StatusBarSpaceInfo;
+class StatusBarTransferInfo;
 class DolphinView;
 class KURL;
 
@@ -123,6 +124,7 @@ private slots:
 private:
     StatusBarMessageLabel* m_messageLabel;
     StatusBarSpaceInfo* m_spaceInfo;
+    StatusBarTransferInfo* m_transferInfo;
     QLabel* m_progressText;
     KProgress* m_progressBar;
     QTimer* m_progressTimer;
@@ -21,6 +21,8 @@
 #include "dolphinview.h"
 
 #include <qlayout.h>
+#include <qptrdict.h>
+#include <qregexp.h>
 #include <kurl.h>
 #include <klocale.h>
 #include <kio/netaccess.h>
@@ -30,6 +32,7 @@
 #include "urlnavigator.h"
 #include "dolphinstatusbar.h"
 #include "dolphin.h"
+#include "dolphinsettings.h"
 #include "dolphindirlister.h"
 #include "viewproperties.h"
 #include "dolphindetailsview.h"
@@ -38,6 +41,13 @@
 #include "undomanager.h"
 #include "renamedialog.h"
 #include "progressindicator.h"
+#include "archiveindex.h"
+#include "openwithcache.h"
+#include "dirlisterpool.h"
+#include "workerpool.h"
+#include "foldersizeservice.h"
+#include "metainfoservice.h"
+#include "flatlister.h"
 
 #include "filterbar.h"
 
@@ -48,6 +58,7 @@ DolphinView::DolphinView(QWidget *parent,
     QWidget(parent),
     m_refreshing(false),
     m_showProgress(false),
+    m_showHiddenFiles(showHiddenFiles),
     m_mode(mode),
     m_iconsView(0),
     m_detailsView(0),
@@ -55,6 +66,8 @@ DolphinView::DolphinView(QWidget *parent,
     m_iconSize(0),
     m_folderCount(0),
     m_fileCount(0),
+    m_dirLister(0),
+    m_flatLister(0),
     m_filterBar(0)
 {
     setFocusPolicy(QWidget::StrongFocus);
@@ -66,6 +79,8 @@ DolphinView::DolphinView(QWidget *parent,
             &dolphin, SLOT(slotViewModeChanged()));
     connect(this, SIGNAL(signalShowHiddenFilesChanged()),
             &dolphin, SLOT(slotShowHiddenFilesChanged()));
+    connect(this, SIGNAL(signalFlatViewChanged()),
+            &dolphin, SLOT(slotFlatViewChanged()));
     connect(this, SIGNAL(signalSortingChanged(DolphinView::Sorting)),
             &dolphin, SLOT(slotSortingChanged(DolphinView::Sorting)));
     connect(this, SIGNAL(signalSortOrderChanged(Qt::SortOrder)),
@@ -81,31 +96,14 @@ DolphinView::DolphinView(QWidget *parent,
 
     m_statusBar = new DolphinStatusBar(this);
 
-    m_dirLister = new DolphinDirLister();
-    m_dirLister->setAutoUpdate(true);
-    m_dirLister->setMainWindow(this);
-    m_dirLister->setShowingDotFiles(showHiddenFiles);
-    connect(m_dirLister, SIGNAL(clear()),
-            this, SLOT(slotClear()));
-    connect(m_dirLister, SIGNAL(percent(int)),
-            this, SLOT(slotPercent(int)));
-    connect(m_dirLister, SIGNAL(deleteItem(KFileItem*)),
-            this, SLOT(slotDeleteItem(KFileItem*)));
-    connect(m_dirLister, SIGNAL(completed()),
-            this, SLOT(slotCompleted()));
-    connect(m_dirLister, SIGNAL(infoMessage(const QString&)),
-            this, SLOT(slotInfoMessage(const QString&)));
-    connect(m_dirLister, SIGNAL(errorMessage(const QString&)),
-            this, SLOT(slotErrorMessage(const QString&)));
-    connect(m_dirLister, SIGNAL(refreshItems (const KFileItemList&)),
-            this, SLOT(slotRefreshItems(const KFileItemList&)));
-    connect(m_dirLister, SIGNAL(newItems(const KFileItemList&)),
-           this, SLOT(slotAddItems(const KFileItemList&)));
+    m_archiveItems.setAutoDelete(true);
+    attachDirLister(url);
 
     m_iconSize = KIcon::SizeMedium;
 
     m_topLayout->addWidget(m_urlNavigator);
     createView();
+    startDirLister(m_urlNavigator->url());
 
     m_filterBar = new FilterBar(this);
     m_filterBar->hide();
@@ -114,12 +112,26 @@ DolphinView::DolphinView(QWidget *parent,
            this, SLOT(slotChangeNameFilter(const QString&)));
 
     m_topLayout->addWidget(m_statusBar);
+
+    connect(&FolderSizeService::instance(), SIGNAL(sizeAvailable(const QString&, KIO::filesize_t, bool)),
+            this, SLOT(slotFolderSizeAvailable(const QString&, KIO::filesize_t, bool)));
 }
 
 DolphinView::~DolphinView()
 {
-    delete m_dirLister;
+    // the view items refer to the archive items, which get deleted before the child widgets
+    fileView()->clearView();
+
+    disconnect(m_dirLister, 0, this, 0);
+    DirListerPool::instance().release(m_dirLister);
     m_dirLister = 0;
+
+    delete m_flatLister;
+    m_flatLister = 0;
+
+    WorkerPool::instance().cancelJobs(this);
+    FolderSizeService::instance().cancelRequests(this);
+    MetaInfoService::instance().cancelRequests(this);
 }
 
 void DolphinView::setURL(const KURL& url)
@@ -148,19 +160,12 @@ void DolphinView::setMode(Mode mode)
         return;         // the wished mode is already set
     }
 
-    QWidget* view = (m_iconsView != 0) ? static_cast<QWidget*>(m_iconsView) :
-                                         static_cast<QWidget*>(m_detailsView);
-    if (view != 0) {
-        m_topLayout->remove(view);
-        view->close();
-        view->deleteLater();
-        m_iconsView = 0;
-        m_detailsView = 0;
+    if (mode != DetailsView) {
+        // the flat view is only supported by the details view
+        setFlatViewEnabled(false);
     }
 
-    m_mode = mode;
-
-    createView();
+    recreateView(mode);
 
     ViewProperties props(m_urlNavigator->url());
     props.setViewMode(m_mode);
@@ -175,7 +180,7 @@ DolphinView::Mode DolphinView::mode() const
 
 void DolphinView::setShowHiddenFilesEnabled(bool show)
 {
-    if (m_dirLister->showingDotFiles() == show) {
+    if (m_showHiddenFiles == show) {
         return;
     }
 
@@ -183,16 +188,82 @@ void DolphinView::setShowHiddenFilesEnabled(bool show)
     props.setShowHiddenFilesEnabled(show);
     props.save();
 
-    m_dirLister->setShowingDotFiles(show);
+    m_showHiddenFiles = show;
 
     emit signalShowHiddenFilesChanged();
 
-    reload();
+    // store the current item inside the history, so that it is restored after the update
+    int historyIndex = 0;
+    m_urlNavigator->history(historyIndex);
+    refreshItems();
 }
 
 bool DolphinView::isShowHiddenFilesEnabled() const
 {
-    return m_dirLister->showingDotFiles();
+    return m_showHiddenFiles;
+}
+
+void DolphinView::setFlatViewEnabled(bool enable)
+{
+    if (enable == isFlatViewEnabled()) {
+        return;
+    }
+
+    const KURL& url = m_urlNavigator->url();
+    if (enable && !url.isLocalFile()) {
+        m_statusBar->setMessage(i18n("The flat view is only available for local folders."),
+                                DolphinStatusBar::Error);
+        emit signalFlatViewChanged();
+        return;
+    }
+
+    if (!enable) {
+        // the view items refer to the items of the flat lister
+        slotClear();
+        delete m_flatLister;
+        m_flatLister = 0;
+        if (m_showProgress) {
+            m_statusBar->setProgressText(QString::null);
+            m_statusBar->setProgress(100);
+            m_showProgress = false;
+        }
+        refreshItems();
+        emit signalFlatViewChanged();
+        return;
+    }
+
+    // the relative paths of the files can only be shown by the details view
+    setMode(DetailsView);
+    slotClear();
+    m_fileCount = 0;
+    m_folderCount = 0;
+
+    m_flatLister = new FlatLister(this);
+    connect(m_flatLister, SIGNAL(newItems(const KFileItemList&)),
+            this, SLOT(slotAddFlatItems(const KFileItemList&)));
+    connect(m_flatLister, SIGNAL(completed()),
+            this, SLOT(slotFlatListingCompleted()));
+
+    const QString progressText(m_statusBar->progressText());
+    m_showProgress = progressText.isEmpty() ||
+                     (progressText == i18n("Loading directory...")) ||
+                     (progressText == i18n("Listing sub folders..."));
+    if (m_showProgress) {
+        m_statusBar->setProgressText(i18n("Listing sub folders..."));
+        m_statusBar->setProgress(0);
+    }
+
+    const DolphinSettings& settings = DolphinSettings::instance();
+    m_flatLister->openURL(url,
+                          settings.flatViewMaxDepth(),
+                          settings.flatViewPatterns());
+
+    emit signalFlatViewChanged();
+}
+
+bool DolphinView::isFlatViewEnabled() const
+{
+    return m_flatLister != 0;
 }
 
 void DolphinView::setViewProperties(const ViewProperties& props)
@@ -297,12 +368,37 @@ void DolphinView::renameSelectedItems()
 
 void DolphinView::selectAll()
 {
-    fileView()->selectAll();
+    QBitArray bits(fileView()->count());
+    bits.fill(true);
+    setSelection(bits);
 }
 
 void DolphinView::invertSelection()
 {
-    fileView()->invertSelection();
+    setSelection(~selection());
+}
+
+void DolphinView::selectItems(const QString& pattern)
+{
+    const QRegExp regExp(pattern, true, true);
+    if (!regExp.isValid()) {
+        return;
+    }
+
+    QBitArray bits(selection());
+
+    KFileView* view = fileView();
+    uint index = 0;
+    const KFileItem* item = view->firstFileItem();
+    while (item != 0) {
+        if (regExp.exactMatch(item->name())) {
+            bits.setBit(index);
+        }
+        item = view->nextItem(item);
+        ++index;
+    }
+
+    setSelection(bits);
 }
 
 DolphinStatusBar* DolphinView::statusBar() const
@@ -327,17 +423,7 @@ void DolphinView::refreshSettings()
     }
 
     if (m_detailsView != 0) {
-        // TODO: There is no usable interface in QListView/KFileDetailView
-        // to hide/show columns. The easiest approach is to delete
-        // the current instance and recreate a new one, which automatically
-        // refreshs the settings. If a proper interface is available in Qt4
-        // m_detailsView->refreshSettings() would be enough.
-        m_topLayout->remove(m_detailsView);
-        m_detailsView->close();
-        m_detailsView->deleteLater();
-        m_detailsView = 0;
-
-        createView();
+        m_detailsView->refreshSettings();
     }
 }
 
@@ -356,7 +442,8 @@ void DolphinView::updateStatusBar()
                                      (m_statusBar->type() == DolphinStatusBar::Information)) &&
                                     (m_statusBar->progress() == 100);
 
-    const QString text(hasSelection() ? selectionStatusBarText() : defaultStatusBarText());
+    const bool hasSelection = (m_selectionHistogram.itemCount() > 0);
+    const QString text(hasSelection ? selectionStatusBarText() : defaultStatusBarText());
     m_statusBar->setDefaultText(text);
 
     if (updateStatusBarMsg) {
@@ -499,6 +586,48 @@ const KFileItemList* DolphinView::selectedItems() const
     return fileView()->selectedItems();
 }
 
+KFileItem* DolphinView::itemByName(const QString& name) const
+{
+    return m_nameIndex.item(name);
+}
+
+KFileItem* DolphinView::typeAheadItem(const QString& text)
+{
+    // the typed characters are collected as long as the user
+    // does not pause for more than half a second
+    if (m_typeAheadTime.isNull() || (m_typeAheadTime.elapsed() > 500)) {
+        m_typeAheadPrefix = QString::null;
+    }
+    m_typeAheadPrefix.append(text);
+    m_typeAheadTime.start();
+
+    return m_nameIndex.firstMatch(m_typeAheadPrefix);
+}
+
+const MimeTypeHistogram& DolphinView::selectionHistogram() const
+{
+    return m_selectionHistogram;
+}
+
+void DolphinView::updateSelection(const KFileItem* item, bool selected)
+{
+    const bool isLocalFolder = item->isDir() && item->url().isLocalFile();
+    if (selected) {
+        m_selectionHistogram.add(item);
+        if (isLocalFolder) {
+            const QString path(item->url().path(-1));
+            m_selectedFolders.append(path);
+            FolderSizeService::instance().requestSize(path, WorkerJob::Preview, this);
+        }
+    }
+    else {
+        m_selectionHistogram.remove(item);
+        if (isLocalFolder) {
+            m_selectedFolders.remove(item->url().path(-1));
+        }
+    }
+}
+
 KURL::List DolphinView::selectedURLs() const
 {
     KURL::List urls;
@@ -590,6 +719,13 @@ void DolphinView::rename(const KURL& source, const QString& newName)
 
 void DolphinView::reload()
 {
+    if (isFlatViewEnabled()) {
+        // list the sub folders again
+        setFlatViewEnabled(false);
+        setFlatViewEnabled(true);
+        return;
+    }
+
     startDirLister(m_urlNavigator->url(), true);
 }
 
@@ -627,7 +763,6 @@ void DolphinView::slotURLChanged(const KURL& url)
 
     const bool showHiddenFiles = props.isShowHiddenFilesEnabled();
     setShowHiddenFilesEnabled(showHiddenFiles);
-    m_dirLister->setShowingDotFiles(showHiddenFiles);
 
     setSorting(props.sorting());
     setSortOrder(props.sortOrder());
@@ -708,6 +843,13 @@ void DolphinView::updateURL()
     else if (fileItem->isFile()) {
        // allow to browse through ZIP and tar files
        KMimeType::Ptr mime = fileItem->mimeTypePtr();
+       const QString localPath(fileItem->localPath());
+       if (!localPath.isEmpty()) {
+           // index the archive in the background, so that browsing
+           // inside the archive gets faster
+           ArchiveIndex::instance().requestIndex(localPath, mime->name());
+       }
+
        if (mime->is("application/x-zip")) {
            KURL url = fileItem->url();
            url.setProtocol("zip");
@@ -740,19 +882,53 @@ void DolphinView::slotPercent(int percent)
 
 void DolphinView::slotClear()
 {
+    if (isFlatViewEnabled() && (sender() == m_dirLister)) {
+        // the items of the flat view are not touched by the dir lister
+        return;
+    }
+
+    m_selectionHistogram.clear();
+    m_selectedFolders.clear();
+    m_nameIndex.clear();
     fileView()->clearView();
     updateStatusBar();
 }
 
 void DolphinView::slotDeleteItem(KFileItem* item)
 {
-    fileView()->removeItem(item);
+    if (isFlatViewEnabled()) {
+        return;
+    }
+
+    m_selectionHistogram.remove(item);
+    if (item->isDir() && item->url().isLocalFile()) {
+        m_selectedFolders.remove(item->url().path(-1));
+    }
+    m_nameIndex.remove(item);
+    if (isItemShown(item)) {
+        fileView()->removeItem(item);
+    }
     updateStatusBar();
 }
 
 void DolphinView::slotCompleted()
+{
+    if (isFlatViewEnabled()) {
+        return;
+    }
+
+    loadItems(m_dirLister->items());
+
+    // the items of an indexed archive are not shown anymore
+    m_archiveItems.clear();
+}
+
+void DolphinView::loadItems(const KFileItemList& items)
 {
     m_refreshing = true;
+    m_selectionHistogram.clear();
+    m_selectedFolders.clear();
+    m_nameIndex.clear();
 
     KFileView* view = fileView();
     view->clearView();
@@ -772,15 +948,22 @@ void DolphinView::slotCompleted()
         m_showProgress = false;
     }
 
-    KFileItemList items(m_dirLister->items());
     KFileItemListIterator it(items);
+    KFileItemList shownItems;
 
     m_fileCount = 0;
     m_folderCount = 0;
 
     KFileItem* item = 0;
     while ((item = it.current()) != 0) {
+        if (!isItemShown(item)) {
+            ++it;
+            continue;
+        }
+
+        shownItems.append(item);
         view->insertItem(item);
+        m_nameIndex.insert(item);
         if (item->isDir()) {
             ++m_folderCount;
         }
@@ -792,6 +975,9 @@ void DolphinView::slotCompleted()
 
     updateStatusBar();
 
+    // query the 'Open With' offers for the shown items in advance
+    OpenWithCache::instance().warmUp(shownItems);
+
     if (m_iconsView != 0) {
         // Prevent a flickering of the icon view widget by giving a small
         // timeslot to swallow asynchronous update events.
@@ -824,17 +1010,94 @@ void DolphinView::slotErrorMessage(const QString& msg)
     m_statusBar->setMessage(msg, DolphinStatusBar::Error);
 }
 
-void DolphinView::slotRefreshItems(const KFileItemList& /* list */)
+void DolphinView::slotRefreshItems(const KFileItemList& list)
 {
-    QTimer::singleShot(0, this, SLOT(reload()));
+    // A changed folder has got new or removed items and a changed file
+    // changes the size of the shown directory.
+    FolderSizeService& folderSizes = FolderSizeService::instance();
+    KFileItemListIterator it(list);
+    while (it.current() != 0) {
+        const KURL& itemURL = it.current()->url();
+        if (itemURL.isLocalFile()) {
+            folderSizes.invalidate(it.current()->isDir() ? itemURL.path(-1) : itemURL.directory());
+        }
+        ++it;
+    }
+    if (!m_selectedFolders.isEmpty()) {
+        requestFolderSizes();
+    }
+
+    // The changed items have already been updated by the dir lister, which
+    // might be shared with another view. Hence the directory is not listed
+    // again, only the view gets updated.
+    refreshItems();
 }
 
 void DolphinView::slotAddItems(const KFileItemList& list)
 {
-  fileView()->addItemList(list);
+  if (isFlatViewEnabled()) {
+      return;
+  }
+
+  KFileItemList shownItems;
+  KFileItemListIterator it(list);
+  while (it.current() != 0) {
+      if (isItemShown(it.current())) {
+          shownItems.append(it.current());
+          m_nameIndex.insert(it.current());
+      }
+      ++it;
+  }
+
+  fileView()->addItemList(shownItems);
   fileView()->updateView();
 }
 
+void DolphinView::slotAddFlatItems(const KFileItemList& list)
+{
+    // The items are inserted at their sorted position without reloading
+    // the view, so that the user can work with the found files while the
+    // remaining sub folders are read.
+    KFileItemList shownItems;
+    KFileItemListIterator it(list);
+    while (it.current() != 0) {
+        if (isItemShown(it.current())) {
+            shownItems.append(it.current());
+            m_nameIndex.insert(it.current());
+        }
+        ++it;
+    }
+
+    if (shownItems.isEmpty()) {
+        return;
+    }
+
+    fileView()->addItemList(shownItems);
+    fileView()->updateView();
+
+    m_fileCount += shownItems.count();
+    updateStatusBar();
+}
+
+void DolphinView::slotFlatListingCompleted()
+{
+    if (m_showProgress) {
+        m_statusBar->setProgressText(QString::null);
+        m_statusBar->setProgress(100);
+        m_showProgress = false;
+    }
+    updateStatusBar();
+}
+
+void DolphinView::slotFolderSizeAvailable(const QString& path,
+                                          KIO::filesize_t /* size */,
+                                          bool /* isComplete */)
+{
+    if (m_selectedFolders.contains(path)) {
+        updateStatusBar();
+    }
+}
+
 void DolphinView::slotGrabActivation()
 {
     Dolphin::mainWin().setActiveView(this);
@@ -900,8 +1163,54 @@ void DolphinView::createView()
 
     connect(scrollView(), SIGNAL(contentsMoving(int, int)),
             this, SLOT(slotContentsMoving(int, int)));
+}
 
-    startDirLister(m_urlNavigator->url());
+void DolphinView::recreateView(Mode mode)
+{
+    // Store the current item and the contents position inside the URL history.
+    // Both are restored by the new view as soon as the items have been inserted.
+    int historyIndex = 0;
+    m_urlNavigator->history(historyIndex);
+
+    QPtrDict<KFileItem> selectedItems;
+    const KFileItemList* list = fileView()->selectedItems();
+    if (list != 0) {
+        KFileItemListIterator it(*list);
+        while (it.current() != 0) {
+            selectedItems.insert(it.current(), it.current());
+            ++it;
+        }
+    }
+
+    QWidget* view = (m_iconsView != 0) ? static_cast<QWidget*>(m_iconsView) :
+                                         static_cast<QWidget*>(m_detailsView);
+    m_topLayout->remove(view);
+    view->close();
+    view->deleteLater();
+    m_iconsView = 0;
+    m_detailsView = 0;
+
+    m_mode = mode;
+    createView();
+
+    refreshItems();
+
+    if (!selectedItems.isEmpty()) {
+        KFileView* fileView = this->fileView();
+        QBitArray bits(fileView->count());
+        bits.fill(false);
+
+        uint index = 0;
+        const KFileItem* item = fileView->firstFileItem();
+        while (item != 0) {
+            if (selectedItems.find(const_cast<KFileItem*>(item)) != 0) {
+                bits.setBit(index);
+            }
+            item = fileView->nextItem(item);
+            ++index;
+        }
+        setSelection(bits);
+    }
 }
 
 KFileView* DolphinView::fileView() const
@@ -910,6 +1219,90 @@ KFileView* DolphinView::fileView() const
                                      static_cast<KFileView*>(m_iconsView);
 }
 
+void DolphinView::refreshItems()
+{
+    // The items are still owned by the dir lister (or by the archive index),
+    // hence the view can be filled from memory without listing the
+    // directory again. A listing which is still in progress will add the
+    // remaining items as usual.
+    const bool showProgress = m_showProgress;
+    m_showProgress = false;
+    if (isFlatViewEnabled()) {
+        loadItems(m_flatLister->items());
+    }
+    else if (m_archiveItems.isEmpty()) {
+        loadItems(m_dirLister->items());
+    }
+    else {
+        loadItems(m_archiveItems);
+    }
+    m_showProgress = showProgress;
+}
+
+bool DolphinView::isItemShown(const KFileItem* item) const
+{
+    // The name of an item inside the flat view is the path relative to the
+    // listed folder, where a hidden parent folder hides the item too.
+    const QString name(item->name());
+    if (!m_showHiddenFiles && (name.startsWith(".") || (name.find("/.") >= 0))) {
+        return false;
+    }
+
+    return m_nameFilter.isEmpty() || m_nameFilter.exactMatch(name);
+}
+
+QBitArray DolphinView::selection() const
+{
+    KFileView* view = fileView();
+    QBitArray bits(view->count());
+    bits.fill(false);
+
+    uint index = 0;
+    const KFileItem* item = view->firstFileItem();
+    while (item != 0) {
+        if (view->isSelected(item)) {
+            bits.setBit(index);
+        }
+        item = view->nextItem(item);
+        ++index;
+    }
+
+    return bits;
+}
+
+void DolphinView::setSelection(const QBitArray& selection)
+{
+    KFileView* view = fileView();
+    QScrollView* scrollView = this->scrollView();
+    QWidget* viewport = scrollView->viewport();
+
+    // Toggling the selection of each item results in a repaint and in
+    // a 'selectionChanged' signal for each item, which makes bulk operations
+    // very slow for large directories. Hence both are suppressed until the
+    // selection has been applied.
+    const bool block = scrollView->signalsBlocked();
+    scrollView->blockSignals(true);
+    viewport->setUpdatesEnabled(false);
+
+    const uint count = selection.size();
+    uint index = 0;
+    const KFileItem* item = view->firstFileItem();
+    while ((item != 0) && (index < count)) {
+        const bool select = selection.testBit(index);
+        if (view->isSelected(item) != select) {
+            view->setSelected(item, select);
+        }
+        item = view->nextItem(item);
+        ++index;
+    }
+
+    viewport->setUpdatesEnabled(true);
+    scrollView->blockSignals(block);
+    viewport->update();
+
+    Dolphin::mainWin().slotSelectionChanged();
+}
+
 QScrollView* DolphinView::scrollView() const
 {
     return (m_mode == DetailsView) ? static_cast<QScrollView*>(m_detailsView) :
@@ -947,11 +1340,95 @@ void DolphinView::startDirLister(const KURL& url, bool reload)
         m_statusBar->setProgress(0);
     }
 
+    if (isFlatViewEnabled()) {
+        // the flat view only shows the directory, where it has been enabled
+        slotClear();
+        delete m_flatLister;
+        m_flatLister = 0;
+        emit signalFlatViewChanged();
+    }
+
+    // the pending work for the items of the previous directory is not needed anymore
+    WorkerPool::instance().cancelJobs(this);
+    FolderSizeService::instance().cancelRequests(this);
+    MetaInfoService::instance().cancelRequests(this);
+
+    attachDirLister(url);
+
+    if (!reload && listArchive(url)) {
+        return;
+    }
+
     m_refreshing = true;
+    if (!reload && !m_dirLister->url().isEmpty()) {
+        // The directory is already listed for another view. The view items
+        // must be removed before the archive items get deleted.
+        slotClear();
+        m_archiveItems.clear();
+        if (m_dirLister->isFinished()) {
+            slotCompleted();
+        }
+        else {
+            // the remaining items are added when they are received
+            refreshItems();
+        }
+        return;
+    }
+
     m_dirLister->stop();
     m_dirLister->openURL(url, false, reload);
 }
 
+void DolphinView::attachDirLister(const KURL& url)
+{
+    // The new lister is acquired before the current one gets released,
+    // so that a lister for the same URL is not deleted in between.
+    DirListerPool& pool = DirListerPool::instance();
+    DolphinDirLister* dirLister = pool.acquire(url);
+    if (m_dirLister != 0) {
+        disconnect(m_dirLister, 0, this, 0);
+        pool.release(m_dirLister);
+    }
+    m_dirLister = dirLister;
+
+    connect(m_dirLister, SIGNAL(clear()),
+            this, SLOT(slotClear()));
+    connect(m_dirLister, SIGNAL(percent(int)),
+            this, SLOT(slotPercent(int)));
+    connect(m_dirLister, SIGNAL(deleteItem(KFileItem*)),
+            this, SLOT(slotDeleteItem(KFileItem*)));
+    connect(m_dirLister, SIGNAL(completed()),
+            this, SLOT(slotCompleted()));
+    connect(m_dirLister, SIGNAL(infoMessage(const QString&)),
+            this, SLOT(slotInfoMessage(const QString&)));
+    connect(m_dirLister, SIGNAL(errorMessage(const QString&)),
+            this, SLOT(slotErrorMessage(const QString&)));
+    connect(m_dirLister, SIGNAL(refreshItems (const KFileItemList&)),
+            this, SLOT(slotRefreshItems(const KFileItemList&)));
+    connect(m_dirLister, SIGNAL(newItems(const KFileItemList&)),
+           this, SLOT(slotAddItems(const KFileItemList&)));
+}
+
+bool DolphinView::listArchive(const KURL& url)
+{
+    KFileItemList items;
+    if (!ArchiveIndex::instance().listDirectory(url, items)) {
+        return false;
+    }
+
+    loadItems(items);
+
+    // the view does not refer to the previous archive items anymore
+    m_archiveItems.clear();
+    KFileItemListIterator it(items);
+    while (it.current() != 0) {
+        m_archiveItems.append(it.current());
+        ++it;
+    }
+
+    return true;
+}
+
 QString DolphinView::defaultStatusBarText() const
 {
     const int itemCount = m_folderCount + m_fileCount;
@@ -966,25 +1443,41 @@ QString DolphinView::defaultStatusBarText() const
 QString DolphinView::selectionStatusBarText() const
 {
     QString text;
-    const KFileItemList* list = selectedItems();
-    assert((list != 0) && !list->isEmpty());
+    assert(m_selectionHistogram.itemCount() > 0);
 
-    int fileCount = 0;
-    int folderCount = 0;
-    KIO::filesize_t byteSize = 0;
-    for (KFileItemListIterator it(*list); it.current() != 0; ++it) {
-        KFileItem* item = it.current();
-        if (item->isDir()) {
-            ++folderCount;
+    const int fileCount = m_selectionHistogram.fileCount();
+    const int folderCount = m_selectionHistogram.directoryCount();
+
+    if (folderCount>0) {
+        if (m_selectedFolders.count() != static_cast<uint>(folderCount)) {
+            // the size of non-local folders is not calculated
+            text = i18n("1 Folder selected","%n Folders selected", folderCount);
         }
         else {
-            ++fileCount;
-            byteSize += item->size();
-        }
-    }
+            FolderSizeService& folderSizes = FolderSizeService::instance();
+            KIO::filesize_t totalSize = 0;
+            bool isComplete = true;
+            QStringList::ConstIterator it = m_selectedFolders.begin();
+            const QStringList::ConstIterator end = m_selectedFolders.end();
+            while (it != end) {
+                KIO::filesize_t size = 0;
+                if (!folderSizes.folderSize(*it, size)) {
+                    folderSizes.isCalculating(*it, size);
+                    isComplete = false;
+                }
+                totalSize += size;
+                ++it;
+            }
 
-    if (folderCount>0) {
-        text = i18n("1 Folder selected","%n Folders selected", folderCount);
+            const QString sizeText(KIO::convertSize(totalSize));
+            if (isComplete) {
+                text = i18n("1 Folder selected (%1)", "%n Folders selected (%1)", folderCount).arg(sizeText);
+            }
+            else {
+                text = i18n("1 Folder selected (calculating: %1)",
+                            "%n Folders selected (calculating: %1)", folderCount).arg(sizeText);
+            }
+        }
     }
 
     if ((fileCount > 0) && (folderCount > 0)) {
@@ -992,13 +1485,24 @@ QString DolphinView::selectionStatusBarText() const
     }
 
     if (fileCount > 0) {
-        const QString sizeText(KIO::convertSize(byteSize));
+        const QString sizeText(KIO::convertSize(m_selectionHistogram.totalFileSize()));
         text += i18n("1 File selected (%1)", "%n Files selected (%1)", fileCount).arg(sizeText);
     }
 
     return text;
 }
 
+void DolphinView::requestFolderSizes()
+{
+    FolderSizeService& folderSizes = FolderSizeService::instance();
+    QStringList::ConstIterator it = m_selectedFolders.begin();
+    const QStringList::ConstIterator end = m_selectedFolders.end();
+    while (it != end) {
+        folderSizes.requestSize(*it, WorkerJob::Preview, this);
+        ++it;
+    }
+}
+
 QString DolphinView::renameIndexPresentation(int index, int itemCount) const
 {
     // assure that the string reprentation for all indicess have the same
@@ -1031,30 +1535,22 @@ void DolphinView::slotShowFilterBar(bool show)
 
 void DolphinView::slotChangeNameFilter(const QString& nameFilter)
 {
-    // The name filter of KDirLister does a 'hard' filtering, which
-    // means that only the items are shown where the names match
-    // exactly the filter. This is non-transparent for the user, which
-    // just wants to have a 'soft' filtering: does the name contain
-    // the filter string?
-    QString adjustedFilter(nameFilter);
-    adjustedFilter.insert(0, '*');
-    adjustedFilter.append('*');
-
-    m_dirLister->setNameFilter(adjustedFilter);
-    m_dirLister->emitChanges();
-
-    // TODO: this is a workaround for QIconView: the item position
-    // stay as they are by filtering, only an inserting of an item
-    // results to an automatic adjusting of the item position. In Qt4/KDE4
-    // this workaround should get obsolete due to Interview.
-    KFileView* view = fileView();
-    if (view == m_iconsView) {
-        KFileItem* first = view->firstFileItem();
-        if (first != 0) {
-            view->removeItem(first);
-            view->insertItem(first);
-        }
+    // The filter is applied by the view, as the dir lister might be
+    // shared with another view. A 'hard' filtering, where only the items
+    // are shown whose names match exactly the filter, is non-transparent
+    // for the user, which just wants to have a 'soft' filtering: does the
+    // name contain the filter string?
+    if (nameFilter.isEmpty()) {
+        m_nameFilter = QRegExp();
+    }
+    else {
+        QString adjustedFilter(nameFilter);
+        adjustedFilter.insert(0, '*');
+        adjustedFilter.append('*');
+        m_nameFilter = QRegExp(adjustedFilter, false, true);
     }
+
+    refreshItems();
 }
 
 bool DolphinView::isFilterBarVisible() const
@@ -23,12 +23,19 @@
 #define _DOLPHINVIEW_H_
 
 #include <qwidget.h>
+#include <qbitarray.h>
+#include <qdatetime.h>
+#include <qregexp.h>
+#include <qstringlist.h>
 #include <kparts/part.h>
 #include <kfileitem.h>
 #include <kfileiconview.h>
 #include <kio/job.h>
 #include <urlnavigator.h>
 
+#include "itemnameindex.h"
+#include "mimetypehistogram.h"
+
 class QPainter;
 class KURL;
 class QLineEdit;
@@ -48,6 +55,7 @@ class QScrollView;
 class KProgress;
 class ItemEffectsManager;
 class FilterBar;
+class FlatLister;
 /**
  * @short Represents a view for the directory content
  * including the navigation bar and status bar.
@@ -127,6 +135,18 @@ public:
     void setShowHiddenFilesEnabled(bool show);
     bool isShowHiddenFilesEnabled() const;
 
+    /**
+     * Enables or disables the flat view. In the flat view all files below
+     * the current local directory are shown as one list inside the details
+     * view, where the name of each file is the path relative to the current
+     * directory. The files are added while the sub directories are read in
+     * parallel. The maximum depth and the name patterns are taken from the
+     * general settings. The flat view gets disabled as soon as another
+     * directory is opened.
+     */
+    void setFlatViewEnabled(bool enable);
+    bool isFlatViewEnabled() const;
+
     void setViewProperties(const ViewProperties& props);
 
     /**
@@ -148,6 +168,13 @@ public:
      */
     void invertSelection();
 
+    /**
+     * Adds all items, where the name matches to the wildcard
+     * pattern \a pattern (e. g. "*.png"), to the current selection.
+     * @see DolphinView::selectedItems()
+     */
+    void selectItems(const QString& pattern);
+
     /**
      * Goes back one step in the URL history. The signals
      * URLNavigator::urlChanged and URLNavigator::historyChanged
@@ -208,6 +235,38 @@ public:
      */
     const KFileItemList* selectedItems() const;
 
+    /**
+     * Returns the shown item having the name \a name. 0 is returned if
+     * no such item is available. The lookup is done by a hash table, hence
+     * it can also be used for large directories.
+     */
+    KFileItem* itemByName(const QString& name) const;
+
+    /**
+     * Appends the typed text \a text to the type-ahead prefix and returns the
+     * first item (in alphabetical order), where the name starts with the
+     * prefix. If the last invocation has been done more than half a second
+     * ago, a new prefix is started. Is used by the views for the keyboard
+     * search.
+     */
+    KFileItem* typeAheadItem(const QString& text);
+
+    /**
+     * Returns the MIME type histogram of the selected items, which also
+     * contains the number of selected files and folders and their size.
+     * @see DolphinView::updateSelection()
+     */
+    const MimeTypeHistogram& selectionHistogram() const;
+
+    /**
+     * Updates the histogram of the selected items after the item \a item
+     * has been selected (\a selected is true) or deselected. Is invoked by
+     * the items of the icons view and the details view for each change of
+     * their selection state, before the view emits the signal
+     * selectionChanged().
+     */
+    void updateSelection(const KFileItem* item, bool selected);
+
     /**
      * Returns a list of URLs for all selected items. An empty list
      * is returned, if no item is selected.
@@ -343,6 +402,9 @@ signals:
     /** Is emitted if the 'show hidden files' property has been changed. */
     void signalShowHiddenFilesChanged();
 
+    /** Is emitted if the flat view has been enabled or disabled. */
+    void signalFlatViewChanged();
+
     /** Is emitted if the sorting by name, size or date has been changed. */
     void signalSortingChanged(DolphinView::Sorting sorting);
 
@@ -388,6 +450,20 @@ private slots:
     void slotRefreshItems(const KFileItemList& list);
     void slotAddItems(const KFileItemList& list);
 
+    /** Adds the items \a list, which have been found by the flat lister. */
+    void slotAddFlatItems(const KFileItemList& list);
+
+    /** Is invoked if the flat lister has read all sub directories. */
+    void slotFlatListingCompleted();
+
+    /**
+     * Updates the status bar if the size \a size of the folder \a path is
+     * part of the selection.
+     */
+    void slotFolderSizeAvailable(const QString& path,
+                                 KIO::filesize_t size,
+                                 bool isComplete);
+
     void slotGrabActivation();
 
     /**
@@ -406,11 +482,65 @@ private slots:
 
 private:
     void createView();
+
+    /**
+     * Replaces the current view widget by a view for the mode \a mode. The
+     * new view is filled by the already loaded items, the selection, the
+     * current item and the contents position are kept.
+     */
+    void recreateView(Mode mode);
+
+    /**
+     * Fills the view by the already loaded items of the current directory
+     * without listing the directory again.
+     */
+    void refreshItems();
+
+    /**
+     * Returns true, if the item \a item is shown by the view. Hidden files
+     * are always listed, but only shown if enabled. Also the name filter
+     * of the filter bar is applied.
+     */
+    bool isItemShown(const KFileItem* item) const;
+
     KFileView* fileView() const;
     QScrollView* scrollView() const;
     ItemEffectsManager* itemEffectsManager() const;
     void startDirLister(const KURL& url, bool reload = false);
 
+    /**
+     * Connects the view to the dir lister for the URL \a url, which is
+     * shared with other views showing the same URL (see DirListerPool).
+     */
+    void attachDirLister(const KURL& url);
+
+    /**
+     * Returns the selection state of all items of the current view.
+     * The bit index is equal to the item position inside the view.
+     */
+    QBitArray selection() const;
+
+    /**
+     * Applies the selection state \a selection to all items of the current
+     * view. Only items, where the selection state has been changed are
+     * touched. Per item no signal and no repaint is emitted: the view is
+     * repainted once and the selection change is reported once afterwards.
+     */
+    void setSelection(const QBitArray& selection);
+
+    /**
+     * Shows the items \a items inside the current view and updates
+     * the folder and file count.
+     */
+    void loadItems(const KFileItemList& items);
+
+    /**
+     * Shows the content of the archive directory \a url by the index
+     * of ArchiveIndex without starting an I/O slave. False is returned,
+     * if no index is available for the archive.
+     */
+    bool listArchive(const KURL& url);
+
     /**
      * Returns the default text of the status bar, if no item is
      * selected.
@@ -423,6 +553,12 @@ private:
      */
     QString selectionStatusBarText() const;
 
+    /**
+     * Requests the calculation of the sizes of the selected local
+     * folders by the FolderSizeService.
+     */
+    void requestFolderSizes();
+
     /**
      * Returns the string representation for the index \a index
      * for renaming \itemCount items.
@@ -431,6 +567,7 @@ private:
 
     bool m_refreshing;
     bool m_showProgress;
+    bool m_showHiddenFiles;
     Mode m_mode;
 
     QVBoxLayout* m_topLayout;
@@ -445,6 +582,22 @@ private:
     int m_fileCount;
 
     DolphinDirLister* m_dirLister;
+    QRegExp m_nameFilter;
+
+    /** Contains the items of an indexed archive directory, which is currently shown. */
+    KFileItemList m_archiveItems;
+
+    /** Lists the files of the flat view. Is 0 if the flat view is disabled. */
+    FlatLister* m_flatLister;
+
+    MimeTypeHistogram m_selectionHistogram;
+
+    /** Paths of the selected local folders, whose sizes are shown in the status bar. */
+    QStringList m_selectedFolders;
+    ItemNameIndex m_nameIndex;
+
+    QString m_typeAheadPrefix;
+    QTime m_typeAheadTime;
 
     FilterBar *m_filterBar;
 };
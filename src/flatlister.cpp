@@ -0,0 +1,350 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "flatlister.h"
+
+#include <dirent.h>
+#include <grp.h>
+#include <limits.h>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <qfile.h>
+#include <qregexp.h>
+#include <qstringlist.h>
+
+#include <kio/global.h>
+
+#include "workerpool.h"
+
+/**
+ * @brief Reads one directory for the FlatLister by a thread of the worker pool.
+ *
+ * The job only collects the status of the files and the names of the
+ * sub directories. The KFileItems are created inside the GUI thread.
+ */
+class FlatListJob : public WorkerJob
+{
+public:
+    /** Contains the status of one file of the directory. */
+    struct Entry
+    {
+        QCString name;
+        mode_t mode;
+        KIO::filesize_t size;
+        time_t mtime;
+        uid_t uid;
+        gid_t gid;
+        QCString linkDest;
+    };
+
+    /**
+     * @param path          Encoded local path of the directory.
+     * @param relativePath  Encoded path of the directory relative to the listed
+     *                      directory including a trailing slash, or an empty string.
+     * @param depth         Depth of the directory below the listed directory.
+     */
+    FlatListJob(const QCString& path,
+                const QCString& relativePath,
+                int depth);
+    virtual ~FlatListJob();
+
+    const QCString& relativePath() const { return m_relativePath; }
+    int depth() const { return m_depth; }
+    const QValueList<Entry>& entries() const { return m_entries; }
+    const QValueList<QCString>& subDirs() const { return m_subDirs; }
+
+protected:
+    virtual void run();
+
+private:
+    QCString m_path;
+    QCString m_relativePath;
+    int m_depth;
+    QValueList<Entry> m_entries;
+    QValueList<QCString> m_subDirs;
+};
+
+FlatListJob::FlatListJob(const QCString& path,
+                         const QCString& relativePath,
+                         int depth) :
+    m_path(path.copy()),
+    m_relativePath(relativePath.copy()),
+    m_depth(depth)
+{
+}
+
+FlatListJob::~FlatListJob()
+{
+}
+
+void FlatListJob::run()
+{
+    DIR* dir = ::opendir(m_path.data());
+    if (dir == 0) {
+        return;
+    }
+
+    QCString filePath(m_path);
+    if (filePath.right(1) != "/") {
+        filePath += '/';
+    }
+    const uint dirLength = filePath.length();
+
+    struct dirent* dirEntry = 0;
+    while (!isCancelled() && ((dirEntry = ::readdir(dir)) != 0)) {
+        const char* name = dirEntry->d_name;
+        // Hidden entries are listed too, so that toggling the 'show hidden
+        // files' property does not require a new listing. The view filters them.
+        if ((qstrcmp(name, ".") == 0) || (qstrcmp(name, "..") == 0)) {
+            continue;
+        }
+
+        filePath.truncate(dirLength);
+        filePath += name;
+
+        struct stat buf;
+        if (::lstat(filePath.data(), &buf) != 0) {
+            continue;
+        }
+
+        if (S_ISDIR(buf.st_mode)) {
+            m_subDirs.append(QCString(name));
+            continue;
+        }
+
+        Entry entry;
+        entry.name = name;
+        if (S_ISLNK(buf.st_mode)) {
+            char linkDest[PATH_MAX + 1];
+            const int length = ::readlink(filePath.data(), linkDest, PATH_MAX);
+            if (length >= 0) {
+                linkDest[length] = '\0';
+                entry.linkDest = linkDest;
+            }
+
+            // links to directories are not followed
+            struct stat destBuf;
+            if (::stat(filePath.data(), &destBuf) == 0) {
+                if (S_ISDIR(destBuf.st_mode)) {
+                    continue;
+                }
+                buf.st_mode = (destBuf.st_mode & S_IFMT) | (buf.st_mode & ~S_IFMT);
+                buf.st_size = destBuf.st_size;
+            }
+        }
+        entry.mode = buf.st_mode;
+        entry.size = buf.st_size;
+        entry.mtime = buf.st_mtime;
+        entry.uid = buf.st_uid;
+        entry.gid = buf.st_gid;
+        m_entries.append(entry);
+    }
+    ::closedir(dir);
+}
+
+FlatLister::FlatLister(QObject* parent) :
+    QObject(parent),
+    m_maxDepth(0)
+{
+    m_items.setAutoDelete(true);
+
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotJobFinished(WorkerJob*)));
+}
+
+FlatLister::~FlatLister()
+{
+    stop();
+}
+
+void FlatLister::openURL(const KURL& url,
+                         int maxDepth,
+                         const QString& patterns)
+{
+    stop();
+    m_items.clear();
+
+    m_url = url;
+    m_maxDepth = maxDepth;
+
+    m_patterns.clear();
+    const QStringList patternList(QStringList::split(' ', patterns));
+    QStringList::ConstIterator it = patternList.begin();
+    const QStringList::ConstIterator end = patternList.end();
+    while (it != end) {
+        m_patterns.append(QRegExp(*it, true, true));
+        ++it;
+    }
+
+    startJob(QCString(""), 0);
+}
+
+void FlatLister::stop()
+{
+    WorkerPool::instance().cancelJobs(this);
+    m_pendingJobs.clear();
+}
+
+void FlatLister::slotJobFinished(WorkerJob* job)
+{
+    if (m_pendingJobs.findRef(static_cast<FlatListJob*>(job)) < 0) {
+        // the job has not been started by this lister
+        return;
+    }
+
+    // the job is deleted by the worker pool
+    FlatListJob* listJob = static_cast<FlatListJob*>(job);
+    m_pendingJobs.removeRef(listJob);
+
+    // read the sub directories in parallel, while the items are created
+    const int depth = listJob->depth();
+    if ((m_maxDepth <= 0) || (depth < m_maxDepth)) {
+        QValueList<QCString>::ConstIterator it = listJob->subDirs().begin();
+        const QValueList<QCString>::ConstIterator end = listJob->subDirs().end();
+        while (it != end) {
+            startJob(listJob->relativePath() + *it + '/', depth + 1);
+            ++it;
+        }
+    }
+
+    KURL dirURL(m_url);
+    dirURL.adjustPath(+1);
+
+    const QString relativePath(QFile::decodeName(listJob->relativePath()));
+    KFileItemList listedItems;
+
+    QValueList<FlatListJob::Entry>::ConstIterator it = listJob->entries().begin();
+    const QValueList<FlatListJob::Entry>::ConstIterator end = listJob->entries().end();
+    while (it != end) {
+        const FlatListJob::Entry& entry = *it;
+        const QString name(QFile::decodeName(entry.name));
+        if (!matchesPatterns(name)) {
+            ++it;
+            continue;
+        }
+
+        KIO::UDSEntry udsEntry;
+        KIO::UDSAtom atom;
+
+        atom.m_uds = KIO::UDS_NAME;
+        atom.m_str = relativePath + name;
+        udsEntry.append(atom);
+
+        atom.m_uds = KIO::UDS_FILE_TYPE;
+        atom.m_long = entry.mode & S_IFMT;
+        udsEntry.append(atom);
+
+        atom.m_uds = KIO::UDS_ACCESS;
+        atom.m_long = entry.mode & 07777;
+        udsEntry.append(atom);
+
+        atom.m_uds = KIO::UDS_SIZE;
+        atom.m_long = entry.size;
+        udsEntry.append(atom);
+
+        atom.m_uds = KIO::UDS_MODIFICATION_TIME;
+        atom.m_long = entry.mtime;
+        udsEntry.append(atom);
+
+        atom.m_uds = KIO::UDS_USER;
+        atom.m_str = userName(entry.uid);
+        udsEntry.append(atom);
+
+        atom.m_uds = KIO::UDS_GROUP;
+        atom.m_str = groupName(entry.gid);
+        udsEntry.append(atom);
+
+        if (!entry.linkDest.isEmpty()) {
+            atom.m_uds = KIO::UDS_LINK_DEST;
+            atom.m_str = QFile::decodeName(entry.linkDest);
+            udsEntry.append(atom);
+        }
+
+        // the item URL is the directory URL + the relative path
+        KFileItem* item = new KFileItem(udsEntry, dirURL, true, true);
+        m_items.append(item);
+        listedItems.append(item);
+        ++it;
+    }
+
+    if (!listedItems.isEmpty()) {
+        emit newItems(listedItems);
+    }
+
+    if (m_pendingJobs.isEmpty()) {
+        emit completed();
+    }
+}
+
+void FlatLister::startJob(const QCString& relativePath, int depth)
+{
+    const QCString path(QFile::encodeName(m_url.path(+1)) + relativePath);
+    FlatListJob* job = new FlatListJob(path, relativePath, depth);
+    m_pendingJobs.append(job);
+    WorkerPool::instance().enqueue(job, WorkerJob::Listing, this);
+}
+
+bool FlatLister::matchesPatterns(const QString& name) const
+{
+    if (m_patterns.isEmpty()) {
+        return true;
+    }
+
+    QValueList<QRegExp>::ConstIterator it = m_patterns.begin();
+    const QValueList<QRegExp>::ConstIterator end = m_patterns.end();
+    while (it != end) {
+        if ((*it).exactMatch(name)) {
+            return true;
+        }
+        ++it;
+    }
+    return false;
+}
+
+QString FlatLister::userName(uid_t uid)
+{
+    QMap<uid_t, QString>::ConstIterator it = m_userNames.find(uid);
+    if (it != m_userNames.end()) {
+        return *it;
+    }
+
+    const struct passwd* user = ::getpwuid(uid);
+    const QString name((user != 0) ? QString::fromLocal8Bit(user->pw_name) : QString::number(uid));
+    m_userNames.insert(uid, name);
+    return name;
+}
+
+QString FlatLister::groupName(gid_t gid)
+{
+    QMap<gid_t, QString>::ConstIterator it = m_groupNames.find(gid);
+    if (it != m_groupNames.end()) {
+        return *it;
+    }
+
+    const struct group* group = ::getgrgid(gid);
+    const QString name((group != 0) ? QString::fromLocal8Bit(group->gr_name) : QString::number(gid));
+    m_groupNames.insert(gid, name);
+    return name;
+}
+
+#include "flatlister.moc"
@@ -0,0 +1,118 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef FLATLISTER_H
+#define FLATLISTER_H
+
+#include <sys/types.h>
+
+#include <qmap.h>
+#include <qobject.h>
+#include <qptrlist.h>
+#include <qregexp.h>
+#include <qvaluelist.h>
+
+#include <kfileitem.h>
+#include <kurl.h>
+
+class FlatListJob;
+class WorkerJob;
+
+/**
+ * @brief Lists all files below a local directory as one flat list.
+ *
+ * Each directory of the tree is read by a FlatListJob inside the
+ * WorkerPool, so that several directories are read in parallel. As soon
+ * as a directory has been read, the items for its files are created and
+ * emitted by FlatLister::newItems(). The name of each item is the path
+ * relative to the listed directory (e. g. "2007/mail/spool.log"), hence
+ * the items can be shown by the usual views.
+ *
+ * Directories are traversed but not listed themselves. Symbolic links to
+ * directories are not followed. The traversal can be limited to a maximum
+ * depth and the listed files can be limited to a set of wildcard patterns.
+ *
+ * The created items are owned by the lister.
+ */
+class FlatLister : public QObject
+{
+    Q_OBJECT
+
+public:
+    FlatLister(QObject* parent);
+    virtual ~FlatLister();
+
+    /**
+     * Lists all files below the local directory \a url. Sub directories are
+     * only read up to the depth \a maxDepth, where 1 means that only the
+     * direct sub directories are read. If \a maxDepth is 0, the depth is
+     * unlimited. If \a patterns is not empty, only files whose name matches
+     * one of the space separated wildcard patterns (e. g. "*.log *.txt") are
+     * listed. Hidden files and directories are always listed, it is up to
+     * the view to filter them. A previous listing gets stopped and its
+     * items are deleted.
+     */
+    void openURL(const KURL& url, int maxDepth, const QString& patterns);
+
+    /** Stops the listing. The items, which have been listed already, are kept. */
+    void stop();
+
+    /** Returns true, if all directories have been read. */
+    bool isFinished() const { return m_pendingJobs.isEmpty(); }
+
+    /** Returns all items, which have been listed so far. */
+    const KFileItemList& items() const { return m_items; }
+
+    const KURL& url() const { return m_url; }
+
+signals:
+    /** Is emitted if the files \a items of a directory have been listed. */
+    void newItems(const KFileItemList& items);
+
+    /** Is emitted if all directories have been read. */
+    void completed();
+
+private slots:
+    /** Creates the items for the files, which have been read by the job \a job. */
+    void slotJobFinished(WorkerJob* job);
+
+private:
+    /** Enqueues a job, which reads the directory \a relativePath of the listed directory. */
+    void startJob(const QCString& relativePath, int depth);
+
+    /** Returns true, if the file name \a name matches one of the patterns. */
+    bool matchesPatterns(const QString& name) const;
+
+    /** Returns the name of the user \a uid. The names are cached. */
+    QString userName(uid_t uid);
+
+    /** Returns the name of the group \a gid. The names are cached. */
+    QString groupName(gid_t gid);
+
+    KURL m_url;
+    int m_maxDepth;
+    QValueList<QRegExp> m_patterns;
+    KFileItemList m_items;
+    QPtrList<FlatListJob> m_pendingJobs;
+    QMap<uid_t, QString> m_userNames;
+    QMap<gid_t, QString> m_groupNames;
+};
+
+#endif
@@ -0,0 +1,753 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "foldersizeservice.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <qapplication.h>
+#include <qdatastream.h>
+#include <qdatetime.h>
+#include <qfile.h>
+#include <qstringlist.h>
+#include <qtimer.h>
+
+#include <kstandarddirs.h>
+#include <kurl.h>
+
+// Increase the version if the format of the cached sizes changes.
+#define CACHE_MAGIC   0xD3A1F01D
+#define CACHE_VERSION 1
+
+// Maximum number of directories, which are kept inside the cache.
+#define MAX_NODES 250000
+
+// Minimum time in milliseconds between two progress notifications of a job.
+#define PROGRESS_INTERVAL 250
+
+// A modification time, which never matches the modification time of a directory.
+#define INVALID_MTIME -1
+
+static const int FolderSizeProgressEvent = QEvent::User + 29;
+
+/**
+ * @brief Calculates the size of one folder by a thread of the worker pool.
+ *
+ * The job walks through the directory tree and reads only those directories,
+ * which are not part of the cache snapshot or which have been modified since
+ * the snapshot has been created. The resulting nodes are fetched by
+ * FolderSizeService inside the GUI thread.
+ */
+class FolderSizeJob : public WorkerJob
+{
+public:
+    /**
+     * @param path      Encoded local path of the folder.
+     * @param snapshot  Deep copy of the cached nodes of the folder and all sub folders.
+     * @param receiver  Object, which receives the progress notifications.
+     */
+    FolderSizeJob(const QCString& path,
+                  const QMap<QCString, FolderSizeService::Node>& snapshot,
+                  QObject* receiver);
+    virtual ~FolderSizeJob();
+
+    const QCString& path() const { return m_path; }
+    KIO::filesize_t size() const { return m_size; }
+    const QMap<QCString, FolderSizeService::Node>& nodes() const { return m_nodes; }
+
+protected:
+    virtual void run();
+
+private:
+    /**
+     * Returns the size of the directory \a path including all sub directories,
+     * which are located on the device \a device.
+     */
+    KIO::filesize_t scan(const QCString& path, dev_t device);
+
+    /** Posts a progress notification to the receiver, if the last one is old enough. */
+    void reportProgress();
+
+    static QCString childPath(const QCString& path, const char* name);
+
+    QCString m_path;
+    QMap<QCString, FolderSizeService::Node> m_snapshot;
+    QMap<QCString, FolderSizeService::Node> m_nodes;
+    KIO::filesize_t m_size;
+    KIO::filesize_t m_countedSize;
+    QObject* m_receiver;
+    QTime m_progressTime;
+};
+
+/** Progress notification of a FolderSizeJob, which is posted to the GUI thread. */
+class FolderSizeProgress : public QCustomEvent
+{
+public:
+    FolderSizeProgress(FolderSizeJob* job, KIO::filesize_t size) :
+        QCustomEvent(FolderSizeProgressEvent),
+        m_job(job),
+        m_size(size)
+    {
+    }
+
+    FolderSizeJob* job() const { return m_job; }
+    KIO::filesize_t size() const { return m_size; }
+
+private:
+    FolderSizeJob* m_job;
+    KIO::filesize_t m_size;
+};
+
+FolderSizeJob::FolderSizeJob(const QCString& path,
+                             const QMap<QCString, FolderSizeService::Node>& snapshot,
+                             QObject* receiver) :
+    m_path(path.copy()),
+    m_snapshot(snapshot),
+    m_size(0),
+    m_countedSize(0),
+    m_receiver(receiver)
+{
+}
+
+FolderSizeJob::~FolderSizeJob()
+{
+}
+
+void FolderSizeJob::run()
+{
+    struct stat buf;
+    if (::lstat(m_path.data(), &buf) != 0) {
+        return;
+    }
+
+    m_progressTime.start();
+    m_size = scan(m_path, buf.st_dev);
+}
+
+KIO::filesize_t FolderSizeJob::scan(const QCString& path, dev_t device)
+{
+    struct stat buf;
+    if (isCancelled() || (::lstat(path.data(), &buf) != 0) || !S_ISDIR(buf.st_mode)) {
+        return 0;
+    }
+
+    FolderSizeService::Node node;
+    node.device = buf.st_dev;
+    node.inode = buf.st_ino;
+    node.mtime = buf.st_mtime;
+    node.ownSize = 0;
+    node.isTotalValid = true;
+    node.isVerified = true;
+
+    QMap<QCString, FolderSizeService::Node>::ConstIterator cached = m_snapshot.find(path);
+    if ((cached != m_snapshot.end()) &&
+        ((*cached).device == node.device) &&
+        ((*cached).inode == node.inode) &&
+        ((*cached).mtime == node.mtime)) {
+        // No item has been added to or removed from the directory since the
+        // snapshot has been created. Only the sub directories must be checked.
+        node.ownSize = (*cached).ownSize;
+        node.subDirs = (*cached).subDirs;
+    }
+    else {
+        DIR* dir = ::opendir(path.data());
+        if (dir == 0) {
+            return 0;
+        }
+
+        struct dirent* entry = 0;
+        while (((entry = ::readdir(dir)) != 0) && !isCancelled()) {
+            const char* name = entry->d_name;
+            if ((qstrcmp(name, ".") == 0) || (qstrcmp(name, "..") == 0)) {
+                continue;
+            }
+
+            struct stat childBuf;
+            if (::lstat(childPath(path, name).data(), &childBuf) != 0) {
+                continue;
+            }
+
+            if (S_ISDIR(childBuf.st_mode)) {
+                if (childBuf.st_dev == device) {
+                    node.subDirs.append(QCString(name));
+                }
+            }
+            else {
+                node.ownSize += childBuf.st_size;
+            }
+        }
+        ::closedir(dir);
+    }
+
+    m_countedSize += node.ownSize;
+    reportProgress();
+
+    KIO::filesize_t totalSize = node.ownSize;
+    QValueList<QCString>::ConstIterator it = node.subDirs.begin();
+    const QValueList<QCString>::ConstIterator end = node.subDirs.end();
+    while ((it != end) && !isCancelled()) {
+        totalSize += scan(childPath(path, *it), device);
+        ++it;
+    }
+
+    node.totalSize = totalSize;
+    m_nodes.insert(path, node);
+    return totalSize;
+}
+
+void FolderSizeJob::reportProgress()
+{
+    if (m_progressTime.elapsed() >= PROGRESS_INTERVAL) {
+        m_progressTime.restart();
+        QApplication::postEvent(m_receiver, new FolderSizeProgress(this, m_countedSize));
+    }
+}
+
+QCString FolderSizeJob::childPath(const QCString& path, const char* name)
+{
+    QCString child(path);
+    if (child.right(1) != "/") {
+        child += '/';
+    }
+    child += name;
+    return child;
+}
+
+FolderSizeService& FolderSizeService::instance()
+{
+    static FolderSizeService* instance = 0;
+    if (instance == 0) {
+        instance = new FolderSizeService();
+    }
+    return *instance;
+}
+
+bool FolderSizeService::folderSize(const QString& path, KIO::filesize_t& size)
+{
+    loadCache();
+
+    NodeMap::ConstIterator it = m_nodes.find(QFile::encodeName(path));
+    if ((it == m_nodes.end()) || !(*it).isTotalValid) {
+        return false;
+    }
+
+    size = (*it).totalSize;
+    return true;
+}
+
+bool FolderSizeService::isCalculating(const QString& path, KIO::filesize_t& partialSize) const
+{
+    QMap<QString, Request>::ConstIterator it = m_requests.find(path);
+    if (it == m_requests.end()) {
+        return false;
+    }
+
+    partialSize = (*it).partialSize;
+    return true;
+}
+
+void FolderSizeService::requestSize(const QString& path,
+                                    WorkerJob::Priority priority,
+                                    const void* owner)
+{
+    loadCache();
+
+    const QCString encodedPath(QFile::encodeName(path));
+    markAsUsed(encodedPath);
+
+    NodeMap::ConstIterator nodeIt = m_nodes.find(encodedPath);
+    if ((nodeIt != m_nodes.end()) && (*nodeIt).isTotalValid && (*nodeIt).isVerified) {
+        // The size has been calculated during this session and later changes
+        // have been reported by the notifications. Only the folder itself is
+        // checked, as it might have been replaced meanwhile.
+        struct stat buf;
+        if ((::lstat(encodedPath.data(), &buf) == 0) &&
+            (static_cast<Q_UINT64>(buf.st_ino) == (*nodeIt).inode) &&
+            (static_cast<Q_INT64>(buf.st_mtime) == (*nodeIt).mtime)) {
+            return;
+        }
+        invalidate(path);
+    }
+
+    QMap<QString, Request>::Iterator it = m_requests.find(path);
+    if (it != m_requests.end()) {
+        Request& request = *it;
+        if (!request.owners.contains(owner)) {
+            request.owners.append(owner);
+        }
+        if (priority < request.priority) {
+            // restart the calculation with the higher priority
+            WorkerPool::instance().cancel(request.job);
+            request.priority = priority;
+            startJob(path, request);
+        }
+        return;
+    }
+
+    Request request;
+    request.job = 0;
+    request.priority = priority;
+    request.partialSize = 0;
+    request.owners.append(owner);
+    startJob(path, request);
+    m_requests.insert(path, request);
+}
+
+void FolderSizeService::cancelRequests(const void* owner)
+{
+    QStringList cancelledPaths;
+
+    QMap<QString, Request>::Iterator it = m_requests.begin();
+    const QMap<QString, Request>::Iterator end = m_requests.end();
+    while (it != end) {
+        Request& request = *it;
+        request.owners.remove(owner);
+        if (request.owners.isEmpty()) {
+            WorkerPool::instance().cancel(request.job);
+            cancelledPaths.append(it.key());
+        }
+        ++it;
+    }
+
+    QStringList::ConstIterator pathIt = cancelledPaths.begin();
+    const QStringList::ConstIterator pathEnd = cancelledPaths.end();
+    while (pathIt != pathEnd) {
+        m_requests.remove(*pathIt);
+        ++pathIt;
+    }
+}
+
+void FolderSizeService::invalidate(const QString& path)
+{
+    loadCache();
+
+    const QCString encodedPath(QFile::encodeName(path));
+    NodeMap::Iterator it = m_nodes.find(encodedPath);
+    if (it != m_nodes.end()) {
+        // The node is kept, so that the sub directories can be reused
+        // by the next calculation. Only the directory itself is read again.
+        (*it).mtime = INVALID_MTIME;
+        (*it).isTotalValid = false;
+        (*it).isVerified = false;
+        scheduleSave();
+    }
+    invalidateParents(encodedPath);
+}
+
+void FolderSizeService::FilesAdded(const KURL& directory)
+{
+    const QString path(localPath(directory));
+    if (!path.isNull()) {
+        invalidate(path);
+    }
+}
+
+void FolderSizeService::FilesRemoved(const KURL::List& fileList)
+{
+    KURL::List::ConstIterator it = fileList.begin();
+    const KURL::List::ConstIterator end = fileList.end();
+    while (it != end) {
+        const QString path(localPath(*it));
+        if (!path.isNull()) {
+            loadCache();
+            const QCString encodedPath(QFile::encodeName(path));
+            removeSubTree(encodedPath);
+            invalidate(QFile::decodeName(parentPath(encodedPath)));
+        }
+        ++it;
+    }
+}
+
+void FolderSizeService::FilesChanged(const KURL::List& fileList)
+{
+    // The size of a changed file is part of the size of its directory.
+    KURL::List::ConstIterator it = fileList.begin();
+    const KURL::List::ConstIterator end = fileList.end();
+    while (it != end) {
+        const QString path(localPath(*it));
+        if (!path.isNull()) {
+            invalidate(QFile::decodeName(parentPath(QFile::encodeName(path))));
+        }
+        ++it;
+    }
+}
+
+void FolderSizeService::FileRenamed(const KURL& src, const KURL& dst)
+{
+    KURL::List fileList;
+    fileList.append(src);
+    FilesRemoved(fileList);
+
+    const QString dstPath(localPath(dst));
+    if (!dstPath.isNull()) {
+        invalidate(QFile::decodeName(parentPath(QFile::encodeName(dstPath))));
+    }
+}
+
+FolderSizeService::FolderSizeService() :
+    QObject(0),
+    KDirNotify(),
+    m_loaded(false),
+    m_usageCounter(0),
+    m_saveTimer(0)
+{
+    m_saveTimer = new QTimer(this);
+    connect(m_saveTimer, SIGNAL(timeout()),
+            this, SLOT(saveCache()));
+    connect(qApp, SIGNAL(aboutToQuit()),
+            this, SLOT(saveCache()));
+
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotJobFinished(WorkerJob*)));
+}
+
+FolderSizeService::~FolderSizeService()
+{
+    QMap<QString, Request>::Iterator it = m_requests.begin();
+    const QMap<QString, Request>::Iterator end = m_requests.end();
+    while (it != end) {
+        WorkerPool::instance().cancel((*it).job);
+        ++it;
+    }
+    m_requests.clear();
+
+    saveCache();
+}
+
+void FolderSizeService::customEvent(QCustomEvent* event)
+{
+    if (event->type() != FolderSizeProgressEvent) {
+        return;
+    }
+
+    const FolderSizeProgress* progress = static_cast<FolderSizeProgress*>(event);
+    QMap<QString, Request>::Iterator it = m_requests.begin();
+    const QMap<QString, Request>::Iterator end = m_requests.end();
+    while (it != end) {
+        if ((*it).job == progress->job()) {
+            (*it).partialSize = progress->size();
+            emit sizeAvailable(it.key(), progress->size(), false);
+            return;
+        }
+        ++it;
+    }
+}
+
+void FolderSizeService::slotJobFinished(WorkerJob* job)
+{
+    QMap<QString, Request>::Iterator it = m_requests.begin();
+    const QMap<QString, Request>::Iterator end = m_requests.end();
+    while ((it != end) && (static_cast<WorkerJob*>((*it).job) != job)) {
+        ++it;
+    }
+    if (it == end) {
+        // the job is no folder size job
+        return;
+    }
+
+    // the job is deleted by the worker pool
+    const FolderSizeJob* sizeJob = (*it).job;
+    const QString path(it.key());
+    m_requests.remove(it);
+
+    const QCString encodedPath(sizeJob->path());
+    NodeMap::ConstIterator oldIt = m_nodes.find(encodedPath);
+    const bool sizeChanged = (oldIt == m_nodes.end()) ||
+                             !(*oldIt).isTotalValid ||
+                             ((*oldIt).totalSize != sizeJob->size());
+
+    // Replace the previous nodes of the tree, so that the nodes of
+    // removed sub directories don't remain inside the cache.
+    removeSubTree(encodedPath);
+
+    const NodeMap& nodes = sizeJob->nodes();
+    evictSubTrees(nodes.count(), encodedPath);
+    m_roots.replace(encodedPath, ++m_usageCounter);
+    NodeMap::ConstIterator nodeIt = nodes.begin();
+    const NodeMap::ConstIterator nodeEnd = nodes.end();
+    while (nodeIt != nodeEnd) {
+        m_nodes.insert(nodeIt.key(), *nodeIt);
+        ++nodeIt;
+    }
+
+    if (sizeChanged) {
+        invalidateParents(encodedPath);
+    }
+    scheduleSave();
+
+    emit sizeAvailable(path, sizeJob->size(), true);
+}
+
+void FolderSizeService::saveCache()
+{
+    m_saveTimer->stop();
+    if (!m_loaded) {
+        return;
+    }
+
+    QString fileName(KGlobal::dirs()->saveLocation("cache", "d3lphin/"));
+    fileName.append("foldersizes");
+    QFile file(fileName);
+    if (!file.open(IO_WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << static_cast<Q_UINT32>(CACHE_MAGIC)
+           << static_cast<Q_UINT32>(CACHE_VERSION)
+           << static_cast<Q_UINT32>(m_nodes.count());
+
+    NodeMap::ConstIterator it = m_nodes.begin();
+    const NodeMap::ConstIterator end = m_nodes.end();
+    while (it != end) {
+        const Node& node = *it;
+        stream << it.key()
+               << node.device
+               << node.inode
+               << node.mtime
+               << static_cast<Q_UINT64>(node.ownSize)
+               << static_cast<Q_UINT64>(node.totalSize)
+               << static_cast<Q_UINT8>(node.isTotalValid ? 1 : 0)
+               << node.subDirs;
+        ++it;
+    }
+    file.close();
+}
+
+void FolderSizeService::loadCache()
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    QString fileName(KGlobal::dirs()->saveLocation("cache", "d3lphin/"));
+    fileName.append("foldersizes");
+    QFile file(fileName);
+    if (!file.open(IO_ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    Q_UINT32 magic = 0;
+    Q_UINT32 version = 0;
+    Q_UINT32 count = 0;
+    stream >> magic >> version >> count;
+    if ((magic != CACHE_MAGIC) || (version != CACHE_VERSION)) {
+        return;
+    }
+
+    for (Q_UINT32 i = 0; (i < count) && !stream.atEnd(); ++i) {
+        QCString path;
+        Node node;
+        Q_UINT64 ownSize = 0;
+        Q_UINT64 totalSize = 0;
+        Q_UINT8 isTotalValid = 0;
+        stream >> path
+               >> node.device
+               >> node.inode
+               >> node.mtime
+               >> ownSize
+               >> totalSize
+               >> isTotalValid
+               >> node.subDirs;
+        node.ownSize = ownSize;
+        node.totalSize = totalSize;
+        node.isTotalValid = (isTotalValid != 0);
+
+        // the cached sizes are shown, but checked again on the next request
+        node.isVerified = false;
+        m_nodes.insert(path, node);
+    }
+
+    // The usage of the trees is not stored. Each directory without cached
+    // parent is the root of a calculated tree, which has not been used yet.
+    NodeMap::ConstIterator it = m_nodes.begin();
+    const NodeMap::ConstIterator end = m_nodes.end();
+    while (it != end) {
+        const QCString parent(parentPath(it.key()));
+        if (parent.isNull() || !m_nodes.contains(parent)) {
+            m_roots.insert(it.key(), 0);
+        }
+        ++it;
+    }
+}
+
+FolderSizeService::NodeMap FolderSizeService::subTree(const QCString& path) const
+{
+    NodeMap nodes;
+
+    QValueList<QCString> pendingPaths;
+    pendingPaths.append(path);
+    while (!pendingPaths.isEmpty()) {
+        const QCString currentPath(pendingPaths.first());
+        pendingPaths.pop_front();
+
+        NodeMap::ConstIterator it = m_nodes.find(currentPath);
+        if (it == m_nodes.end()) {
+            continue;
+        }
+
+        // The implicitly shared data of Qt may not be shared between
+        // threads, hence all strings are copied.
+        Node node(*it);
+        node.subDirs.clear();
+        QValueList<QCString>::ConstIterator subDirIt = (*it).subDirs.begin();
+        const QValueList<QCString>::ConstIterator subDirEnd = (*it).subDirs.end();
+        while (subDirIt != subDirEnd) {
+            node.subDirs.append((*subDirIt).copy());
+            QCString subDirPath(currentPath);
+            if (subDirPath.right(1) != "/") {
+                subDirPath += '/';
+            }
+            subDirPath += *subDirIt;
+            pendingPaths.append(subDirPath);
+            ++subDirIt;
+        }
+        nodes.insert(currentPath.copy(), node);
+    }
+
+    return nodes;
+}
+
+void FolderSizeService::removeSubTree(const QCString& path, bool keepRoots)
+{
+    QValueList<QCString> pendingPaths;
+    pendingPaths.append(path);
+    while (!pendingPaths.isEmpty()) {
+        const QCString currentPath(pendingPaths.first());
+        pendingPaths.pop_front();
+
+        NodeMap::Iterator it = m_nodes.find(currentPath);
+        if (it == m_nodes.end()) {
+            continue;
+        }
+
+        QValueList<QCString>::ConstIterator subDirIt = (*it).subDirs.begin();
+        const QValueList<QCString>::ConstIterator subDirEnd = (*it).subDirs.end();
+        while (subDirIt != subDirEnd) {
+            QCString subDirPath(currentPath);
+            if (subDirPath.right(1) != "/") {
+                subDirPath += '/';
+            }
+            subDirPath += *subDirIt;
+            if (!keepRoots || !m_roots.contains(subDirPath)) {
+                pendingPaths.append(subDirPath);
+            }
+            ++subDirIt;
+        }
+        m_nodes.remove(it);
+        m_roots.remove(currentPath);
+    }
+}
+
+void FolderSizeService::markAsUsed(const QCString& path)
+{
+    QCString currentPath(path);
+    while (!currentPath.isNull()) {
+        QMap<QCString, uint>::Iterator it = m_roots.find(currentPath);
+        if (it != m_roots.end()) {
+            *it = ++m_usageCounter;
+            return;
+        }
+        if (!m_nodes.contains(currentPath)) {
+            // the path is not part of a cached tree
+            return;
+        }
+        currentPath = parentPath(currentPath);
+    }
+}
+
+void FolderSizeService::evictSubTrees(uint count, const QCString& keptRoot)
+{
+    // If the tree of one folder exceeds the maximum size, it is kept anyway.
+    while (m_nodes.count() + count > MAX_NODES) {
+        QMap<QCString, uint>::Iterator oldestIt = m_roots.end();
+        QMap<QCString, uint>::Iterator it = m_roots.begin();
+        const QMap<QCString, uint>::Iterator end = m_roots.end();
+        while (it != end) {
+            if ((it.key() != keptRoot) &&
+                ((oldestIt == end) || (*it < *oldestIt))) {
+                oldestIt = it;
+            }
+            ++it;
+        }
+        if (oldestIt == end) {
+            return;
+        }
+
+        // the trees of the more recently used folders inside the tree are kept
+        const QCString root(oldestIt.key());
+        m_roots.remove(oldestIt);
+        removeSubTree(root, true);
+    }
+}
+
+void FolderSizeService::invalidateParents(const QCString& path)
+{
+    QCString parent(parentPath(path));
+    while (!parent.isNull()) {
+        NodeMap::Iterator it = m_nodes.find(parent);
+        if (it == m_nodes.end()) {
+            // the parents of a directory are only cached if the directory is cached
+            break;
+        }
+        (*it).isTotalValid = false;
+        parent = parentPath(parent);
+    }
+}
+
+void FolderSizeService::startJob(const QString& path, Request& request)
+{
+    FolderSizeJob* job = new FolderSizeJob(QFile::encodeName(path),
+                                           subTree(QFile::encodeName(path)),
+                                           this);
+    request.job = job;
+    request.partialSize = 0;
+    WorkerPool::instance().enqueue(job, request.priority);
+}
+
+void FolderSizeService::scheduleSave()
+{
+    if (!m_saveTimer->isActive()) {
+        m_saveTimer->start(10000, true);
+    }
+}
+
+QString FolderSizeService::localPath(const KURL& url)
+{
+    if (!url.isLocalFile()) {
+        return QString::null;
+    }
+    return url.path(-1);
+}
+
+QCString FolderSizeService::parentPath(const QCString& path)
+{
+    const int pos = path.findRev('/');
+    if ((pos < 0) || (path == "/")) {
+        return QCString();
+    }
+    return (pos == 0) ? QCString("/") : path.left(pos);
+}
+
+#include "foldersizeservice.moc"
@@ -0,0 +1,242 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef FOLDERSIZESERVICE_H
+#define FOLDERSIZESERVICE_H
+
+#include <qcstring.h>
+#include <qmap.h>
+#include <qobject.h>
+#include <qvaluelist.h>
+
+#include <kdirnotify.h>
+#include <kio/global.h>
+
+#include "workerpool.h"
+
+class QTimer;
+class FolderSizeJob;
+
+/**
+ * @brief Calculates the recursive sizes of local folders in the background.
+ *
+ * The size of a folder is the summarized size of all files inside the
+ * folder and its sub folders. Sub folders, which are located on another
+ * file system, are not included. The sizes are calculated by a
+ * FolderSizeJob inside the WorkerPool and cached for each directory
+ * of the scanned tree. For each directory the device, the i-node and the
+ * modification time are remembered together with the size of the files
+ * inside the directory and the names of the sub directories.
+ *
+ * If the size of a folder is requested again, only the directories are
+ * checked: a directory with an unchanged i-node and modification time is
+ * not read again. The cache is stored inside the cache directory of
+ * Dolphin, so that even after a restart the size of a large tree is
+ * available after checking its directories. Changes of files, which don't
+ * touch the modification time of the parent directory (e. g. appending data),
+ * are detected by the KDirNotify notifications and the changes reported by
+ * the dir listers of the views. If the cache is full, the trees which have
+ * not been requested for the longest time are dropped.
+ *
+ * As long as a folder is calculated, the signal FolderSizeService::sizeAvailable()
+ * is emitted periodically with the size of the items which have been
+ * counted so far.
+ *
+ * Sample code:
+ * \code
+ * FolderSizeService& service = FolderSizeService::instance();
+ * KIO::filesize_t size = 0;
+ * if (!service.folderSize("/home/peter", size)) {
+ *     service.requestSize("/home/peter", WorkerJob::Preview, this);
+ *     // wait for FolderSizeService::sizeAvailable()
+ * }
+ * \endcode
+ */
+class FolderSizeService : public QObject, public KDirNotify
+{
+    Q_OBJECT
+
+public:
+    static FolderSizeService& instance();
+
+    /**
+     * Returns true, if the size of the local folder \a path is known and
+     * writes the size to \a size. False is returned if the size has not
+     * been calculated yet or if the folder has been changed since the
+     * calculation.
+     */
+    bool folderSize(const QString& path, KIO::filesize_t& size);
+
+    /**
+     * Returns true, if the size of the folder \a path is currently calculated.
+     * The size of the items, which have been counted so far, is written to
+     * \a partialSize.
+     */
+    bool isCalculating(const QString& path, KIO::filesize_t& partialSize) const;
+
+    /**
+     * Requests the calculation of the size of the local folder \a path with
+     * the priority class \a priority. Nothing happens, if a valid size has
+     * already been calculated during this session. If the folder is already
+     * calculated with a lower priority, the calculation is restarted with
+     * the priority \a priority. All requests of \a owner can be cancelled by
+     * FolderSizeService::cancelRequests().
+     */
+    void requestSize(const QString& path, WorkerJob::Priority priority, const void* owner);
+
+    /**
+     * Cancels all requests of \a owner. A calculation is only cancelled
+     * if it has not been requested by another owner too.
+     */
+    void cancelRequests(const void* owner);
+
+    /**
+     * Marks the cached size of the local directory \a path and the sizes
+     * of all parent directories as invalid. Should be invoked if items
+     * inside the directory have been added, removed or changed.
+     */
+    void invalidate(const QString& path);
+
+    /** @see KDirNotify::FilesAdded() */
+    virtual void FilesAdded(const KURL& directory);
+
+    /** @see KDirNotify::FilesRemoved() */
+    virtual void FilesRemoved(const KURL::List& fileList);
+
+    /** @see KDirNotify::FilesChanged() */
+    virtual void FilesChanged(const KURL::List& fileList);
+
+    /** @see KDirNotify::FileRenamed() */
+    virtual void FileRenamed(const KURL& src, const KURL& dst);
+
+signals:
+    /**
+     * Is emitted if the size \a size of the folder \a path is available. If
+     * \a isComplete is false, the folder is still calculated and \a size
+     * only contains the size of the items, which have been counted so far.
+     */
+    void sizeAvailable(const QString& path, KIO::filesize_t size, bool isComplete);
+
+protected:
+    FolderSizeService();
+    virtual ~FolderSizeService();
+
+    /** @see QObject::customEvent() */
+    virtual void customEvent(QCustomEvent* event);
+
+private slots:
+    /** Takes over the sizes calculated by the folder size job \a job. */
+    void slotJobFinished(WorkerJob* job);
+
+    /** Writes the cached sizes to the cache directory of Dolphin. */
+    void saveCache();
+
+private:
+    /** Contains the cached information of one directory. */
+    struct Node
+    {
+        Q_UINT64 device;
+        Q_UINT64 inode;
+        Q_INT64 mtime;
+
+        /** Summarized size of all items inside the directory, which are no directories. */
+        KIO::filesize_t ownSize;
+
+        /** Size of the directory including all sub directories. */
+        KIO::filesize_t totalSize;
+
+        /** Is false, if the total size must be calculated again. */
+        bool isTotalValid;
+
+        /** Is true, if the directory has been checked during this session. */
+        bool isVerified;
+
+        /** Names of the sub directories, which are located on the same file system. */
+        QValueList<QCString> subDirs;
+    };
+
+    typedef QMap<QCString, Node> NodeMap;
+
+    /** Contains the state of a pending calculation. */
+    struct Request
+    {
+        FolderSizeJob* job;
+        WorkerJob::Priority priority;
+        KIO::filesize_t partialSize;
+        QValueList<const void*> owners;
+    };
+
+    /** Reads the cached sizes on the first access. */
+    void loadCache();
+
+    /**
+     * Returns deep copies of the nodes of the directory \a path and all
+     * of its sub directories, so that they can be passed to a worker thread.
+     */
+    NodeMap subTree(const QCString& path) const;
+
+    /**
+     * Removes the nodes of the directory \a path and all of its sub directories.
+     * If \a keepRoots is true, the sub trees of other calculated folders
+     * (see FolderSizeService::m_roots) are kept.
+     */
+    void removeSubTree(const QCString& path, bool keepRoots = false);
+
+    /** Marks the calculated folder, whose tree contains \a path, as recently used. */
+    void markAsUsed(const QCString& path);
+
+    /**
+     * Removes the least recently used trees until \a count nodes can be
+     * added without exceeding the maximum size of the cache. The tree of
+     * the folder \a keptRoot is not removed.
+     */
+    void evictSubTrees(uint count, const QCString& keptRoot);
+
+    /** Marks the total sizes of all parent directories of \a path as invalid. */
+    void invalidateParents(const QCString& path);
+
+    /** Starts a folder size job for \a path and remembers it inside \a request. */
+    void startJob(const QString& path, Request& request);
+
+    /** Schedules writing the cache after a short delay. */
+    void scheduleSave();
+
+    /** Returns the local path of \a url without trailing slash, or a null string. */
+    static QString localPath(const KURL& url);
+
+    /** Returns the parent directory of \a path. */
+    static QCString parentPath(const QCString& path);
+
+    friend class FolderSizeJob;  // allow to use Node
+
+    bool m_loaded;
+    NodeMap m_nodes;
+
+    /**
+     * Maps the path of each calculated folder, whose tree is part of the cache,
+     * to the value of m_usageCounter when the folder has been used the last time.
+     */
+    QMap<QCString, uint> m_roots;
+    uint m_usageCounter;
+    QMap<QString, Request> m_requests;
+    QTimer* m_saveTimer;
+};
+
+#endif
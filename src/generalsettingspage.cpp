@@ -33,6 +33,7 @@
 #include <qpushbutton.h>
 #include <kfiledialog.h>
 #include <qradiobutton.h>
+#include <qspinbox.h>
 
 #include "dolphinsettings.h"
 #include "dolphin.h"
@@ -111,6 +112,23 @@ GeneralSettingsPage::GeneralSettingsPage(QWidget* parent) :
     m_saveView = new QCheckBox(i18n("Save view properties for each folder"), vBox);
     m_saveView->setChecked(settings.isSaveView());
 
+    // create 'Verify copied files' checkbox
+    m_verifyCopies = new QCheckBox(i18n("Verify copied local files"), vBox);
+    m_verifyCopies->setChecked(settings.isVerifyCopiesEnabled());
+
+    // create 'Flat View' group
+    QGroupBox* flatViewGroup = new QGroupBox(2, Qt::Horizontal, i18n("Flat View"), vBox);
+    flatViewGroup->setSizePolicy(sizePolicy);
+    flatViewGroup->setMargin(margin);
+
+    new QLabel(i18n("Maximum depth:"), flatViewGroup);
+    m_flatViewMaxDepth = new QSpinBox(0, 99, 1, flatViewGroup);
+    m_flatViewMaxDepth->setSpecialValueText(i18n("Unlimited"));
+    m_flatViewMaxDepth->setValue(settings.flatViewMaxDepth());
+
+    new QLabel(i18n("File patterns:"), flatViewGroup);
+    m_flatViewPatterns = new QLineEdit(settings.flatViewPatterns(), flatViewGroup);
+
     // Add a dummy widget with no restriction regarding
     // a vertical resizing. This assures that the dialog layout
     // is not stretched vertically.
@@ -146,6 +164,9 @@ void GeneralSettingsPage::applySettings()
     settings.setViewSplit(m_startSplit->isChecked());
     settings.setSaveView(m_saveView->isChecked());
     settings.setURLEditable(m_startEditable->isChecked());
+    settings.setVerifyCopiesEnabled(m_verifyCopies->isChecked());
+    settings.setFlatViewMaxDepth(m_flatViewMaxDepth->value());
+    settings.setFlatViewPatterns(m_flatViewPatterns->text().simplifyWhiteSpace());
 }
 
 void GeneralSettingsPage::selectHomeURL()
@@ -24,6 +24,7 @@
 class QLineEdit;
 class QRadioButton;
 class QCheckBox;
+class QSpinBox;
 
 /**
  * @brief Page for the 'General' settings of the Dolphin settings dialog.
@@ -58,6 +59,9 @@ private:
     QCheckBox* m_startSplit;
     QCheckBox* m_startEditable;
     QCheckBox* m_saveView;
+    QCheckBox* m_verifyCopies;
+    QSpinBox* m_flatViewMaxDepth;
+    QLineEdit* m_flatViewPatterns;
 };
 
 #endif
@@ -23,6 +23,7 @@
 #include <qlayout.h>
 #include <qpixmap.h>
 #include <qlabel.h>
+#include <qmutex.h>
 #include <qtimer.h>
 #include <qpushbutton.h>
 #include <qvbox.h>
@@ -32,6 +33,7 @@
 #include <qfontmetrics.h>
 #include <qgrid.h>
 #include <qhgroupbox.h>
+#include <qdatetime.h>
 
 #include <kbookmarkmanager.h>
 #include <klocale.h>
@@ -45,6 +47,11 @@
 #include "dolphin.h"
 #include "pixmapviewer.h"
 #include "dolphinsettings.h"
+#include "metainfojob.h"
+#include "metainfoservice.h"
+#include "mimetypehistogram.h"
+#include "servicemenuindex.h"
+#include "workerpool.h"
 
 InfoSidebarPage::InfoSidebarPage(QWidget* parent) :
     SidebarPage(parent),
@@ -55,7 +62,8 @@ InfoSidebarPage::InfoSidebarPage(QWidget* parent) :
     m_name(0),
     m_currInfoLineIdx(0),
     m_infoGrid(0),
-    m_actionBox(0)
+    m_actionBox(0),
+    m_metaInfoJob(0)
 {
     const int spacing = KDialog::spacingHint();
 
@@ -109,11 +117,15 @@ InfoSidebarPage::InfoSidebarPage(QWidget* parent) :
     connect(&Dolphin::mainWin(), SIGNAL(selectionChanged()),
             this, SLOT(showItemInfo()));
 
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotMetaInfoFinished(WorkerJob*)));
+
     connectToActiveView();
 }
 
 InfoSidebarPage::~InfoSidebarPage()
 {
+    cancelRequest();
 }
 
 void InfoSidebarPage::activeViewChanged()
@@ -149,8 +161,8 @@ void InfoSidebarPage::showItemInfo()
 
     // show the preview...
     DolphinView* view = Dolphin::mainWin().activeView();
-    const KFileItemList* selectedItems = view->selectedItems();
-    if ((selectedItems != 0) && selectedItems->count() > 1) {
+    const int selectedCount = view->selectionHistogram().itemCount();
+    if (selectedCount > 1) {
         m_multipleSelection = true;
     }
 
@@ -160,7 +172,7 @@ void InfoSidebarPage::showItemInfo()
                                            KIcon::NoGroup,
                                            KIcon::SizeEnormous);
         m_preview->setPixmap(icon);
-        m_name->setText(i18n("%n items selected", "%n items selected", selectedItems->count()));
+        m_name->setText(i18n("%n items selected", "%n items selected", selectedCount));
     }
     else if (!applyBookmark()) {
         // try to get a preview pixmap from the item...
@@ -211,6 +223,30 @@ void InfoSidebarPage::gotPreview(const KFileItem* /* item */,
     }
 }
 
+void InfoSidebarPage::slotMetaInfoFinished(WorkerJob* job)
+{
+    if (job != m_metaInfoJob) {
+        return;
+    }
+    m_metaInfoJob = 0;
+
+    const MetaInfoJob* metaInfoJob = static_cast<MetaInfoJob*>(job);
+    if (!metaInfoJob->isValid() || metaInfoJob->isUnchanged()) {
+        // the cached meta information is already shown
+        return;
+    }
+
+    // the meta information is shared with the details view
+    const MetaInfoJob::Info& info = metaInfoJob->info();
+    if (!info.isDir) {
+        MetaInfoService::instance().insert(metaInfoJob->path(), info);
+    }
+
+    beginInfoLines();
+    addFileInfoLines(info);
+    endInfoLines();
+}
+
 void InfoSidebarPage::startService(int index)
 {
     DolphinView* view = Dolphin::mainWin().activeView();
@@ -265,6 +301,11 @@ void InfoSidebarPage::cancelRequest()
 {
     m_timer->stop();
     m_pendingPreview = false;
+
+    if (m_metaInfoJob != 0) {
+        WorkerPool::instance().cancel(m_metaInfoJob);
+        m_metaInfoJob = 0;
+    }
 }
 
 void InfoSidebarPage::createMetaInfo()
@@ -275,7 +316,7 @@ void InfoSidebarPage::createMetaInfo()
     // take care of this.
     beginInfoLines();
     DolphinView* view = Dolphin::mainWin().activeView();
-    if (!view->hasSelection()) {
+    if (!view->hasSelection() && !m_shownURL.isLocalFile()) {
         KFileItem fileItem(S_IFDIR, KFileItem::Unknown, m_shownURL);
         fileItem.refresh();
 
@@ -289,11 +330,13 @@ void InfoSidebarPage::createMetaInfo()
             addInfoLine(i18n("Size:"), sizeText);
             addInfoLine(i18n("Modified:"), fileItem.timeString());
 
+            // the KFile plugins might be used by a worker thread in the meantime
+            QMutexLocker locker(MetaInfoJob::pluginMutex());
             const KFileMetaInfo& metaInfo = fileItem.metaInfo();
             if (metaInfo.isValid()) {
                 QStringList keys = metaInfo.supportedKeys();
                 for (QStringList::Iterator it = keys.begin(); it != keys.end(); ++it) {
-                    if (showMetaInfo(*it)) {
+                    if (MetaInfoJob::showMetaInfo(*it)) {
                         KFileMetaInfoItem metaInfoItem = metaInfo.item(*it);
                         addInfoLine(*it, metaInfoItem.string());
                     }
@@ -301,9 +344,61 @@ void InfoSidebarPage::createMetaInfo()
             }
         }
     }
+    else if (!view->hasSelection()) {
+        // Only the MIME type is determined inside the GUI thread (by
+        // the file extension). Reading the meta information might take
+        // a while and is done by a worker thread.
+        KMimeType::Ptr mimeType = KMimeType::findByURL(m_shownURL, 0, true, true);
+        if (mimeType->name() == "inode/directory") {
+            addInfoLine(i18n("Type:"), i18n("Directory"));
+        }
+        else {
+            m_shownMimeComment = mimeType->comment();
+
+            const QString path(m_shownURL.path());
+            time_t knownMTime = -1;
+            const MetaInfoJob::Info* info = MetaInfoService::instance().metaInfo(path);
+            if (info != 0) {
+                // show the cached meta information until the worker thread has
+                // verified that the file has not been modified
+                addFileInfoLines(*info);
+                knownMTime = info->mtime;
+            }
+            else {
+                addInfoLine(i18n("Type:"), m_shownMimeComment);
+            }
+
+            MetaInfoJob::prepare(mimeType->name());
+            m_metaInfoJob = new MetaInfoJob(path, mimeType->name(), knownMTime);
+            WorkerPool::instance().enqueue(m_metaInfoJob, WorkerJob::Preview);
+        }
+    }
     endInfoLines();
 }
 
+void InfoSidebarPage::addFileInfoLines(const MetaInfoJob::Info& info)
+{
+    if (info.isDir) {
+        addInfoLine(i18n("Type:"), i18n("Directory"));
+        return;
+    }
+
+    addInfoLine(i18n("Type:"), m_shownMimeComment);
+    addInfoLine(i18n("Size:"), KIO::convertSize(info.size));
+
+    QDateTime dateTime;
+    dateTime.setTime_t(info.mtime);
+    addInfoLine(i18n("Modified:"), KGlobal::locale()->formatDateTime(dateTime));
+
+    QStringList::ConstIterator keyIt = info.keys.begin();
+    QStringList::ConstIterator valueIt = info.values.begin();
+    while (keyIt != info.keys.end()) {
+        addInfoLine(*keyIt, *valueIt);
+        ++keyIt;
+        ++valueIt;
+    }
+}
+
 void InfoSidebarPage::beginInfoLines()
 {
     m_currInfoLineIdx = 0;
@@ -334,44 +429,6 @@ void InfoSidebarPage::endInfoLines()
     }
 }
 
-bool InfoSidebarPage::showMetaInfo(const QString& key) const
-{
-    // sorted list of keys, where it's data should be shown
-    static const char* keys[] = {
-        "Album",
-        "Artist",
-        "Author",
-        "Bitrate",
-        "Date",
-        "Dimensions",
-        "Genre",
-        "Length",
-        "Lines",
-        "Pages",
-        "Title",
-        "Words"
-    };
-
-    // do a binary search for the key...
-    int top = 0;
-    int bottom = sizeof(keys) / sizeof(char*) - 1;
-    while (top < bottom) {
-        const int middle = (top + bottom) / 2;
-        const int result = key.compare(keys[middle]);
-        if (result < 0) {
-            bottom = middle - 1;
-        }
-        else if (result > 0) {
-            top = middle + 1;
-        }
-        else {
-            return true;
-        }
-    }
-
-    return false;
-}
-
 void InfoSidebarPage::addInfoLine(const QString& labelText, const QString& infoText)
 {
     QString labelStr("<b>");
@@ -420,110 +477,61 @@ void InfoSidebarPage::insertActions()
 
     int actionsIndex = 0;
 
-    // The algorithm for searching the available actions works on a list
-    // of KFileItems. If no selection is given, a temporary KFileItem
-    // by the given URL 'url' is created and added to the list.
+    // The algorithm for searching the available actions works on the MIME type
+    // histogram of the selection. If no selection is given, a temporary KFileItem
+    // by the given URL 'url' is created and added to a local histogram.
+    DolphinView* view = Dolphin::mainWin().activeView();
     KFileItem fileItem(S_IFDIR, KFileItem::Unknown, m_shownURL);
-    KFileItemList localList;
-    const KFileItemList* itemList = Dolphin::mainWin().activeView()->selectedItems();
-    if ((itemList == 0) || itemList->isEmpty()) {
+    MimeTypeHistogram localHistogram;
+    const MimeTypeHistogram* histogram = &(view->selectionHistogram());
+    if (histogram->itemCount() == 0) {
         fileItem.refresh();
-        localList.append(&fileItem);
-        itemList = &localList;
+        localHistogram.add(&fileItem);
+        histogram = &localHistogram;
     }
 
-    // 'itemList' contains now all KFileItems, where an item information should be shown.
-    // TODO: the following algorithm is quite equal to DolphinContextMenu::insertActionItems().
-    // It's open yet whether they should be merged or whether they have to work slightly different.
-    QStringList dirs = KGlobal::dirs()->findDirs("data", "d3lphin/servicemenus/");
-    for (QStringList::ConstIterator dirIt = dirs.begin(); dirIt != dirs.end(); ++dirIt) {
-        QDir dir(*dirIt);
-        QStringList entries = dir.entryList("*.desktop", QDir::Files);
-
-        for (QStringList::ConstIterator entryIt = entries.begin(); entryIt != entries.end(); ++entryIt) {
-            KSimpleConfig cfg(*dirIt + *entryIt, true);
-            cfg.setDesktopGroup();
-            if ((cfg.hasKey("Actions") || cfg.hasKey("X-KDE-GetActionMenu")) && cfg.hasKey("ServiceTypes")) {
-                const QStringList types = cfg.readListEntry("ServiceTypes");
-                for (QStringList::ConstIterator it = types.begin(); it != types.end(); ++it) {
-                    // check whether the mime type is equal or whether the
-                    // mimegroup (e. g. image/*) is supported
-
-                    bool insert = false;
-                    if ((*it) == "all/allfiles") {
-                        // The service type is valid for all files, but not for directories.
-                        // Check whether the selected items only consist of files...
-                        KFileItemListIterator mimeIt(*itemList);
-                        KFileItem* item = 0;
-                        insert = true;
-                        while (insert && ((item = mimeIt.current()) != 0)) {
-                            insert = !item->isDir();
-                            ++mimeIt;
-                        }
-                    }
-
-                    if (!insert) {
-                        // Check whether the MIME types of all selected files match
-                        // to the mimetype of the service action. As soon as one MIME
-                        // type does not match, no service menu is shown at all.
-                        KFileItemListIterator mimeIt(*itemList);
-                        KFileItem* item = 0;
-                        insert = true;
-                        while (insert && ((item = mimeIt.current()) != 0)) {
-                            const QString mimeType((*mimeIt)->mimetype());
-                            const QString mimeGroup(mimeType.left(mimeType.find('/')));
-
-                            insert  = (*it == mimeType) ||
-                                      ((*it).right(1) == "*") &&
-                                      ((*it).left((*it).find('/')) == mimeGroup);
-                            ++mimeIt;
-                        }
-                    }
+    // 'histogram' contains now the MIME types of all items, where an item information should be shown.
+    const QValueList<ServiceMenuIndex::Menu> serviceMenus = ServiceMenuIndex::instance().menus(*histogram);
+    QValueList<ServiceMenuIndex::Menu>::ConstIterator menuIt = serviceMenus.begin();
+    while (menuIt != serviceMenus.end()) {
+        const QString& submenuName = (*menuIt).submenuName;
+        QPopupMenu* popup = 0;
+        if (!submenuName.isEmpty()) {
+            // create a sub menu containing all actions
+            popup = new QPopupMenu();
+            connect(popup, SIGNAL(activated(int)),
+                    this, SLOT(startService(int)));
+
+            QPushButton* button = new QPushButton(submenuName, m_actionBox);
+            button->setFlat(true);
+            button->setPopup(popup);
+            button->show();
+            m_actionWidgets.append(button);
+        }
 
-                    if (insert) {
-                        const QString submenuName = cfg.readEntry( "X-KDE-Submenu" );
-                        QPopupMenu* popup = 0;
-                        if (!submenuName.isEmpty()) {
-                            // create a sub menu containing all actions
-                            popup = new QPopupMenu();
-                            connect(popup, SIGNAL(activated(int)),
-                                    this, SLOT(startService(int)));
-
-                            QPushButton* button = new QPushButton(submenuName, m_actionBox);
-                            button->setFlat(true);
-                            button->setPopup(popup);
-                            button->show();
-                            m_actionWidgets.append(button);
-                        }
-
-                        QValueList<KDEDesktopMimeType::Service> userServices =
-                            KDEDesktopMimeType::userDefinedServices(*dirIt + *entryIt, true);
-
-                        // iterate through all actions and add them to a widget
-                        QValueList<KDEDesktopMimeType::Service>::Iterator serviceIt;
-                        for (serviceIt = userServices.begin(); serviceIt != userServices.end(); ++serviceIt) {
-                            KDEDesktopMimeType::Service service = (*serviceIt);
-                            if (popup == 0) {
-                                ServiceButton* button = new ServiceButton(SmallIcon(service.m_strIcon),
-                                                                          service.m_strName,
-                                                                          m_actionBox,
-                                                                          actionsIndex);
-                                connect(button, SIGNAL(requestServiceStart(int)),
-                                        this, SLOT(startService(int)));
-                                m_actionWidgets.append(button);
-                                button->show();
-                            }
-                            else {
-                                popup->insertItem(SmallIcon(service.m_strIcon), service.m_strName, actionsIndex);
-                            }
-
-                            m_actionsVector.append(service);
-                            ++actionsIndex;
-                        }
-                    }
-                }
+        // iterate through all actions and add them to a widget
+        const QValueList<KDEDesktopMimeType::Service>& userServices = (*menuIt).services;
+        QValueList<KDEDesktopMimeType::Service>::ConstIterator serviceIt;
+        for (serviceIt = userServices.begin(); serviceIt != userServices.end(); ++serviceIt) {
+            const KDEDesktopMimeType::Service& service = (*serviceIt);
+            if (popup == 0) {
+                ServiceButton* button = new ServiceButton(SmallIcon(service.m_strIcon),
+                                                          service.m_strName,
+                                                          m_actionBox,
+                                                          actionsIndex);
+                connect(button, SIGNAL(requestServiceStart(int)),
+                        this, SLOT(startService(int)));
+                m_actionWidgets.append(button);
+                button->show();
+            }
+            else {
+                popup->insertItem(SmallIcon(service.m_strIcon), service.m_strName, actionsIndex);
             }
+
+            m_actionsVector.append(service);
+            ++actionsIndex;
         }
+        ++menuIt;
     }
 }
 
@@ -24,11 +24,15 @@
 
 #include <qvaluevector.h>
 #include <qpushbutton.h>
+#include <qmap.h>
+#include <qstringlist.h>
 
 #include <kurl.h>
 #include <ksortablevaluelist.h>
 #include <kmimetype.h>
 
+#include "metainfojob.h"
+
 namespace KIO {
     class Job;
 };
@@ -107,6 +111,13 @@ private slots:
      */
     void startService(int index);
 
+    /**
+     * Is invoked if the worker job \a job has been finished. If the job
+     * has read the meta information for the shown item, the information
+     * is cached and shown.
+     */
+    void slotMetaInfoFinished(WorkerJob* job);
+
 private:
     /**
      * Connects to signals from the currently active Dolphin view to get
@@ -133,10 +144,10 @@ private:
     void endInfoLines();
 
     /**
-     * Returns true, if the string \a key represents a meta information
-     * that should be shown.
+     * Adds the info lines for the type, the size, the modification time
+     * and the meta information \a info of the shown file.
      */
-    bool showMetaInfo(const QString& key) const;
+    void addFileInfoLines(const MetaInfoJob::Info& info);
 
     /**
      * Inserts the available actions to the info page for the given item.
@@ -159,6 +170,9 @@ private:
     QVBox* m_actionBox;
     QPtrList<QWidget> m_actionWidgets;    // TODO: use children() from QObject instead
     QValueVector<KDEDesktopMimeType::Service> m_actionsVector;
+
+    MetaInfoJob* m_metaInfoJob;
+    QString m_shownMimeComment;
 };
 
 // TODO #1: move to SidebarPage?
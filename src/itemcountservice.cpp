@@ -0,0 +1,269 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "itemcountservice.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#endif
+
+#include <qcstring.h>
+#include <qfile.h>
+#include <qstringlist.h>
+
+#include "workerpool.h"
+
+// Maximum number of directories, for which the number of items is cached.
+#define MAX_COUNTS 20000
+
+/**
+ * @brief Counts the items inside one directory by a thread of the worker pool.
+ *
+ * On Linux the directory entries are read in large blocks by getdents64(),
+ * other systems use readdir(). In both cases no entry is stat'ed.
+ */
+class ItemCountJob : public WorkerJob
+{
+public:
+    ItemCountJob(const QCString& path, time_t mtime);
+    virtual ~ItemCountJob();
+
+    time_t mtime() const { return m_mtime; }
+    uint count() const { return m_count; }
+    uint hiddenCount() const { return m_hiddenCount; }
+
+    /** Returns true, if the directory could not be opened or read completely. */
+    bool hasFailed() const { return m_failed; }
+
+protected:
+    virtual void run();
+
+private:
+    /** Counts the entry \a name, if it is no '.' or '..' entry. */
+    void countEntry(const char* name);
+
+    QCString m_path;
+    time_t m_mtime;
+    uint m_count;
+    uint m_hiddenCount;
+    bool m_failed;
+};
+
+ItemCountJob::ItemCountJob(const QCString& path, time_t mtime) :
+    m_path(path.copy()),
+    m_mtime(mtime),
+    m_count(0),
+    m_hiddenCount(0),
+    m_failed(false)
+{
+}
+
+ItemCountJob::~ItemCountJob()
+{
+}
+
+void ItemCountJob::run()
+{
+#if defined(Q_OS_LINUX) && defined(SYS_getdents64)
+    const int fd = ::open(m_path.data(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        m_failed = true;
+        return;
+    }
+
+    // layout of the entries returned by getdents64(2)
+    struct LinuxDirent64
+    {
+        Q_UINT64 d_ino;
+        Q_INT64 d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    char buffer[32768];
+    long bytesRead = 0;
+    while (!isCancelled() &&
+           ((bytesRead = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer))) > 0)) {
+        long pos = 0;
+        while (pos < bytesRead) {
+            const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(buffer + pos);
+            countEntry(entry->d_name);
+            pos += entry->d_reclen;
+        }
+    }
+    if (bytesRead < 0) {
+        m_failed = true;
+    }
+    ::close(fd);
+#else
+    DIR* dir = ::opendir(m_path.data());
+    if (dir == 0) {
+        m_failed = true;
+        return;
+    }
+
+    // readdir() returns 0 both at the end and on errors, only errno tells
+    errno = 0;
+    struct dirent* entry = 0;
+    while (!isCancelled() && ((entry = ::readdir(dir)) != 0)) {
+        countEntry(entry->d_name);
+    }
+    if ((entry == 0) && (errno != 0)) {
+        m_failed = true;
+    }
+    ::closedir(dir);
+#endif
+}
+
+void ItemCountJob::countEntry(const char* name)
+{
+    if (name[0] == '.') {
+        if ((name[1] == '\0') || ((name[1] == '.') && (name[2] == '\0'))) {
+            return;
+        }
+        ++m_hiddenCount;
+    }
+    ++m_count;
+}
+
+ItemCountService& ItemCountService::instance()
+{
+    static ItemCountService* instance = 0;
+    if (instance == 0) {
+        instance = new ItemCountService();
+    }
+    return *instance;
+}
+
+bool ItemCountService::itemCount(const QString& path,
+                                 time_t mtime,
+                                 bool countHidden,
+                                 uint& count) const
+{
+    QMap<QString, Count>::ConstIterator it = m_counts.find(path);
+    if ((it == m_counts.end()) || ((*it).mtime != mtime) || (*it).failed) {
+        return false;
+    }
+
+    count = countHidden ? (*it).count : (*it).count - (*it).hiddenCount;
+    return true;
+}
+
+void ItemCountService::requestCount(const QString& path, time_t mtime, const void* owner)
+{
+    QMap<QString, Count>::ConstIterator countIt = m_counts.find(path);
+    if ((countIt != m_counts.end()) && ((*countIt).mtime == mtime)) {
+        return;
+    }
+
+    QMap<QString, Request>::Iterator it = m_requests.find(path);
+    if (it != m_requests.end()) {
+        if (!(*it).owners.contains(owner)) {
+            (*it).owners.append(owner);
+        }
+        return;
+    }
+
+    Request request;
+    request.job = new ItemCountJob(QFile::encodeName(path), mtime);
+    request.owners.append(owner);
+    m_requests.insert(path, request);
+    WorkerPool::instance().enqueue(request.job, WorkerJob::Preview);
+}
+
+void ItemCountService::cancelRequests(const void* owner)
+{
+    QStringList cancelledPaths;
+
+    QMap<QString, Request>::Iterator it = m_requests.begin();
+    const QMap<QString, Request>::Iterator end = m_requests.end();
+    while (it != end) {
+        Request& request = *it;
+        request.owners.remove(owner);
+        if (request.owners.isEmpty()) {
+            WorkerPool::instance().cancel(request.job);
+            cancelledPaths.append(it.key());
+        }
+        ++it;
+    }
+
+    QStringList::ConstIterator pathIt = cancelledPaths.begin();
+    const QStringList::ConstIterator pathEnd = cancelledPaths.end();
+    while (pathIt != pathEnd) {
+        m_requests.remove(*pathIt);
+        ++pathIt;
+    }
+}
+
+ItemCountService::ItemCountService() :
+    QObject(0)
+{
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotJobFinished(WorkerJob*)));
+}
+
+ItemCountService::~ItemCountService()
+{
+    QMap<QString, Request>::Iterator it = m_requests.begin();
+    const QMap<QString, Request>::Iterator end = m_requests.end();
+    while (it != end) {
+        WorkerPool::instance().cancel((*it).job);
+        ++it;
+    }
+    m_requests.clear();
+}
+
+void ItemCountService::slotJobFinished(WorkerJob* job)
+{
+    QMap<QString, Request>::Iterator it = m_requests.begin();
+    const QMap<QString, Request>::Iterator end = m_requests.end();
+    while ((it != end) && (static_cast<WorkerJob*>((*it).job) != job)) {
+        ++it;
+    }
+    if (it == end) {
+        // the job is no item count job
+        return;
+    }
+
+    // the job is deleted by the worker pool
+    const ItemCountJob* countJob = (*it).job;
+    const QString path(it.key());
+    m_requests.remove(it);
+
+    if (m_counts.count() >= MAX_COUNTS) {
+        m_counts.clear();
+    }
+
+    Count count;
+    count.mtime = countJob->mtime();
+    count.count = countJob->count();
+    count.hiddenCount = countJob->hiddenCount();
+    count.failed = countJob->hasFailed();
+    m_counts.replace(path, count);
+
+    emit countAvailable(path);
+}
+
+#include "itemcountservice.moc"
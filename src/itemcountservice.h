@@ -0,0 +1,123 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef ITEMCOUNTSERVICE_H
+#define ITEMCOUNTSERVICE_H
+
+#include <qmap.h>
+#include <qobject.h>
+#include <qvaluelist.h>
+
+#include <time.h>
+
+class ItemCountJob;
+class WorkerJob;
+
+/**
+ * @brief Counts the items inside local directories in the background.
+ *
+ * Only the direct children of a directory are counted. The entries are
+ * read by a ItemCountJob inside the WorkerPool without getting the
+ * status of each entry, which is cheap even for directories containing
+ * thousands of items. The counts are cached together with the modification
+ * time of the directory, so that a count is only determined again after
+ * items have been added or removed.
+ *
+ * The requests are assigned to an owner. Usually the owner cancels all
+ * of its requests by ItemCountService::cancelRequests() if the visible
+ * items change and requests the counts for the new visible items.
+ *
+ * Sample code:
+ * \code
+ * ItemCountService& service = ItemCountService::instance();
+ * uint count = 0;
+ * if (!service.itemCount(path, mtime, showHidden, count)) {
+ *     service.requestCount(path, mtime, this);
+ *     // wait for ItemCountService::countAvailable()
+ * }
+ * \endcode
+ */
+class ItemCountService : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ItemCountService& instance();
+
+    /**
+     * Returns true, if the number of items inside the directory \a path
+     * having the modification time \a mtime is known and writes the number
+     * to \a count. Hidden items are only included if \a countHidden is true.
+     * False is also returned, if the directory could not be read.
+     */
+    bool itemCount(const QString& path, time_t mtime, bool countHidden, uint& count) const;
+
+    /**
+     * Requests counting the items inside the local directory \a path, which
+     * has the modification time \a mtime. Nothing happens, if the number of
+     * items is already known or if reading the directory with this
+     * modification time has failed already. All requests of \a owner can be cancelled by
+     * ItemCountService::cancelRequests().
+     */
+    void requestCount(const QString& path, time_t mtime, const void* owner);
+
+    /**
+     * Cancels all requests of \a owner. A request is only cancelled if it
+     * has not been done by another owner too.
+     */
+    void cancelRequests(const void* owner);
+
+signals:
+    /**
+     * Is emitted if the items inside the directory \a path have been counted
+     * or if reading the directory has failed. The number can be retrieved by
+     * ItemCountService::itemCount().
+     */
+    void countAvailable(const QString& path);
+
+protected:
+    ItemCountService();
+    virtual ~ItemCountService();
+
+private slots:
+    /** Takes over the number of items counted by the job \a job. */
+    void slotJobFinished(WorkerJob* job);
+
+private:
+    struct Count
+    {
+        time_t mtime;
+        uint count;
+        uint hiddenCount;
+        /** Is true, if the directory could not be read (e. g. no permission). */
+        bool failed;
+    };
+
+    struct Request
+    {
+        ItemCountJob* job;
+        QValueList<const void*> owners;
+    };
+
+    QMap<QString, Count> m_counts;
+    QMap<QString, Request> m_requests;
+};
+
+#endif
@@ -0,0 +1,111 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "itemnameindex.h"
+
+#include <qtl.h>
+
+ItemNameIndex::ItemNameIndex() :
+    m_sortedNamesValid(true)
+{
+}
+
+ItemNameIndex::~ItemNameIndex()
+{
+}
+
+void ItemNameIndex::insert(KFileItem* item)
+{
+    m_items.replace(item->name(), item);
+
+    // grow the hash table, so that the lookups stay fast for large directories
+    if (m_items.count() > 2 * m_items.size()) {
+        m_items.resize(4 * m_items.count() + 1);
+    }
+
+    m_sortedNamesValid = false;
+}
+
+void ItemNameIndex::remove(const KFileItem* item)
+{
+    const QString name(item->name());
+    if (m_items.find(name) == item) {
+        m_items.remove(name);
+        m_sortedNamesValid = false;
+    }
+}
+
+void ItemNameIndex::clear()
+{
+    m_items.clear();
+    m_sortedNames.clear();
+    m_sortedNamesValid = true;
+}
+
+KFileItem* ItemNameIndex::item(const QString& name) const
+{
+    return m_items.find(name);
+}
+
+KFileItem* ItemNameIndex::firstMatch(const QString& prefix)
+{
+    if (!m_sortedNamesValid) {
+        updateSortedNames();
+    }
+
+    const QString key(prefix.lower());
+
+    // do a binary search for the first name, which is not smaller than the prefix
+    uint top = 0;
+    uint bottom = m_sortedNames.count();
+    while (top < bottom) {
+        const uint middle = (top + bottom) / 2;
+        if (m_sortedNames[middle].key < key) {
+            top = middle + 1;
+        }
+        else {
+            bottom = middle;
+        }
+    }
+
+    if ((top < m_sortedNames.count()) && m_sortedNames[top].key.startsWith(key)) {
+        return m_sortedNames[top].item;
+    }
+
+    return 0;
+}
+
+void ItemNameIndex::updateSortedNames()
+{
+    m_sortedNames.clear();
+    m_sortedNames.reserve(m_items.count());
+
+    QDictIterator<KFileItem> it(m_items);
+    while (it.current() != 0) {
+        SortedName sortedName;
+        sortedName.key = it.currentKey().lower();
+        sortedName.item = it.current();
+        m_sortedNames.append(sortedName);
+        ++it;
+    }
+
+    qHeapSort(m_sortedNames);
+    m_sortedNamesValid = true;
+}
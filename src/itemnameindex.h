@@ -0,0 +1,80 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef ITEMNAMEINDEX_H
+#define ITEMNAMEINDEX_H
+
+#include <qdict.h>
+#include <qvaluevector.h>
+
+#include <kfileitem.h>
+
+/**
+ * @brief Allows to find the items of a directory by their names.
+ *
+ * The index consists of a hash table, which maps a name to the item, and of
+ * a list of the names sorted case-insensitively. The hash table is used by
+ * DolphinView to restore the current item after a directory has been
+ * loaded, the sorted list is used for the type-ahead search of the views.
+ *
+ * The sorted list is rebuilt lazily on the first prefix search after
+ * items have been added, so that adding many items one after the other
+ * stays cheap.
+ */
+class ItemNameIndex
+{
+public:
+    ItemNameIndex();
+    ~ItemNameIndex();
+
+    void insert(KFileItem* item);
+    void remove(const KFileItem* item);
+    void clear();
+
+    /** Returns the item having the name \a name. 0 is returned if no such item is available. */
+    KFileItem* item(const QString& name) const;
+
+    /**
+     * Returns the first item in case-insensitive alphabetical order, where the
+     * name starts with \a prefix. 0 is returned if no such item is available.
+     */
+    KFileItem* firstMatch(const QString& prefix);
+
+private:
+    ItemNameIndex(const ItemNameIndex&);
+    ItemNameIndex& operator=(const ItemNameIndex&);
+
+    void updateSortedNames();
+
+    struct SortedName
+    {
+        QString key;
+        KFileItem* item;
+
+        bool operator<(const SortedName& other) const { return key < other.key; }
+        bool operator==(const SortedName& other) const { return key == other.key; }
+    };
+
+    bool m_sortedNamesValid;
+    QDict<KFileItem> m_items;
+    QValueVector<SortedName> m_sortedNames;
+};
+
+#endif
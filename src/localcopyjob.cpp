@@ -0,0 +1,1544 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "localcopyjob.h"
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+#include <qfile.h>
+#include <qmap.h>
+#include <qtimer.h>
+
+#include <kde_file.h>
+#include <kdirnotify_stub.h>
+#include <klocale.h>
+
+#include "transferjournal.h"
+#include "workerpool.h"
+#include "xxhash64.h"
+
+// Files having at least this size are copied by a separate job.
+#define LARGE_FILE_SIZE (4 * 1024 * 1024)
+
+// Maximum number of files and bytes, which are copied by one job.
+#define BATCH_FILE_COUNT 256
+#define BATCH_SIZE (16 * 1024 * 1024)
+
+// Maximum number of bytes, which are copied by one system call. Between
+// the calls the job checks whether it has been cancelled.
+#define CHUNK_SIZE (8 * 1024 * 1024)
+
+// Size of the buffer, if the data must be copied in user space.
+#define BUFFER_SIZE (256 * 1024)
+
+// Minimum size of a transfer, which is recorded in a transfer journal.
+#define JOURNAL_MIN_SIZE (64 * 1024 * 1024)
+
+// Number of bytes after which the written data is flushed to the disk
+// and the progress of the file is recorded in the transfer journal.
+#define JOURNAL_CHECKPOINT_SIZE (64 * 1024 * 1024)
+
+// Is set to false, if the kernel does not support copy_file_range().
+static volatile bool useCopyFileRange = true;
+
+/**
+ * Copies up to \a length bytes from \a srcFd at \a srcOffset to \a destFd
+ * at \a destOffset inside the kernel. -1 is returned and errno is set
+ * to ENOSYS, if no kernel interface can be used for both files.
+ */
+static ssize_t kernelCopy(int srcFd, off_t srcOffset, int destFd, off_t destOffset, size_t length)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_copy_file_range)
+    if (useCopyFileRange) {
+        loff_t in = srcOffset;
+        loff_t out = destOffset;
+        const ssize_t copied = ::syscall(SYS_copy_file_range, srcFd, &in, destFd, &out, length, 0u);
+        if ((copied >= 0) || ((errno != ENOSYS) && (errno != EXDEV) &&
+                              (errno != EINVAL) && (errno != EOPNOTSUPP))) {
+            return copied;
+        }
+        if (errno == ENOSYS) {
+            useCopyFileRange = false;
+        }
+    }
+#endif
+
+#ifdef Q_OS_LINUX
+    // sendfile() writes to the current position of the destination
+    if (::lseek(destFd, destOffset, SEEK_SET) == destOffset) {
+        off_t in = srcOffset;
+        const ssize_t copied = ::sendfile(destFd, srcFd, &in, length);
+        if ((copied >= 0) || ((errno != EINVAL) && (errno != ENOSYS))) {
+            return copied;
+        }
+    }
+#endif
+
+    errno = ENOSYS;
+    return -1;
+}
+
+/** Maps the error number \a errnum to an error code of KIO. */
+// Error number, which is used if a source file has become shorter while being copied.
+#ifdef ENODATA
+#define ERR_SOURCE_TRUNCATED ENODATA
+#else
+#define ERR_SOURCE_TRUNCATED EIO
+#endif
+
+static int kioError(int errnum)
+{
+    switch (errnum) {
+        case ERR_SOURCE_TRUNCATED: return KIO::ERR_COULD_NOT_READ;
+        case ENOSPC: return KIO::ERR_DISK_FULL;
+        case EACCES:
+        case EPERM:  return KIO::ERR_ACCESS_DENIED;
+        case EROFS:  return KIO::ERR_WRITE_ACCESS_DENIED;
+        case EEXIST: return KIO::ERR_FILE_ALREADY_EXIST;
+        case ENOENT: return KIO::ERR_DOES_NOT_EXIST;
+        case ENOTSUP: return KIO::ERR_CANNOT_OPEN_FOR_READING;
+        default:     return KIO::ERR_COULD_NOT_WRITE;
+    }
+}
+
+/**
+ * @brief Base class for the jobs of a LocalCopyJob, which are executed by the worker pool.
+ *
+ * All data is deep copied when the job is created, so that the worker
+ * thread does not share any implicitly shared Qt data with the GUI thread.
+ */
+class CopyWorkerJob : public WorkerJob
+{
+public:
+    CopyWorkerJob(const QValueVector<QCString>& sourceDirs, const QCString& destDir);
+    virtual ~CopyWorkerJob();
+
+    /** Returns the error number of the first error, or 0 if no error occured. */
+    int error() const { return m_error; }
+
+    /** Returns the path of the item, which caused the error. */
+    const QCString& errorPath() const { return m_errorPath; }
+
+    /** Returns the number of bytes, which have been copied by the job. Is thread-safe. */
+    KIO::filesize_t processedSize() const { return m_processedSize; }
+
+protected:
+    /** Appends a copy of the entries from \a first to \a last (exclusive) of \a entries. */
+    void assignEntries(const QValueVector<LocalCopyJob::Entry>& entries, uint first, uint last);
+
+    QCString sourcePath(const LocalCopyJob::Entry& entry) const;
+    QCString destPath(const LocalCopyJob::Entry& entry) const;
+
+    /** Remembers the error \a errnum for the path \a path and returns false. */
+    bool setError(int errnum, const QCString& path);
+
+    QValueVector<QCString> m_sourceDirs;
+    QCString m_destDir;
+    QValueVector<LocalCopyJob::Entry> m_entries;
+    volatile KIO::filesize_t m_processedSize;
+
+private:
+    int m_error;
+    QCString m_errorPath;
+};
+
+CopyWorkerJob::CopyWorkerJob(const QValueVector<QCString>& sourceDirs, const QCString& destDir) :
+    m_destDir(destDir.copy()),
+    m_processedSize(0),
+    m_error(0)
+{
+    m_sourceDirs.reserve(sourceDirs.count());
+    QValueVector<QCString>::ConstIterator it = sourceDirs.begin();
+    const QValueVector<QCString>::ConstIterator end = sourceDirs.end();
+    while (it != end) {
+        m_sourceDirs.append((*it).copy());
+        ++it;
+    }
+}
+
+CopyWorkerJob::~CopyWorkerJob()
+{
+}
+
+void CopyWorkerJob::assignEntries(const QValueVector<LocalCopyJob::Entry>& entries, uint first, uint last)
+{
+    m_entries.reserve(m_entries.count() + last - first);
+    for (uint i = first; i < last; ++i) {
+        LocalCopyJob::Entry entry(entries[i]);
+        entry.path = entry.path.copy();
+        entry.destPath = entry.destPath.copy();
+        entry.linkTarget = entry.linkTarget.copy();
+        m_entries.append(entry);
+    }
+}
+
+QCString CopyWorkerJob::sourcePath(const LocalCopyJob::Entry& entry) const
+{
+    QCString path(m_sourceDirs[entry.sourceDir]);
+    path += '/';
+    path += entry.path;
+    return path;
+}
+
+QCString CopyWorkerJob::destPath(const LocalCopyJob::Entry& entry) const
+{
+    QCString path(m_destDir);
+    path += '/';
+    path += entry.destPath.isEmpty() ? entry.path : entry.destPath;
+    return path;
+}
+
+bool CopyWorkerJob::setError(int errnum, const QCString& path)
+{
+    if (m_error == 0) {
+        m_error = errnum;
+        m_errorPath = path;
+    }
+    return false;
+}
+
+/**
+ * @brief Reads the source tree of a LocalCopyJob.
+ *
+ * The folders are collected in pre-order, so that each parent
+ * folder is created before its children.
+ */
+class CopyScanJob : public CopyWorkerJob
+{
+public:
+    CopyScanJob(const QValueVector<QCString>& sourcePaths);
+    virtual ~CopyScanJob();
+
+    const QValueVector<QCString>& sourceDirs() const { return m_sourceDirs; }
+    const QValueVector<LocalCopyJob::Entry>& folders() const { return m_folders; }
+    const QValueVector<LocalCopyJob::Entry>& specials() const { return m_specials; }
+    const QValueVector<LocalCopyJob::Entry>& files() const { return m_files; }
+    KIO::filesize_t totalSize() const { return m_totalSize; }
+
+protected:
+    virtual void run();
+
+private:
+    /** Adds the item \a path of the source folder \a sourceDir and all its children. */
+    bool scan(uint sourceDir, const QCString& path);
+
+    QValueVector<QCString> m_sourcePaths;
+    QValueVector<LocalCopyJob::Entry> m_folders;
+    QValueVector<LocalCopyJob::Entry> m_specials;
+    QValueVector<LocalCopyJob::Entry> m_files;
+    KIO::filesize_t m_totalSize;
+};
+
+CopyScanJob::CopyScanJob(const QValueVector<QCString>& sourcePaths) :
+    CopyWorkerJob(QValueVector<QCString>(), QCString()),
+    m_totalSize(0)
+{
+    m_sourcePaths.reserve(sourcePaths.count());
+    QValueVector<QCString>::ConstIterator it = sourcePaths.begin();
+    const QValueVector<QCString>::ConstIterator end = sourcePaths.end();
+    while (it != end) {
+        m_sourcePaths.append((*it).copy());
+        ++it;
+    }
+}
+
+CopyScanJob::~CopyScanJob()
+{
+}
+
+void CopyScanJob::run()
+{
+    QValueVector<QCString>::ConstIterator it = m_sourcePaths.begin();
+    const QValueVector<QCString>::ConstIterator end = m_sourcePaths.end();
+    while ((it != end) && !isCancelled()) {
+        const QCString& sourcePath = *it;
+        const int slashIndex = sourcePath.findRev('/');
+        assert(slashIndex >= 0);
+        const QCString sourceDir((slashIndex == 0) ? QCString("/") : sourcePath.left(slashIndex));
+        if (m_sourceDirs.isEmpty() || (m_sourceDirs.back() != sourceDir)) {
+            m_sourceDirs.append(sourceDir);
+        }
+
+        if (!scan(m_sourceDirs.count() - 1, sourcePath.mid(slashIndex + 1))) {
+            return;
+        }
+        ++it;
+    }
+}
+
+bool CopyScanJob::scan(uint sourceDir, const QCString& path)
+{
+    LocalCopyJob::Entry entry;
+    entry.sourceDir = sourceDir;
+    entry.path = path;
+    const QCString fullPath(sourcePath(entry));
+
+    KDE_struct_stat buf;
+    if (KDE_lstat(fullPath, &buf) != 0) {
+        return setError(errno, fullPath);
+    }
+    entry.replace = false;
+    entry.journalIndex = 0;
+    entry.resumeOffset = 0;
+    entry.hash = 0;
+    entry.mode = buf.st_mode;
+    entry.size = 0;
+    entry.atime = buf.st_atime;
+    entry.mtime = buf.st_mtime;
+
+    if (S_ISREG(buf.st_mode)) {
+        entry.size = buf.st_size;
+        m_totalSize += entry.size;
+        m_files.append(entry);
+    }
+    else if (S_ISDIR(buf.st_mode)) {
+        m_folders.append(entry);
+
+        DIR* dir = ::opendir(fullPath);
+        if (dir == 0) {
+            return setError(errno, fullPath);
+        }
+
+        bool ok = true;
+        KDE_struct_dirent* dirEntry = 0;
+        while (ok && !isCancelled() && ((dirEntry = KDE_readdir(dir)) != 0)) {
+            const char* name = dirEntry->d_name;
+            if ((qstrcmp(name, ".") != 0) && (qstrcmp(name, "..") != 0)) {
+                QCString childPath(path);
+                childPath += '/';
+                childPath += name;
+                ok = scan(sourceDir, childPath);
+            }
+        }
+        ::closedir(dir);
+        return ok;
+    }
+    else if (S_ISLNK(buf.st_mode)) {
+        char target[PATH_MAX + 1];
+        const int length = ::readlink(fullPath, target, PATH_MAX);
+        if (length < 0) {
+            return setError(errno, fullPath);
+        }
+        target[length] = '\0';
+        entry.linkTarget = target;
+        m_specials.append(entry);
+    }
+    else if (S_ISFIFO(buf.st_mode)) {
+        m_specials.append(entry);
+    }
+    else {
+        // sockets and device files cannot be copied
+        return setError(ENOTSUP, fullPath);
+    }
+
+    return true;
+}
+
+/** @brief Creates the folders, symbolic links and FIFOs of a LocalCopyJob. */
+class CreateFoldersJob : public CopyWorkerJob
+{
+public:
+    CreateFoldersJob(const QValueVector<QCString>& sourceDirs,
+                     const QCString& destDir,
+                     const QValueVector<LocalCopyJob::Entry>& folders,
+                     const QValueVector<LocalCopyJob::Entry>& specials);
+    virtual ~CreateFoldersJob();
+
+protected:
+    virtual void run();
+
+private:
+    uint m_folderCount;
+};
+
+CreateFoldersJob::CreateFoldersJob(const QValueVector<QCString>& sourceDirs,
+                                   const QCString& destDir,
+                                   const QValueVector<LocalCopyJob::Entry>& folders,
+                                   const QValueVector<LocalCopyJob::Entry>& specials) :
+    CopyWorkerJob(sourceDirs, destDir),
+    m_folderCount(folders.count())
+{
+    assignEntries(folders, 0, folders.count());
+    assignEntries(specials, 0, specials.count());
+}
+
+CreateFoldersJob::~CreateFoldersJob()
+{
+}
+
+void CreateFoldersJob::run()
+{
+    const uint count = m_entries.count();
+    for (uint i = 0; (i < count) && !isCancelled(); ++i) {
+        const LocalCopyJob::Entry& entry = m_entries[i];
+        const QCString path(destPath(entry));
+
+        // The folders are created writable for the owner. The permissions of
+        // the source folders are applied after all files have been copied.
+        int result = 0;
+        if (i < m_folderCount) {
+            result = ::mkdir(path, 0700);
+            KDE_struct_stat buf;
+            if ((result != 0) && (errno == EEXIST) &&
+                (KDE_stat(path, &buf) == 0) && S_ISDIR(buf.st_mode)) {
+                // the folder exists already and is merged
+                result = 0;
+            }
+        }
+        else if (entry.replace && (::unlink(path) != 0) && (errno != ENOENT)) {
+            result = -1;
+        }
+        else if (S_ISLNK(entry.mode)) {
+            result = ::symlink(entry.linkTarget, path);
+        }
+        else {
+            result = ::mkfifo(path, entry.mode & 07777);
+        }
+
+        if (result != 0) {
+            setError(errno, path);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Copies a range of the files of a LocalCopyJob.
+ *
+ * If verifying is enabled, the data is copied in user space and the hash
+ * of each source file is calculated while reading it. The hashes are stored
+ * inside the entries, which are checked afterwards by a VerifyFilesJob.
+ *
+ * If a transfer journal is given, the copied data is flushed to the disk
+ * periodically and the progress of each file is recorded in the journal.
+ */
+class CopyFilesJob : public CopyWorkerJob
+{
+public:
+    CopyFilesJob(const QValueVector<QCString>& sourceDirs,
+                 const QCString& destDir,
+                 const QValueVector<LocalCopyJob::Entry>& files,
+                 uint first,
+                 uint last,
+                 bool verify,
+                 TransferJournal* journal);
+    virtual ~CopyFilesJob();
+
+    /** Returns the copied files. If verifying is enabled, the hashes of the source files are set. */
+    const QValueVector<LocalCopyJob::Entry>& entries() const { return m_entries; }
+
+protected:
+    virtual void run();
+
+private:
+    bool copyFile(LocalCopyJob::Entry& entry);
+
+    /** Copies the data of the file \a entry, where holes of sparse files are skipped. */
+    bool copyData(int srcFd, int destFd, const LocalCopyJob::Entry& entry);
+
+    /** Copies \a length bytes at the offset \a offset from \a srcFd to \a destFd. */
+    bool copyRange(int srcFd, int destFd, off_t offset, off_t length,
+                   const LocalCopyJob::Entry& entry);
+
+    /** Adds \a length zero bytes of a skipped hole to the hash. */
+    void hashHole(off_t length);
+
+    /** Adds the first \a length bytes of the file \a entry, which have been copied before, to the hash. */
+    bool hashCopiedData(int srcFd, off_t length, const LocalCopyJob::Entry& entry);
+
+    QByteArray m_buffer;
+    bool m_verify;
+    XXHash64 m_hash;
+    TransferJournal* m_journal;
+
+    /** Number of bytes, which have been written since the last checkpoint. */
+    KIO::filesize_t m_uncheckedSize;
+};
+
+CopyFilesJob::CopyFilesJob(const QValueVector<QCString>& sourceDirs,
+                           const QCString& destDir,
+                           const QValueVector<LocalCopyJob::Entry>& files,
+                           uint first,
+                           uint last,
+                           bool verify,
+                           TransferJournal* journal) :
+    CopyWorkerJob(sourceDirs, destDir),
+    m_verify(verify),
+    m_journal(journal),
+    m_uncheckedSize(0)
+{
+    assignEntries(files, first, last);
+    if (m_journal != 0) {
+        m_journal->ref();
+    }
+}
+
+CopyFilesJob::~CopyFilesJob()
+{
+    // the worker pool deletes the jobs inside the GUI thread
+    if ((m_journal != 0) && m_journal->deref()) {
+        delete m_journal;
+    }
+}
+
+void CopyFilesJob::run()
+{
+    QValueVector<LocalCopyJob::Entry>::Iterator it = m_entries.begin();
+    const QValueVector<LocalCopyJob::Entry>::Iterator end = m_entries.end();
+    while ((it != end) && !isCancelled()) {
+        if (!copyFile(*it)) {
+            return;
+        }
+        ++it;
+    }
+}
+
+bool CopyFilesJob::copyFile(LocalCopyJob::Entry& entry)
+{
+    const QCString sourceFile(sourcePath(entry));
+    const QCString destFile(destPath(entry));
+
+    const int srcFd = KDE_open(sourceFile, O_RDONLY);
+    if (srcFd < 0) {
+        return setError(errno, sourceFile);
+    }
+
+    // a partially copied file of an interrupted transfer is continued
+    const bool resume = (entry.resumeOffset > 0);
+    if (!resume && entry.replace && (::unlink(destFile) != 0) && (errno != ENOENT)) {
+        const int errnum = errno;
+        ::close(srcFd);
+        return setError(errnum, destFile);
+    }
+
+    const int destFd = resume ? KDE_open(destFile, O_WRONLY) :
+                                KDE_open(destFile, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (destFd < 0) {
+        const int errnum = errno;
+        ::close(srcFd);
+        return setError(errnum, destFile);
+    }
+
+    bool cloned = false;
+#ifdef FICLONE
+    // Share the data blocks if source and destination are on the same btrfs or XFS
+    // file system. When verifying, the source data must be read for the hash.
+    cloned = !resume && !m_verify && (entry.size > 0) && (::ioctl(destFd, FICLONE, srcFd) == 0);
+#endif
+
+    m_hash.reset();
+    bool ok = true;
+    if (cloned) {
+        m_processedSize += entry.size;
+    }
+    else {
+        ok = copyData(srcFd, destFd, entry);
+    }
+
+    if (ok && (::fchmod(destFd, entry.mode & 07777) != 0)) {
+        ok = setError(errno, destFile);
+    }
+
+    // A file may only be marked as completed inside the journal, if its
+    // data is stored on the disk. Otherwise a crash of the system could
+    // leave an incomplete file, which is skipped when resuming.
+    if (ok && (m_journal != 0) && (::fdatasync(destFd) != 0)) {
+        ok = setError(errno, destFile);
+    }
+
+    ::close(srcFd);
+    if ((::close(destFd) != 0) && ok) {
+        ok = setError(errno, destFile);
+    }
+
+    if (!ok) {
+        // Don't leave a partially copied file, except it can be
+        // continued when resuming the transfer of the journal.
+        if ((m_journal == 0) || m_journal->isRemoved()) {
+            ::unlink(destFile);
+        }
+        return false;
+    }
+
+    struct utimbuf times;
+    times.actime = entry.atime;
+    times.modtime = entry.mtime;
+    ::utime(destFile, &times);
+
+    if (m_verify) {
+        entry.hash = m_hash.digest();
+    }
+
+    if (m_journal != 0) {
+        m_journal->setCompleted(entry.journalIndex);
+    }
+
+    return true;
+}
+
+bool CopyFilesJob::copyData(int srcFd, int destFd, const LocalCopyJob::Entry& entry)
+{
+    const off_t size = static_cast<off_t>(entry.size);
+    off_t offset = static_cast<off_t>(entry.resumeOffset);
+    if (offset > 0) {
+        m_processedSize += offset;
+        if (m_verify && !hashCopiedData(srcFd, offset, entry)) {
+            return false;
+        }
+    }
+
+    m_uncheckedSize = 0;
+    while (offset < size) {
+        if (isCancelled()) {
+            return false;
+        }
+
+        off_t dataStart = offset;
+        off_t dataEnd = size;
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+        dataStart = ::lseek(srcFd, offset, SEEK_DATA);
+        if (dataStart < 0) {
+            if (errno == ENXIO) {
+                // only a hole is left until the end of the file
+                break;
+            }
+            // the file system does not support SEEK_DATA
+            dataStart = offset;
+        }
+        else {
+            dataEnd = ::lseek(srcFd, dataStart, SEEK_HOLE);
+            if ((dataEnd < 0) || (dataEnd > size)) {
+                dataEnd = size;
+            }
+        }
+#endif
+
+        // a skipped hole counts as processed data
+        m_processedSize += dataStart - offset;
+        hashHole(dataStart - offset);
+
+        if (!copyRange(srcFd, destFd, dataStart, dataEnd - dataStart, entry)) {
+            return false;
+        }
+        offset = dataEnd;
+    }
+
+    if (offset < size) {
+        // Only a hole is left, except the source file has become shorter. In
+        // this case the missing data may not be replaced by zeros.
+        KDE_struct_stat buf;
+        if ((KDE_fstat(srcFd, &buf) == 0) && (buf.st_size < size)) {
+            return setError(ERR_SOURCE_TRUNCATED, sourcePath(entry));
+        }
+        m_processedSize += size - offset;
+        hashHole(size - offset);
+    }
+
+    // restore the size, if the file ends with a hole
+    if (::ftruncate(destFd, size) != 0) {
+        return setError(errno, destPath(entry));
+    }
+
+    return true;
+}
+
+bool CopyFilesJob::copyRange(int srcFd, int destFd, off_t offset, off_t length,
+                             const LocalCopyJob::Entry& entry)
+{
+    bool useKernelCopy = !m_verify;
+    off_t copiedTotal = 0;
+    while (copiedTotal < length) {
+        if (isCancelled()) {
+            return false;
+        }
+
+        const off_t current = offset + copiedTotal;
+        const size_t chunk = static_cast<size_t>(QMIN(length - copiedTotal, static_cast<off_t>(CHUNK_SIZE)));
+        ssize_t copied = -1;
+        errno = ENOSYS;
+        if (useKernelCopy) {
+            copied = kernelCopy(srcFd, current, destFd, current, chunk);
+            if (copied == 0) {
+                // The kernel copy stops early for some file systems (e. g. procfs,
+                // sysfs or some FUSE and NFS setups). Whether the end of the source
+                // file has really been reached is checked by reading the data.
+                useKernelCopy = false;
+                continue;
+            }
+        }
+
+        if ((copied < 0) && (errno == ENOSYS)) {
+            // copy the data in user space
+            if (m_buffer.isEmpty()) {
+                m_buffer.resize(BUFFER_SIZE);
+            }
+            const size_t size = QMIN(chunk, static_cast<size_t>(BUFFER_SIZE));
+            copied = ::pread(srcFd, m_buffer.data(), size, current);
+            if (copied < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return setError(errno, sourcePath(entry));
+            }
+            if (m_verify) {
+                m_hash.update(m_buffer.data(), copied);
+            }
+
+            ssize_t written = 0;
+            while (written < copied) {
+                const ssize_t result = ::pwrite(destFd, m_buffer.data() + written,
+                                                copied - written, current + written);
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return setError(errno, destPath(entry));
+                }
+                written += result;
+            }
+        }
+        else if (copied < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return setError(errno, destPath(entry));
+        }
+
+        if (copied == 0) {
+            // The source file has been truncated in the meantime. The missing
+            // data may not be replaced by zeros when restoring the size.
+            return setError(ERR_SOURCE_TRUNCATED, sourcePath(entry));
+        }
+
+        copiedTotal += copied;
+        m_processedSize += copied;
+
+        m_uncheckedSize += copied;
+        if ((m_journal != 0) && (m_uncheckedSize >= JOURNAL_CHECKPOINT_SIZE)) {
+            // Only data which is stored on the disk may be skipped when
+            // resuming the transfer after a crash of the system.
+            if (::fdatasync(destFd) == 0) {
+                m_journal->setProgress(entry.journalIndex, offset + copiedTotal);
+                m_journal->flush(entry.journalIndex);
+            }
+            m_uncheckedSize = 0;
+        }
+    }
+
+    return true;
+}
+
+void CopyFilesJob::hashHole(off_t length)
+{
+    if (!m_verify) {
+        return;
+    }
+
+    static const char zeros[4096] = { 0 };
+    while (length > 0) {
+        const size_t size = static_cast<size_t>(QMIN(length, static_cast<off_t>(sizeof(zeros))));
+        m_hash.update(zeros, size);
+        length -= size;
+    }
+}
+
+bool CopyFilesJob::hashCopiedData(int srcFd, off_t length, const LocalCopyJob::Entry& entry)
+{
+    if (m_buffer.isEmpty()) {
+        m_buffer.resize(BUFFER_SIZE);
+    }
+
+    off_t offset = 0;
+    while (offset < length) {
+        if (isCancelled()) {
+            return false;
+        }
+
+        const size_t size = static_cast<size_t>(QMIN(length - offset, static_cast<off_t>(BUFFER_SIZE)));
+        const ssize_t count = ::pread(srcFd, m_buffer.data(), size, offset);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return setError(errno, sourcePath(entry));
+        }
+        if (count == 0) {
+            break;
+        }
+        m_hash.update(m_buffer.data(), count);
+        offset += count;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Compares the hashes of copied files with the hashes of their sources.
+ *
+ * The written data is flushed to the disk and removed from the page
+ * cache before it is read again, so that the data on the disk is
+ * verified. The verification runs in parallel to the copying of
+ * the next files.
+ */
+class VerifyFilesJob : public CopyWorkerJob
+{
+public:
+    VerifyFilesJob(const QCString& destDir, const QValueVector<LocalCopyJob::Entry>& files);
+    virtual ~VerifyFilesJob();
+
+    /** Returns the paths of the copies, which differ from their sources. */
+    const QValueVector<QCString>& mismatches() const { return m_mismatches; }
+
+protected:
+    virtual void run();
+
+private:
+    /** Returns true, if the hash of the copy \a entry matches the hash of its source. */
+    bool verifyFile(const LocalCopyJob::Entry& entry);
+
+    QByteArray m_buffer;
+    QValueVector<QCString> m_mismatches;
+};
+
+VerifyFilesJob::VerifyFilesJob(const QCString& destDir,
+                               const QValueVector<LocalCopyJob::Entry>& files) :
+    CopyWorkerJob(QValueVector<QCString>(), destDir)
+{
+    assignEntries(files, 0, files.count());
+}
+
+VerifyFilesJob::~VerifyFilesJob()
+{
+}
+
+void VerifyFilesJob::run()
+{
+    QValueVector<LocalCopyJob::Entry>::ConstIterator it = m_entries.begin();
+    const QValueVector<LocalCopyJob::Entry>::ConstIterator end = m_entries.end();
+    while ((it != end) && !isCancelled()) {
+        if (!verifyFile(*it)) {
+            m_mismatches.append(destPath(*it));
+        }
+        ++it;
+    }
+}
+
+bool VerifyFilesJob::verifyFile(const LocalCopyJob::Entry& entry)
+{
+    const int fd = KDE_open(destPath(entry), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    ::fdatasync(fd);
+#ifdef POSIX_FADV_DONTNEED
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    if (m_buffer.isEmpty()) {
+        m_buffer.resize(BUFFER_SIZE);
+    }
+
+    XXHash64 hash;
+    KIO::filesize_t size = 0;
+    bool ok = true;
+    while (!isCancelled()) {
+        const ssize_t count = ::read(fd, m_buffer.data(), m_buffer.size());
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ok = false;
+            break;
+        }
+        if (count == 0) {
+            break;
+        }
+        hash.update(m_buffer.data(), count);
+        size += count;
+        m_processedSize += count;
+    }
+    ::close(fd);
+
+    return ok && (size == entry.size) && (hash.digest() == entry.hash);
+}
+
+/**
+ * @brief Applies the permissions and modification times of the source folders.
+ *
+ * The folders are processed in reverse order, so that the modification time
+ * of a parent folder is not touched anymore by changes of its children.
+ */
+class FinishFoldersJob : public CopyWorkerJob
+{
+public:
+    FinishFoldersJob(const QValueVector<QCString>& sourceDirs,
+                     const QCString& destDir,
+                     const QValueVector<LocalCopyJob::Entry>& folders);
+    virtual ~FinishFoldersJob();
+
+protected:
+    virtual void run();
+};
+
+FinishFoldersJob::FinishFoldersJob(const QValueVector<QCString>& sourceDirs,
+                                   const QCString& destDir,
+                                   const QValueVector<LocalCopyJob::Entry>& folders) :
+    CopyWorkerJob(sourceDirs, destDir)
+{
+    assignEntries(folders, 0, folders.count());
+}
+
+FinishFoldersJob::~FinishFoldersJob()
+{
+}
+
+void FinishFoldersJob::run()
+{
+    for (int i = static_cast<int>(m_entries.count()) - 1; i >= 0; --i) {
+        const LocalCopyJob::Entry& entry = m_entries[i];
+        const QCString path(destPath(entry));
+
+        struct utimbuf times;
+        times.actime = entry.atime;
+        times.modtime = entry.mtime;
+        ::utime(path, &times);
+        ::chmod(path, entry.mode & 07777);
+    }
+}
+
+/**
+ * @brief Deletes the copied source items of a move operation.
+ *
+ * Only the files, which have been copied, are deleted. Afterwards the
+ * source folders are removed from the bottom to the top, where folders
+ * still containing skipped items are kept.
+ */
+class RemoveSourcesJob : public CopyWorkerJob
+{
+public:
+    RemoveSourcesJob(const QValueVector<QCString>& sourceDirs,
+                     const QValueVector<LocalCopyJob::Entry>& folders,
+                     const QValueVector<LocalCopyJob::Entry>& items);
+    virtual ~RemoveSourcesJob();
+
+protected:
+    virtual void run();
+
+private:
+    uint m_folderCount;
+};
+
+RemoveSourcesJob::RemoveSourcesJob(const QValueVector<QCString>& sourceDirs,
+                                   const QValueVector<LocalCopyJob::Entry>& folders,
+                                   const QValueVector<LocalCopyJob::Entry>& items) :
+    CopyWorkerJob(sourceDirs, QCString()),
+    m_folderCount(folders.count())
+{
+    assignEntries(folders, 0, folders.count());
+    assignEntries(items, 0, items.count());
+}
+
+RemoveSourcesJob::~RemoveSourcesJob()
+{
+}
+
+void RemoveSourcesJob::run()
+{
+    const uint count = m_entries.count();
+    for (uint i = m_folderCount; (i < count) && !isCancelled(); ++i) {
+        const QCString path(sourcePath(m_entries[i]));
+        if ((::unlink(path) != 0) && (errno != ENOENT)) {
+            setError(errno, path);
+            return;
+        }
+    }
+
+    // the folders are collected in pre-order, hence the children are removed first
+    for (int i = static_cast<int>(m_folderCount) - 1; (i >= 0) && !isCancelled(); --i) {
+        const QCString path(sourcePath(m_entries[i]));
+        if ((::rmdir(path) != 0) && (errno != ENOTEMPTY) && (errno != EEXIST) && (errno != ENOENT)) {
+            setError(errno, path);
+            return;
+        }
+    }
+}
+
+LocalCopyJob::LocalCopyJob(const KURL::List& source,
+                           const KURL& dest,
+                           const ConflictResolutions& resolutions) :
+    KIO::Job(true),
+    m_phase(Scanning),
+    m_source(source),
+    m_dest(dest),
+    m_resolutions(resolutions),
+    m_verify(false),
+    m_move(false),
+    m_journal(0),
+    m_resumeJournal(0),
+    m_totalSize(0),
+    m_finishedSize(0),
+    m_progressTimer(0)
+{
+    m_progressTimer = new QTimer(this);
+    connect(m_progressTimer, SIGNAL(timeout()),
+            this, SLOT(updateProgress()));
+
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotJobFinished(WorkerJob*)));
+
+    // like the jobs of KIO the copying is started when returning to the event loop
+    QTimer::singleShot(0, this, SLOT(start()));
+}
+
+LocalCopyJob::~LocalCopyJob()
+{
+    // If the job is destroyed while copying (e. g. because Dolphin is closed),
+    // the journal file is kept, so that the transfer can be resumed later.
+    cancelJobs();
+    if ((m_journal != 0) && m_journal->deref()) {
+        delete m_journal;
+    }
+    delete m_resumeJournal;
+}
+
+bool LocalCopyJob::canCopy(const KURL::List& source, const KURL& dest)
+{
+    if (source.isEmpty() || !dest.isLocalFile()) {
+        return false;
+    }
+
+    const QString destPath(dest.path(-1));
+    KDE_struct_stat buf;
+    if ((KDE_stat(QFile::encodeName(destPath), &buf) != 0) || !S_ISDIR(buf.st_mode)) {
+        return false;
+    }
+
+    QMap<QString, bool> names;
+    KURL::List::ConstIterator it = source.begin();
+    const KURL::List::ConstIterator end = source.end();
+    while (it != end) {
+        const KURL& url = *it;
+        const QString name(url.fileName());
+        if (!url.isLocalFile() || name.isEmpty() || names.contains(name)) {
+            return false;
+        }
+        names.insert(name, true);
+
+        // KIO::copy() reports an error if a folder should be copied into itself
+        const QString sourcePath(url.path(-1));
+        if ((destPath + '/').startsWith(sourcePath + '/')) {
+            return false;
+        }
+
+        ++it;
+    }
+
+    return true;
+}
+
+void LocalCopyJob::setVerifyEnabled(bool verify)
+{
+    m_verify = verify;
+}
+
+void LocalCopyJob::setMoveEnabled(bool move)
+{
+    m_move = move;
+}
+
+void LocalCopyJob::setResumeJournal(TransferJournal* journal)
+{
+    delete m_resumeJournal;
+    m_resumeJournal = journal;
+}
+
+void LocalCopyJob::kill(bool quietly)
+{
+    m_progressTimer->stop();
+
+    // the user does not want to resume a cancelled transfer
+    if (m_journal != 0) {
+        m_journal->remove();
+    }
+    if (m_resumeJournal != 0) {
+        m_resumeJournal->remove();
+    }
+
+    cancelJobs();
+    KIO::Job::kill(quietly);
+}
+
+void LocalCopyJob::start()
+{
+    m_startTime.start();
+    m_progressTimer->start(200);
+    emit infoMessage(this, i18n("Examining..."));
+
+    QValueVector<QCString> sourcePaths;
+    KURL::List::ConstIterator it = m_source.begin();
+    const KURL::List::ConstIterator end = m_source.end();
+    while (it != end) {
+        sourcePaths.append(QFile::encodeName((*it).path(-1)));
+        ++it;
+    }
+
+    enqueue(new CopyScanJob(sourcePaths));
+}
+
+void LocalCopyJob::slotJobFinished(WorkerJob* job)
+{
+    CopyWorkerJob* copyJob = m_jobs.take(job);
+    if (copyJob == 0) {
+        // the job does not belong to this copy job
+        return;
+    }
+
+    if (copyJob->error() != 0) {
+        m_progressTimer->stop();
+        cancelJobs();
+        m_error = kioError(copyJob->error());
+        m_errorText = QFile::decodeName(copyJob->errorPath());
+        emitResult();
+        return;
+    }
+
+    m_finishedSize += copyJob->processedSize();
+
+    switch (m_phase) {
+        case Scanning: {
+            const CopyScanJob* scanJob = static_cast<CopyScanJob*>(copyJob);
+            m_sourceDirs = scanJob->sourceDirs();
+            m_folders = scanJob->folders();
+            m_specials = scanJob->specials();
+            m_files = scanJob->files();
+            m_totalSize = scanJob->totalSize();
+            if (!m_resolutions.isEmpty()) {
+                resolveConflicts(m_folders);
+                resolveConflicts(m_specials);
+                resolveConflicts(m_files);
+            }
+            if (m_resumeJournal != 0) {
+                applyResumeJournal();
+            }
+            if (!m_resolutions.isEmpty() || !m_resumedFiles.isEmpty()) {
+                m_totalSize = 0;
+                for (uint i = 0; i < m_files.count(); ++i) {
+                    m_totalSize += m_files[i].size;
+                }
+            }
+            createJournal();
+            if (m_verify) {
+                // each file is read again for the verification
+                m_totalSize *= 2;
+            }
+            emit totalSize(this, m_totalSize);
+            emit infoMessage(this, i18n("Copying..."));
+
+            m_phase = CreatingFolders;
+            enqueue(new CreateFoldersJob(m_sourceDirs, QFile::encodeName(m_dest.path(-1)),
+                                         m_folders, m_specials));
+            break;
+        }
+
+        case CreatingFolders:
+            m_phase = CopyingFiles;
+            copyFiles();
+            break;
+
+        case CopyingFiles:
+            if (m_verifyJobs.take(job) != 0) {
+                const QValueVector<QCString>& mismatches = static_cast<VerifyFilesJob*>(copyJob)->mismatches();
+                QValueVector<QCString>::ConstIterator it = mismatches.begin();
+                const QValueVector<QCString>::ConstIterator end = mismatches.end();
+                while (it != end) {
+                    m_mismatchedFiles.append(KURL::fromPathOrURL(QFile::decodeName(*it)));
+                    ++it;
+                }
+            }
+            else if (m_verify) {
+                const CopyFilesJob* filesJob = static_cast<CopyFilesJob*>(copyJob);
+                VerifyFilesJob* verifyJob = new VerifyFilesJob(QFile::encodeName(m_dest.path(-1)),
+                                                               filesJob->entries());
+                m_verifyJobs.insert(static_cast<WorkerJob*>(verifyJob), verifyJob);
+                enqueue(verifyJob);
+            }
+
+            if (m_jobs.isEmpty()) {
+                m_phase = FinishingFolders;
+                enqueue(new FinishFoldersJob(m_sourceDirs, QFile::encodeName(m_dest.path(-1)),
+                                             m_folders));
+            }
+            break;
+
+        case FinishingFolders:
+            if (m_move) {
+                m_phase = RemovingSources;
+                removeSources();
+            }
+            else {
+                finish();
+            }
+            break;
+
+        case RemovingSources: {
+            KDirNotify_stub allDirNotify("*", "KDirNotify*");
+            allDirNotify.FilesRemoved(m_source);
+            finish();
+            break;
+        }
+
+        default:
+            assert(false);
+            break;
+    }
+}
+
+void LocalCopyJob::updateProgress()
+{
+    KIO::filesize_t processed = m_finishedSize;
+    QPtrDictIterator<CopyWorkerJob> it(m_jobs);
+    while (it.current() != 0) {
+        processed += it.current()->processedSize();
+        ++it;
+    }
+
+    emit processedSize(this, processed);
+    emitPercent(processed, m_totalSize);
+
+    const int elapsed = m_startTime.elapsed();
+    if (elapsed > 0) {
+        emitSpeed(static_cast<unsigned long>((processed * 1000) / elapsed));
+    }
+}
+
+void LocalCopyJob::enqueue(CopyWorkerJob* job)
+{
+    m_jobs.insert(static_cast<WorkerJob*>(job), job);
+    WorkerPool::instance().enqueue(job, WorkerJob::Transfer);
+}
+
+void LocalCopyJob::resolveConflicts(QValueVector<Entry>& entries) const
+{
+    QValueVector<Entry> resolvedEntries;
+    resolvedEntries.reserve(entries.count());
+
+    const ConflictResolutions::ConstIterator resolutionsEnd = m_resolutions.end();
+    QValueVector<Entry>::Iterator it = entries.begin();
+    const QValueVector<Entry>::Iterator end = entries.end();
+    while (it != end) {
+        Entry& entry = *it;
+        ++it;
+
+        // A resolution of a parent folder applies to the entry too. The parent
+        // folders are checked from the top, as a resolved folder is not merged
+        // and contains no further conflicts.
+        bool skip = false;
+        int slashIndex = entry.path.find('/');
+        while (true) {
+            const QCString path((slashIndex < 0) ? entry.path : entry.path.left(slashIndex));
+            const ConflictResolutions::ConstIterator resolutionIt = m_resolutions.find(path);
+            if (resolutionIt != resolutionsEnd) {
+                const ConflictResolution& resolution = resolutionIt.data();
+                if (resolution.action == ConflictResolution::Skip) {
+                    skip = true;
+                }
+                else if (resolution.action == ConflictResolution::Overwrite) {
+                    entry.replace = (slashIndex < 0);
+                }
+                else {
+                    const int nameIndex = path.findRev('/') + 1;
+                    entry.destPath = path.left(nameIndex) + resolution.newName +
+                                     entry.path.mid(path.length());
+                }
+                break;
+            }
+
+            if (slashIndex < 0) {
+                break;
+            }
+            slashIndex = entry.path.find('/', slashIndex + 1);
+        }
+
+        if (!skip) {
+            resolvedEntries.append(entry);
+        }
+    }
+
+    entries = resolvedEntries;
+}
+
+void LocalCopyJob::applyResumeJournal()
+{
+    const QValueVector<TransferJournal::File>& journalFiles = m_resumeJournal->files();
+    QMap<QCString, uint> indices;
+    for (uint i = 0; i < journalFiles.count(); ++i) {
+        indices.insert(journalFiles[i].sourcePath, i);
+    }
+
+    QValueVector<Entry> files;
+    files.reserve(m_files.count());
+    QValueVector<Entry>::Iterator it = m_files.begin();
+    const QValueVector<Entry>::Iterator end = m_files.end();
+    while (it != end) {
+        Entry& entry = *it;
+        ++it;
+
+        KDE_struct_stat buf;
+        const bool exists = (KDE_lstat(destPath(entry), &buf) == 0);
+        const bool isRegularFile = exists && S_ISREG(buf.st_mode);
+
+        const QMap<QCString, uint>::ConstIterator indexIt = indices.find(sourcePath(entry));
+        if (indexIt == indices.end()) {
+            // The file has been added to the source after the transfer has
+            // been interrupted. Existing items of the destination are kept.
+            if (!exists || entry.replace) {
+                files.append(entry);
+            }
+            continue;
+        }
+
+        const uint index = indexIt.data();
+        const TransferJournal::File& file = journalFiles[index];
+        if ((file.size != entry.size) || (file.mtime != entry.mtime)) {
+            // the source has been modified, hence it is copied again
+            entry.replace = true;
+        }
+        else if (m_resumeJournal->isCompleted(index)) {
+            if (isRegularFile &&
+                (static_cast<KIO::filesize_t>(buf.st_size) == entry.size) &&
+                (buf.st_mtime == entry.mtime)) {
+                m_resumedFiles.append(entry);
+                continue;
+            }
+            entry.replace = true;
+        }
+        else {
+            const KIO::filesize_t progress = m_resumeJournal->progress(index);
+            if ((progress > 0) && isRegularFile &&
+                (static_cast<KIO::filesize_t>(buf.st_size) >= progress)) {
+                entry.resumeOffset = progress;
+            }
+            else {
+                // the partially copied file is copied again
+                entry.replace = true;
+            }
+        }
+        files.append(entry);
+    }
+    m_files = files;
+
+    // Existing symbolic links and FIFOs have been created by the interrupted transfer.
+    QValueVector<Entry> specials;
+    for (uint i = 0; i < m_specials.count(); ++i) {
+        KDE_struct_stat buf;
+        const Entry& entry = m_specials[i];
+        if (entry.replace || (KDE_lstat(destPath(entry), &buf) != 0)) {
+            specials.append(entry);
+        }
+    }
+    m_specials = specials;
+}
+
+void LocalCopyJob::createJournal()
+{
+    if ((m_resumeJournal == 0) && (m_totalSize < JOURNAL_MIN_SIZE)) {
+        return;
+    }
+
+    // The files, which have been copied before the transfer has been
+    // interrupted, are recorded too, so that their sources are still
+    // deleted by a move operation, which gets interrupted again.
+    const uint fileCount = m_files.count();
+    const uint resumedCount = m_resumedFiles.count();
+    QValueVector<TransferJournal::File> files;
+    files.reserve(fileCount + resumedCount);
+    for (uint i = 0; i < fileCount + resumedCount; ++i) {
+        Entry& entry = (i < fileCount) ? m_files[i] : m_resumedFiles[i - fileCount];
+        entry.journalIndex = i;
+
+        TransferJournal::File file;
+        file.sourcePath = sourcePath(entry);
+        file.size = entry.size;
+        file.mtime = entry.mtime;
+        files.append(file);
+    }
+
+    const DolphinCommand command(m_move ? DolphinCommand::Move : DolphinCommand::Copy,
+                                 m_source, m_dest);
+    m_journal = TransferJournal::create(command, m_resolutions, files);
+    if (m_journal != 0) {
+        for (uint i = 0; i < fileCount; ++i) {
+            m_journal->setProgress(i, m_files[i].resumeOffset);
+        }
+        for (uint i = fileCount; i < fileCount + resumedCount; ++i) {
+            m_journal->setCompleted(i);
+        }
+    }
+
+    if (m_resumeJournal != 0) {
+        // the progress has been taken over by the new journal
+        m_resumeJournal->remove();
+        delete m_resumeJournal;
+        m_resumeJournal = 0;
+    }
+}
+
+void LocalCopyJob::removeSources()
+{
+    // the sources of copies, which differ from their sources, are kept
+    QMap<QCString, bool> mismatches;
+    KURL::List::ConstIterator it = m_mismatchedFiles.begin();
+    const KURL::List::ConstIterator end = m_mismatchedFiles.end();
+    while (it != end) {
+        mismatches.insert(QFile::encodeName((*it).path()), true);
+        ++it;
+    }
+
+    QValueVector<Entry> items;
+    items.reserve(m_files.count() + m_resumedFiles.count() + m_specials.count());
+    for (uint i = 0; i < m_files.count(); ++i) {
+        if (!mismatches.contains(destPath(m_files[i]))) {
+            items.append(m_files[i]);
+        }
+    }
+    for (uint i = 0; i < m_resumedFiles.count(); ++i) {
+        items.append(m_resumedFiles[i]);
+    }
+    for (uint i = 0; i < m_specials.count(); ++i) {
+        items.append(m_specials[i]);
+    }
+
+    enqueue(new RemoveSourcesJob(m_sourceDirs, m_folders, items));
+}
+
+QCString LocalCopyJob::sourcePath(const Entry& entry) const
+{
+    QCString path(m_sourceDirs[entry.sourceDir]);
+    path += '/';
+    path += entry.path;
+    return path;
+}
+
+QCString LocalCopyJob::destPath(const Entry& entry) const
+{
+    QCString path(QFile::encodeName(m_dest.path(-1)));
+    path += '/';
+    path += entry.destPath.isEmpty() ? entry.path : entry.destPath;
+    return path;
+}
+
+void LocalCopyJob::copyFiles()
+{
+    const QCString destDir(QFile::encodeName(m_dest.path(-1)));
+    const uint count = m_files.count();
+
+    uint first = 0;
+    KIO::filesize_t batchSize = 0;
+    for (uint i = 0; i < count; ++i) {
+        const KIO::filesize_t size = m_files[i].size;
+        if (size >= LARGE_FILE_SIZE) {
+            // Large files are copied by separate jobs, so that they
+            // are copied in parallel to the batches of small files.
+            if (i > first) {
+                enqueue(new CopyFilesJob(m_sourceDirs, destDir, m_files, first, i, m_verify, m_journal));
+            }
+            enqueue(new CopyFilesJob(m_sourceDirs, destDir, m_files, i, i + 1, m_verify, m_journal));
+            first = i + 1;
+            batchSize = 0;
+            continue;
+        }
+
+        batchSize += size;
+        if ((i + 1 - first >= BATCH_FILE_COUNT) || (batchSize >= BATCH_SIZE)) {
+            enqueue(new CopyFilesJob(m_sourceDirs, destDir, m_files, first, i + 1, m_verify, m_journal));
+            first = i + 1;
+            batchSize = 0;
+        }
+    }
+
+    if (first < count) {
+        enqueue(new CopyFilesJob(m_sourceDirs, destDir, m_files, first, count, m_verify, m_journal));
+    }
+
+    if (m_jobs.isEmpty()) {
+        m_phase = FinishingFolders;
+        enqueue(new FinishFoldersJob(m_sourceDirs, destDir, m_folders));
+    }
+}
+
+void LocalCopyJob::cancelJobs()
+{
+    WorkerPool& pool = WorkerPool::instance();
+    QPtrDictIterator<CopyWorkerJob> it(m_jobs);
+    while (it.current() != 0) {
+        pool.cancel(it.current());
+        ++it;
+    }
+    m_jobs.clear();
+    m_verifyJobs.clear();
+}
+
+void LocalCopyJob::finish()
+{
+    m_progressTimer->stop();
+    updateProgress();
+
+    // inform other applications (e. g. Konqueror) about the new items
+    KDirNotify_stub allDirNotify("*", "KDirNotify*");
+    allDirNotify.FilesAdded(m_dest);
+
+    if (m_verify) {
+        // the result of the verification is passed like the trash URLs of KIO::trash()
+        m_incomingMetaData.insert("verified", "true");
+        uint index = 0;
+        KURL::List::ConstIterator it = m_mismatchedFiles.begin();
+        const KURL::List::ConstIterator end = m_mismatchedFiles.end();
+        while (it != end) {
+            m_incomingMetaData.insert(QString("verifyFailed-%1").arg(index), (*it).url());
+            ++index;
+            ++it;
+        }
+    }
+
+    if (m_journal != 0) {
+        m_journal->remove();
+    }
+
+    emitResult();
+}
+
+#include "localcopyjob.moc"
@@ -0,0 +1,238 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef LOCALCOPYJOB_H
+#define LOCALCOPYJOB_H
+
+#include <qcstring.h>
+#include <qdatetime.h>
+#include <qptrdict.h>
+#include <qvaluevector.h>
+
+#include <kio/job.h>
+#include <kurl.h>
+
+#include <sys/types.h>
+
+#include "conflictscanjob.h"
+
+class QTimer;
+class TransferJournal;
+class WorkerJob;
+class CopyWorkerJob;
+class VerifyFilesJob;
+
+/**
+ * @brief Copies local files and folders by the threads of the worker pool.
+ *
+ * KIO::copy() streams each file through the file I/O slave in fixed chunks,
+ * one file after the other. For copying local files into a local folder the
+ * LocalCopyJob uses the interfaces of the kernel instead:
+ * - If source and destination are located on a file system supporting
+ *   reflinks (e. g. btrfs or XFS), the file data is shared by FICLONE.
+ * - Otherwise the data is copied inside the kernel by copy_file_range()
+ *   or sendfile(). Holes of sparse files are skipped by SEEK_DATA/SEEK_HOLE.
+ * - Small files are copied in batches, large files as separate jobs of
+ *   the WorkerPool, so that several files are copied in parallel.
+ *
+ * Large transfers are recorded in a TransferJournal, so that they can be
+ * resumed after Dolphin has been closed or has crashed (see
+ * LocalCopyJob::setResumeJournal()).
+ *
+ * The LocalCopyJob is a KIO::Job, hence it can be used at all places where
+ * a job returned by KIO::copy() is expected (e. g. for registering the undo
+ * operation by Dolphin::addPendingUndoJob()). It may only be used if
+ * LocalCopyJob::canCopy() returns true.
+ */
+class LocalCopyJob : public KIO::Job
+{
+    Q_OBJECT
+
+public:
+    /** Describes one item of the copied tree. */
+    struct Entry
+    {
+        /** Index of the folder inside the source folders, which contains the copied item. */
+        uint sourceDir;
+
+        /** Path relative to the source folder and to the destination folder. */
+        QCString path;
+
+        /**
+         * Path relative to the destination folder, if the item or one
+         * of its parent folders gets renamed. Otherwise the string is empty.
+         */
+        QCString destPath;
+
+        /** Target of a symbolic link. */
+        QCString linkTarget;
+
+        /** Is true, if an existing item of the destination is replaced. */
+        bool replace;
+
+        /** Index of the file inside the transfer journal. */
+        uint journalIndex;
+
+        /** Number of bytes, which have been copied before the transfer has been interrupted. */
+        KIO::filesize_t resumeOffset;
+
+        /** XXH64 hash of the source file, if verifying is enabled. */
+        Q_UINT64 hash;
+
+        mode_t mode;
+        KIO::filesize_t size;
+        time_t atime;
+        time_t mtime;
+    };
+
+    /**
+     * Copies the local files and folders \a source into the local folder \a dest.
+     * Items, which already exist inside \a dest, are handled corresponding
+     * to \a resolutions (see ConflictScanJob). Existing folders are merged.
+     */
+    LocalCopyJob(const KURL::List& source,
+                 const KURL& dest,
+                 const ConflictResolutions& resolutions = ConflictResolutions());
+    virtual ~LocalCopyJob();
+
+    /**
+     * Returns true, if the URLs \a source can be copied by a LocalCopyJob
+     * into \a dest. This is the case if all URLs are local and have different
+     * names, \a dest is an existing folder and \a dest is not located inside
+     * a source folder. Conflicts with existing items of \a dest must be
+     * resolved before by a ConflictScanJob.
+     */
+    static bool canCopy(const KURL::List& source, const KURL& dest);
+
+    /**
+     * Enables the verifying of the copied files. The hash of each source file
+     * is calculated while copying it and compared with the hash of the copy,
+     * which is read again from the disk. The copies, which differ from their
+     * sources, are passed as meta data 'verifyFailed-0', 'verifyFailed-1', ...
+     * of the job. Must be invoked before returning to the event loop.
+     */
+    void setVerifyEnabled(bool verify);
+
+    /**
+     * Turns the copy operation into a move operation: the source items are
+     * deleted after they have been copied. This is used for moving items
+     * between different local file systems. Must be invoked before
+     * returning to the event loop.
+     */
+    void setMoveEnabled(bool move);
+
+    /**
+     * Resumes the interrupted transfer of the journal \a journal, which must
+     * have been created for the same sources and destination. Files, which
+     * have been copied completely and whose source has not been modified, are
+     * skipped. Partially copied files are continued at the last recorded offset.
+     * The job takes over the reference of the journal. Must be invoked before
+     * returning to the event loop.
+     */
+    void setResumeJournal(TransferJournal* journal);
+
+    /** @see KIO::Job::kill() */
+    virtual void kill(bool quietly = true);
+
+private slots:
+    void start();
+    void slotJobFinished(WorkerJob* job);
+    void updateProgress();
+
+private:
+    enum Phase
+    {
+        Scanning,
+        CreatingFolders,
+        CopyingFiles,
+        FinishingFolders,
+        RemovingSources
+    };
+
+    /** Adds the job \a job to the worker pool and remembers it as running job. */
+    void enqueue(CopyWorkerJob* job);
+
+    /**
+     * Applies the conflict resolutions to the entries \a entries: skipped
+     * entries are removed, the destination of renamed entries is adjusted.
+     */
+    void resolveConflicts(QValueVector<Entry>& entries) const;
+
+    /**
+     * Adjusts the files, folders and special files corresponding to the
+     * progress recorded by the journal of the interrupted transfer.
+     */
+    void applyResumeJournal();
+
+    /**
+     * Creates the journal for the files to copy, if the transfer is large
+     * enough that resuming it later is worthwhile.
+     */
+    void createJournal();
+
+    /** Enqueues the job, which deletes the copied source items of a move operation. */
+    void removeSources();
+
+    /** Returns the absolute path of the source item \a entry. */
+    QCString sourcePath(const Entry& entry) const;
+
+    /** Returns the absolute path of the copy of \a entry. */
+    QCString destPath(const Entry& entry) const;
+
+    /** Enqueues the jobs for copying the files after the folders have been created. */
+    void copyFiles();
+
+    /** Cancels all running jobs of the worker pool. */
+    void cancelJobs();
+
+    /** Informs the progress observer and emits the result of the job. */
+    void finish();
+
+    Phase m_phase;
+    KURL::List m_source;
+    KURL m_dest;
+    ConflictResolutions m_resolutions;
+    bool m_verify;
+    bool m_move;
+
+    QValueVector<QCString> m_sourceDirs;
+    QValueVector<Entry> m_folders;
+    QValueVector<Entry> m_specials;
+    QValueVector<Entry> m_files;
+
+    /** Files which have been copied completely before the transfer has been interrupted. */
+    QValueVector<Entry> m_resumedFiles;
+
+    TransferJournal* m_journal;
+    TransferJournal* m_resumeJournal;
+
+    KIO::filesize_t m_totalSize;
+
+    /** Size of the files, which have been copied by already finished jobs. */
+    KIO::filesize_t m_finishedSize;
+
+    QPtrDict<CopyWorkerJob> m_jobs;
+    QPtrDict<VerifyFilesJob> m_verifyJobs;
+    KURL::List m_mismatchedFiles;
+    QTimer* m_progressTimer;
+    QTime m_startTime;
+};
+
+#endif
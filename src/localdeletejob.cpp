@@ -0,0 +1,883 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "localdeletejob.h"
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#endif
+
+#include <qfile.h>
+#include <qmutex.h>
+#include <qtimer.h>
+
+#include <kdirnotify_stub.h>
+#include <klocale.h>
+
+#include "workerpool.h"
+
+#if defined(Q_OS_LINUX) && defined(SYS_getdents64)
+#define USE_GETDENTS64
+#endif
+
+// Number of emptied folders, which are collected before they are removed by one job.
+#define REMOVE_BATCH_SIZE 256
+
+// Size of the buffer for reading the folder entries.
+#define DIRENT_BUFFER_SIZE (64 * 1024)
+
+// Number of folder descriptors, which are kept open at most while other folders are read.
+#define MAX_OPEN_FOLDERS 256
+
+/** Maps the error number \a errnum to an error code of KIO. */
+static int kioError(int errnum)
+{
+    switch (errnum) {
+        case EACCES:
+        case EPERM:  return KIO::ERR_ACCESS_DENIED;
+        case EROFS:  return KIO::ERR_WRITE_ACCESS_DENIED;
+        case ENOENT: return KIO::ERR_DOES_NOT_EXIST;
+        case ENOTEMPTY:
+        case EBUSY:  return KIO::ERR_COULD_NOT_RMDIR;
+        default:     return KIO::ERR_CANNOT_DELETE;
+    }
+}
+
+/**
+ * @brief Reads the entries of a folder.
+ *
+ * On Linux the entries are read in large blocks by getdents64(), otherwise
+ * readdir() is used. Removing entries while the folder is read is allowed.
+ */
+class FolderReader
+{
+public:
+    /** Reads the folder with the descriptor \a fd. The descriptor is closed by the reader. */
+    FolderReader(int fd);
+    ~FolderReader();
+
+    int fd() const { return m_fd; }
+
+    /**
+     * Returns the name of the next entry and writes its type (DT_DIR, DT_REG, ...)
+     * to \a type. 0 is returned if all entries have been read or an error occurred.
+     * The entries '.' and '..' are skipped.
+     */
+    const char* next(unsigned char& type);
+
+    /** Returns the error number of a failed read or 0. */
+    int error() const { return m_error; }
+
+private:
+    int m_fd;
+    int m_error;
+#ifdef USE_GETDENTS64
+    QByteArray m_buffer;
+    long m_offset;
+    long m_size;
+#else
+    DIR* m_dir;
+#endif
+};
+
+#ifdef USE_GETDENTS64
+struct LinuxDirent64
+{
+    Q_UINT64 d_ino;
+    Q_INT64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+#endif
+
+FolderReader::FolderReader(int fd) :
+    m_fd(fd),
+    m_error(0)
+#ifdef USE_GETDENTS64
+    , m_buffer(DIRENT_BUFFER_SIZE),
+    m_offset(0),
+    m_size(0)
+#else
+    , m_dir(0)
+#endif
+{
+#ifndef USE_GETDENTS64
+    m_dir = ::fdopendir(fd);
+    if (m_dir == 0) {
+        m_error = errno;
+    }
+#endif
+}
+
+FolderReader::~FolderReader()
+{
+#ifdef USE_GETDENTS64
+    ::close(m_fd);
+#else
+    if (m_dir != 0) {
+        ::closedir(m_dir);
+    }
+    else {
+        ::close(m_fd);
+    }
+#endif
+}
+
+const char* FolderReader::next(unsigned char& type)
+{
+#ifdef USE_GETDENTS64
+    while (m_error == 0) {
+        if (m_offset >= m_size) {
+            const long size = ::syscall(SYS_getdents64, m_fd, m_buffer.data(), m_buffer.size());
+            if (size < 0) {
+                if (errno != EINTR) {
+                    m_error = errno;
+                }
+                continue;
+            }
+            if (size == 0) {
+                return 0;
+            }
+            m_size = size;
+            m_offset = 0;
+        }
+
+        const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(m_buffer.data() + m_offset);
+        m_offset += entry->d_reclen;
+
+        const char* name = entry->d_name;
+        if ((qstrcmp(name, ".") != 0) && (qstrcmp(name, "..") != 0)) {
+            type = entry->d_type;
+            return name;
+        }
+    }
+#else
+    while (m_dir != 0) {
+        errno = 0;
+        const struct dirent* entry = ::readdir(m_dir);
+        if (entry == 0) {
+            m_error = errno;
+            return 0;
+        }
+
+        const char* name = entry->d_name;
+        if ((qstrcmp(name, ".") != 0) && (qstrcmp(name, "..") != 0)) {
+#ifdef _DIRENT_HAVE_D_TYPE
+            type = entry->d_type;
+#else
+            type = DT_UNKNOWN;
+#endif
+            return name;
+        }
+    }
+#endif
+
+    return 0;
+}
+
+/**
+ * @brief Reference counted descriptor of a folder.
+ *
+ * The descriptor of a folder is used by the jobs for its subfolders, which
+ * might still be running after the LocalDeleteJob has released the folder
+ * (e. g. when cancelling). The descriptor is closed as soon as the last
+ * reference has been released, hence a job never uses a closed or reused
+ * descriptor. The reference counting is thread-safe.
+ */
+class FolderHandle
+{
+public:
+    /** Takes the ownership of the descriptor \a fd. AT_FDCWD is never closed. */
+    FolderHandle(int fd) : m_fd(fd), m_refCount(1) {}
+
+    int fd() const { return m_fd; }
+
+    FolderHandle* ref();
+    void deref();
+
+private:
+    ~FolderHandle();
+
+    int m_fd;
+    int m_refCount;
+    static QMutex m_mutex;
+};
+
+QMutex FolderHandle::m_mutex;
+
+FolderHandle::~FolderHandle()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+FolderHandle* FolderHandle::ref()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_refCount;
+    return this;
+}
+
+void FolderHandle::deref()
+{
+    m_mutex.lock();
+    const bool unused = (--m_refCount == 0);
+    m_mutex.unlock();
+    if (unused) {
+        delete this;
+    }
+}
+
+/**
+ * @brief Base class for the jobs of a LocalDeleteJob, which are executed by the worker pool.
+ *
+ * All data is deep copied when the job is created, so that the worker
+ * thread does not share any implicitly shared Qt data with the GUI thread.
+ */
+class DeleteWorkerJob : public WorkerJob
+{
+public:
+    enum Type
+    {
+        ReadFolder,
+        RemoveFolders
+    };
+
+    DeleteWorkerJob(Type type);
+    virtual ~DeleteWorkerJob();
+
+    Type type() const { return m_type; }
+
+    /** Returns the error number of the first error, or 0 if no error occured. */
+    int error() const { return m_error; }
+
+    /** Returns the path of the item, which caused the error. */
+    const QCString& errorPath() const { return m_errorPath; }
+
+    /** Returns the number of items, which have been deleted by the job. Is thread-safe. */
+    unsigned long deletedCount() const { return m_deletedCount; }
+
+protected:
+    /** Remembers the error \a errnum for the path \a path and returns false. */
+    bool setError(int errnum, const QCString& path);
+
+    volatile unsigned long m_deletedCount;
+
+private:
+    Type m_type;
+    int m_error;
+    QCString m_errorPath;
+};
+
+DeleteWorkerJob::DeleteWorkerJob(Type type) :
+    m_deletedCount(0),
+    m_type(type),
+    m_error(0)
+{
+}
+
+DeleteWorkerJob::~DeleteWorkerJob()
+{
+}
+
+bool DeleteWorkerJob::setError(int errnum, const QCString& path)
+{
+    if (m_error == 0) {
+        m_error = errnum;
+        m_errorPath = path;
+    }
+    return false;
+}
+
+/**
+ * @brief Deletes all items of a folder except the subfolders.
+ *
+ * The folder is opened relative to the descriptor of its parent folder.
+ * The names of the subfolders are returned by DeleteFolderJob::subfolders(),
+ * so that they can be processed by separate jobs. The root job, which gets
+ * the paths of the deleted items instead of a folder, handles the items
+ * in the same way.
+ */
+class DeleteFolderJob : public DeleteWorkerJob
+{
+public:
+    /**
+     * Deletes the items of the folder \a name inside the parent folder
+     * \a parent. The folder has the index \a folderIndex, \a path is only
+     * used for error messages. The job takes the reference \a parent.
+     */
+    DeleteFolderJob(int folderIndex, FolderHandle* parent, const QCString& name, const QCString& path);
+
+    /** Deletes the items \a paths, which are given by absolute paths. */
+    DeleteFolderJob(int folderIndex, const QValueVector<QCString>& paths);
+
+    virtual ~DeleteFolderJob();
+
+    int folderIndex() const { return m_folderIndex; }
+
+    /** Returns the names of the subfolders (absolute paths for the root job). */
+    const QValueVector<QCString>& subfolders() const { return m_subfolders; }
+
+    /**
+     * Returns the descriptor of the read folder and passes the
+     * reference to the caller. 0 is returned for the root job.
+     */
+    FolderHandle* takeHandle();
+
+protected:
+    virtual void run();
+
+private:
+    /**
+     * Deletes the item \a name of the folder \a dirFd, if it is no folder.
+     * Folders are added to the subfolders instead.
+     */
+    bool deleteItem(int dirFd, const char* name, unsigned char type);
+
+    QCString itemPath(const char* name) const;
+
+    int m_folderIndex;
+    FolderHandle* m_parent;
+    FolderHandle* m_handle;
+    QCString m_name;
+    QCString m_path;
+    QValueVector<QCString> m_paths;
+    QValueVector<QCString> m_subfolders;
+};
+
+DeleteFolderJob::DeleteFolderJob(int folderIndex,
+                                 FolderHandle* parent,
+                                 const QCString& name,
+                                 const QCString& path) :
+    DeleteWorkerJob(ReadFolder),
+    m_folderIndex(folderIndex),
+    m_parent(parent),
+    m_handle(0),
+    m_name(name.copy()),
+    m_path(path.copy())
+{
+}
+
+DeleteFolderJob::DeleteFolderJob(int folderIndex, const QValueVector<QCString>& paths) :
+    DeleteWorkerJob(ReadFolder),
+    m_folderIndex(folderIndex),
+    m_parent(0),
+    m_handle(0)
+{
+    m_paths.reserve(paths.count());
+    QValueVector<QCString>::ConstIterator it = paths.begin();
+    const QValueVector<QCString>::ConstIterator end = paths.end();
+    while (it != end) {
+        m_paths.append((*it).copy());
+        ++it;
+    }
+}
+
+DeleteFolderJob::~DeleteFolderJob()
+{
+    if (m_handle != 0) {
+        m_handle->deref();
+    }
+    if (m_parent != 0) {
+        m_parent->deref();
+    }
+}
+
+FolderHandle* DeleteFolderJob::takeHandle()
+{
+    FolderHandle* handle = m_handle;
+    m_handle = 0;
+    return handle;
+}
+
+void DeleteFolderJob::run()
+{
+    if (m_path.isEmpty()) {
+        QValueVector<QCString>::ConstIterator it = m_paths.begin();
+        const QValueVector<QCString>::ConstIterator end = m_paths.end();
+        while ((it != end) && !isCancelled()) {
+            if (!deleteItem(AT_FDCWD, *it, DT_UNKNOWN)) {
+                return;
+            }
+            ++it;
+        }
+        return;
+    }
+
+    // Symbolic links are never followed, the link itself is deleted by the parent
+    // folder. As the folder is opened relative to its parent, a replaced parent
+    // folder cannot redirect the deleting.
+    const int fd = ::openat(m_parent->fd(), m_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            setError(errno, m_path);
+        }
+        return;
+    }
+    m_handle = new FolderHandle(fd);
+
+    // the reader closes its own descriptor, the folder descriptor is kept for the subfolders
+    const int readerFd = ::dup(fd);
+    if (readerFd < 0) {
+        setError(errno, m_path);
+        return;
+    }
+
+    FolderReader reader(readerFd);
+    unsigned char type = DT_UNKNOWN;
+    const char* name = 0;
+    while (!isCancelled() && ((name = reader.next(type)) != 0)) {
+        if (!deleteItem(reader.fd(), name, type)) {
+            return;
+        }
+    }
+
+    if (reader.error() != 0) {
+        setError(reader.error(), m_path);
+    }
+}
+
+bool DeleteFolderJob::deleteItem(int dirFd, const char* name, unsigned char type)
+{
+    if (type == DT_UNKNOWN) {
+        struct stat buf;
+        if (::fstatat(dirFd, name, &buf, AT_SYMLINK_NOFOLLOW) != 0) {
+            return (errno == ENOENT) ? true : setError(errno, itemPath(name));
+        }
+        type = S_ISDIR(buf.st_mode) ? DT_DIR : DT_REG;
+    }
+
+    if (type == DT_DIR) {
+        m_subfolders.append(QCString(name));
+        return true;
+    }
+
+    if ((::unlinkat(dirFd, name, 0) != 0) && (errno != ENOENT)) {
+        return setError(errno, itemPath(name));
+    }
+    ++m_deletedCount;
+    return true;
+}
+
+QCString DeleteFolderJob::itemPath(const char* name) const
+{
+    if (m_path.isEmpty()) {
+        return QCString(name);
+    }
+
+    QCString path(m_path);
+    path += '/';
+    path += name;
+    return path;
+}
+
+/**
+ * @brief Removes empty folders.
+ *
+ * Each folder is removed by unlinkat() relative to the descriptor of
+ * its parent folder. The folders of one job never contain each other.
+ */
+class RemoveFoldersJob : public DeleteWorkerJob
+{
+public:
+    RemoveFoldersJob();
+    virtual ~RemoveFoldersJob();
+
+    /**
+     * Adds the folder \a name of the parent folder \a parent having the index
+     * \a folderIndex. The job takes the reference \a parent, \a path is only
+     * used for error messages.
+     */
+    void addFolder(int folderIndex, FolderHandle* parent, const QCString& name, const QCString& path);
+
+    const QValueVector<int>& folderIndices() const { return m_folderIndices; }
+
+protected:
+    virtual void run();
+
+private:
+    QValueVector<int> m_folderIndices;
+    QValueVector<FolderHandle*> m_parents;
+    QValueVector<QCString> m_names;
+    QValueVector<QCString> m_paths;
+};
+
+RemoveFoldersJob::RemoveFoldersJob() :
+    DeleteWorkerJob(RemoveFolders)
+{
+}
+
+RemoveFoldersJob::~RemoveFoldersJob()
+{
+    QValueVector<FolderHandle*>::ConstIterator it = m_parents.begin();
+    const QValueVector<FolderHandle*>::ConstIterator end = m_parents.end();
+    while (it != end) {
+        (*it)->deref();
+        ++it;
+    }
+}
+
+void RemoveFoldersJob::addFolder(int folderIndex,
+                                 FolderHandle* parent,
+                                 const QCString& name,
+                                 const QCString& path)
+{
+    m_folderIndices.append(folderIndex);
+    m_parents.append(parent);
+    m_names.append(name.copy());
+    m_paths.append(path.copy());
+}
+
+void RemoveFoldersJob::run()
+{
+    const uint count = m_names.count();
+    for (uint i = 0; (i < count) && !isCancelled(); ++i) {
+        if ((::unlinkat(m_parents[i]->fd(), m_names[i], AT_REMOVEDIR) != 0) && (errno != ENOENT)) {
+            setError(errno, m_paths[i]);
+            return;
+        }
+        ++m_deletedCount;
+    }
+}
+
+LocalDeleteJob::LocalDeleteJob(const KURL::List& urls, bool contentsOnly) :
+    KIO::Job(true),
+    m_urls(urls),
+    m_contentsOnly(contentsOnly),
+    m_finished(false),
+    m_readingJobs(0),
+    m_openFolders(0),
+    m_deletedCount(0),
+    m_removedFolders(0),
+    m_progressTimer(0)
+{
+    m_progressTimer = new QTimer(this);
+    connect(m_progressTimer, SIGNAL(timeout()),
+            this, SLOT(updateProgress()));
+
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotJobFinished(WorkerJob*)));
+
+    // like the jobs of KIO the deleting is started when returning to the event loop
+    QTimer::singleShot(0, this, SLOT(start()));
+}
+
+LocalDeleteJob::~LocalDeleteJob()
+{
+    cancelJobs();
+    closeFolders();
+}
+
+bool LocalDeleteJob::canDelete(const KURL::List& urls)
+{
+    if (urls.isEmpty()) {
+        return false;
+    }
+
+    KURL::List::ConstIterator it = urls.begin();
+    const KURL::List::ConstIterator end = urls.end();
+    while (it != end) {
+        // the root folder is left to KIO::del(), which reports an error
+        if (!(*it).isLocalFile() || ((*it).path(-1) == "/")) {
+            return false;
+        }
+        ++it;
+    }
+
+    return true;
+}
+
+void LocalDeleteJob::kill(bool quietly)
+{
+    m_progressTimer->stop();
+    cancelJobs();
+    closeFolders();
+    KIO::Job::kill(quietly);
+}
+
+void LocalDeleteJob::start()
+{
+    m_progressTimer->start(200);
+    emit infoMessage(this, i18n("Deleting..."));
+
+    // The root folder represents the deleted items. It is
+    // never removed and finishes the job as soon as it is empty.
+    Folder root;
+    root.handle = new FolderHandle(AT_FDCWD);
+    root.parent = -1;
+    root.pendingCount = 1;
+    root.keep = true;
+    m_folders.append(root);
+
+    QValueVector<QCString> paths;
+    KURL::List::ConstIterator it = m_urls.begin();
+    const KURL::List::ConstIterator end = m_urls.end();
+    while (it != end) {
+        paths.append(QFile::encodeName((*it).path(-1)));
+        ++it;
+    }
+
+    ++m_readingJobs;
+    enqueue(new DeleteFolderJob(0, paths));
+}
+
+void LocalDeleteJob::slotJobFinished(WorkerJob* job)
+{
+    DeleteWorkerJob* deleteJob = m_jobs.take(job);
+    if (deleteJob == 0) {
+        // the job does not belong to this delete job
+        return;
+    }
+
+    if (deleteJob->error() != 0) {
+        m_progressTimer->stop();
+        cancelJobs();
+        closeFolders();
+        m_error = kioError(deleteJob->error());
+        m_errorText = QFile::decodeName(deleteJob->errorPath());
+        emitResult();
+        return;
+    }
+
+    m_deletedCount += deleteJob->deletedCount();
+
+    if (deleteJob->type() == DeleteWorkerJob::ReadFolder) {
+        --m_readingJobs;
+        DeleteFolderJob* folderJob = static_cast<DeleteFolderJob*>(deleteJob);
+        const int index = folderJob->folderIndex();
+        FolderHandle* handle = folderJob->takeHandle();
+        if (handle != 0) {
+            m_folders[index].handle = handle;
+            ++m_openFolders;
+        }
+
+        const QValueVector<QCString>& subfolders = folderJob->subfolders();
+        m_folders[index].pendingCount += subfolders.count();
+
+        QValueVector<QCString>::ConstIterator it = subfolders.begin();
+        const QValueVector<QCString>::ConstIterator end = subfolders.end();
+        while (it != end) {
+            Folder folder;
+            folder.name = *it;
+            if (index == 0) {
+                folder.path = *it;
+            }
+            else {
+                folder.path = m_folders[index].path + '/' + *it;
+            }
+            folder.handle = 0;
+            folder.parent = index;
+            folder.pendingCount = 1;
+            folder.keep = m_contentsOnly && (index == 0);
+            m_folders.append(folder);
+
+            readFolder(m_folders.count() - 1);
+            ++it;
+        }
+
+        // the folder has been read completely
+        if (--m_folders[index].pendingCount == 0) {
+            folderEmptied(index);
+        }
+        readDeferredFolders();
+    }
+    else {
+        const QValueVector<int>& indices = static_cast<RemoveFoldersJob*>(deleteJob)->folderIndices();
+        m_removedFolders += indices.count();
+        QValueVector<int>::ConstIterator it = indices.begin();
+        const QValueVector<int>::ConstIterator end = indices.end();
+        while (it != end) {
+            folderRemoved(*it);
+            ++it;
+        }
+        readDeferredFolders();
+    }
+
+    if (m_finished) {
+        finish();
+    }
+    else {
+        // as long as folders are read, the removing is done in batches
+        removeEmptiedFolders(m_readingJobs == 0);
+    }
+}
+
+void LocalDeleteJob::updateProgress()
+{
+    unsigned long deleted = m_deletedCount;
+    QPtrDictIterator<DeleteWorkerJob> it(m_jobs);
+    while (it.current() != 0) {
+        deleted += it.current()->deletedCount();
+        ++it;
+    }
+
+    emit infoMessage(this, i18n("Deleted 1 item", "Deleted %n items", deleted));
+    emitPercent(m_removedFolders, m_folders.count());
+}
+
+void LocalDeleteJob::enqueue(DeleteWorkerJob* job)
+{
+    m_jobs.insert(static_cast<WorkerJob*>(job), job);
+    WorkerPool::instance().enqueue(job, WorkerJob::Transfer);
+}
+
+void LocalDeleteJob::readFolder(int index)
+{
+    // Each folder with subfolders keeps its descriptor open until the subfolders
+    // have been removed. To stay below the descriptor limit for wide trees, no
+    // additional folders are read while too many folders are open. At least one
+    // folder is always read, so that the deleting cannot get stuck.
+    if ((m_openFolders >= MAX_OPEN_FOLDERS) && (m_readingJobs > 0)) {
+        m_deferredFolders.append(index);
+        return;
+    }
+
+    const Folder& folder = m_folders[index];
+    ++m_readingJobs;
+    enqueue(new DeleteFolderJob(index,
+                                m_folders[folder.parent].handle->ref(),
+                                folder.name,
+                                folder.path));
+}
+
+void LocalDeleteJob::readDeferredFolders()
+{
+    // the most recently found folders are read first, so that
+    // subtrees get finished and their descriptors closed
+    while (!m_deferredFolders.isEmpty() &&
+           ((m_openFolders < MAX_OPEN_FOLDERS) || (m_readingJobs == 0))) {
+        const int index = m_deferredFolders.back();
+        m_deferredFolders.pop_back();
+        readFolder(index);
+    }
+}
+
+void LocalDeleteJob::closeFolder(int index)
+{
+    FolderHandle* handle = m_folders[index].handle;
+    if (handle != 0) {
+        m_folders[index].handle = 0;
+        handle->deref();
+        if (index > 0) {
+            --m_openFolders;
+        }
+    }
+}
+
+void LocalDeleteJob::closeFolders()
+{
+    const int count = m_folders.count();
+    for (int i = 0; i < count; ++i) {
+        closeFolder(i);
+    }
+    m_deferredFolders.clear();
+}
+
+void LocalDeleteJob::folderEmptied(int index)
+{
+    // the subfolders have been removed, the descriptor is not needed anymore
+    if (index > 0) {
+        closeFolder(index);
+    }
+
+    if (m_folders[index].keep) {
+        folderRemoved(index);
+    }
+    else {
+        m_emptiedFolders.append(index);
+    }
+}
+
+void LocalDeleteJob::folderRemoved(int index)
+{
+    const int parent = m_folders[index].parent;
+    if (parent < 0) {
+        m_finished = true;
+    }
+    else if (--m_folders[parent].pendingCount == 0) {
+        folderEmptied(parent);
+    }
+}
+
+void LocalDeleteJob::removeEmptiedFolders(bool force)
+{
+    const uint count = m_emptiedFolders.count();
+    if ((count == 0) || (!force && (count < REMOVE_BATCH_SIZE))) {
+        return;
+    }
+
+    // A parent folder only gets emptied after its subfolders have been
+    // removed, hence the folders of one batch never contain each other.
+    RemoveFoldersJob* job = new RemoveFoldersJob();
+    for (uint i = 0; i < count; ++i) {
+        const Folder& folder = m_folders[m_emptiedFolders[i]];
+        job->addFolder(m_emptiedFolders[i],
+                       m_folders[folder.parent].handle->ref(),
+                       folder.name,
+                       folder.path);
+    }
+
+    enqueue(job);
+    m_emptiedFolders.clear();
+}
+
+void LocalDeleteJob::cancelJobs()
+{
+    WorkerPool& pool = WorkerPool::instance();
+    QPtrDictIterator<DeleteWorkerJob> it(m_jobs);
+    while (it.current() != 0) {
+        pool.cancel(it.current());
+        ++it;
+    }
+    m_jobs.clear();
+}
+
+void LocalDeleteJob::finish()
+{
+    m_progressTimer->stop();
+    closeFolders();
+    updateProgress();
+
+    // inform other applications (e. g. Konqueror) about the deleted items
+    KDirNotify_stub allDirNotify("*", "KDirNotify*");
+    if (m_contentsOnly) {
+        KURL::List::ConstIterator it = m_urls.begin();
+        const KURL::List::ConstIterator end = m_urls.end();
+        while (it != end) {
+            allDirNotify.FilesAdded(*it);
+            ++it;
+        }
+    }
+    else {
+        allDirNotify.FilesRemoved(m_urls);
+    }
+
+    emitResult();
+}
+
+#include "localdeletejob.moc"
@@ -0,0 +1,172 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef LOCALDELETEJOB_H
+#define LOCALDELETEJOB_H
+
+#include <qcstring.h>
+#include <qptrdict.h>
+#include <qvaluevector.h>
+
+#include <kio/job.h>
+#include <kurl.h>
+
+class QTimer;
+class WorkerJob;
+class DeleteWorkerJob;
+class FolderHandle;
+
+/**
+ * @brief Deletes local files and folders by the threads of the worker pool.
+ *
+ * KIO::del() lists the deleted tree by the file I/O slave and removes
+ * one item after the other. The LocalDeleteJob reads each folder by
+ * getdents64() and removes its items by unlinkat() relative to the
+ * descriptor of the folder. Subfolders are opened by openat() and removed
+ * by unlinkat() relative to the descriptor of their parent folder, so that
+ * replacing a parent folder by a symbolic link cannot redirect the deleting
+ * outside of the tree. Each folder is processed by a separate job
+ * of the WorkerPool, so that the folders of a tree are deleted in parallel:
+ * the subfolders found by a job are enqueued as new jobs, which are picked
+ * up by the next idle worker thread. A folder is removed as soon as all
+ * its subfolders have been removed.
+ *
+ * The LocalDeleteJob is a KIO::Job, hence it can be used at all places where
+ * a job returned by KIO::del() is expected. It may only be used if
+ * LocalDeleteJob::canDelete() returns true.
+ */
+class LocalDeleteJob : public KIO::Job
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Deletes the local files and folders \a urls. If \a contentsOnly is
+     * true, only the contents of the folders \a urls are deleted and the
+     * folders itself are kept (e. g. for emptying the trash).
+     */
+    LocalDeleteJob(const KURL::List& urls, bool contentsOnly = false);
+    virtual ~LocalDeleteJob();
+
+    /** Returns true, if the URLs \a urls can be deleted by a LocalDeleteJob. */
+    static bool canDelete(const KURL::List& urls);
+
+    /** @see KIO::Job::kill() */
+    virtual void kill(bool quietly = true);
+
+private slots:
+    void start();
+    void slotJobFinished(WorkerJob* job);
+    void updateProgress();
+
+private:
+    /** Describes a folder of the deleted tree. */
+    struct Folder
+    {
+        /**
+         * Name of the folder relative to its parent folder. For the deleted
+         * items itself the absolute path is used.
+         */
+        QCString name;
+
+        /** Path of the folder, which is used for error messages. */
+        QCString path;
+
+        /**
+         * Open descriptor of the folder, which is used by the jobs for the
+         * subfolders. Is 0 if the folder has not been read yet or if it has
+         * been emptied.
+         */
+        FolderHandle* handle;
+
+        /** Index of the parent folder inside m_folders, -1 for the root. */
+        int parent;
+
+        /**
+         * Number of subfolders, which have not been removed yet. The folder
+         * itself is counted as long as it has not been read completely.
+         */
+        uint pendingCount;
+
+        /** Is true, if the folder may not be removed. */
+        bool keep;
+    };
+
+    /** Adds the job \a job to the worker pool and remembers it as running job. */
+    void enqueue(DeleteWorkerJob* job);
+
+    /**
+     * Enqueues a job for reading the folder \a index. If too many folders are
+     * open already, the folder is deferred until other folders have been emptied.
+     */
+    void readFolder(int index);
+
+    /** Starts reading deferred folders as long as the number of open folders allows it. */
+    void readDeferredFolders();
+
+    /** Closes the descriptor of the folder \a index. */
+    void closeFolder(int index);
+
+    /** Closes the descriptors of all folders. */
+    void closeFolders();
+
+    /**
+     * Is invoked if the pending count of the folder \a index has reached 0. The
+     * folder is queued for removing or, if it should be kept, reported as finished
+     * to its parent folder.
+     */
+    void folderEmptied(int index);
+
+    /** Informs the parent folder of \a index that the folder \a index has been removed. */
+    void folderRemoved(int index);
+
+    /**
+     * Enqueues a job for removing the emptied folders. If \a force is false,
+     * the job is only enqueued if enough folders have been collected.
+     */
+    void removeEmptiedFolders(bool force);
+
+    /** Cancels all running jobs of the worker pool. */
+    void cancelJobs();
+
+    /** Informs the progress observer and emits the result of the job. */
+    void finish();
+
+    KURL::List m_urls;
+    bool m_contentsOnly;
+    bool m_finished;
+
+    QValueVector<Folder> m_folders;
+    QValueVector<int> m_emptiedFolders;
+    int m_readingJobs;
+
+    /** Folders, which wait for being read, the last one is read first. */
+    QValueVector<int> m_deferredFolders;
+    int m_openFolders;
+
+    /** Number of items, which have been deleted by already finished jobs. */
+    unsigned long m_deletedCount;
+    uint m_removedFolders;
+
+    QPtrDict<DeleteWorkerJob> m_jobs;
+    QTimer* m_progressTimer;
+};
+
+#endif
@@ -0,0 +1,451 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "localmovejob.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#endif
+
+#include <qcstring.h>
+#include <qfile.h>
+#include <qtimer.h>
+#include <qvaluevector.h>
+
+#include <kde_file.h>
+#include <kdirnotify_stub.h>
+#include <klocale.h>
+
+#include "workerpool.h"
+
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+
+// Is set to false, if the kernel or the file system does not support renameat2().
+static volatile bool useRenameat2 = true;
+
+/**
+ * Renames \a from to \a to. In opposite to rename() an existing
+ * item \a to is not replaced and errno is set to EEXIST instead.
+ */
+static int renameNoReplace(const char* from, const char* to)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_renameat2)
+    if (useRenameat2) {
+        const int result = ::syscall(SYS_renameat2, AT_FDCWD, from, AT_FDCWD, to, RENAME_NOREPLACE);
+        if ((result == 0) || ((errno != ENOSYS) && (errno != EINVAL))) {
+            return result;
+        }
+        useRenameat2 = false;
+    }
+#endif
+
+    // The check is not atomic, but assures that no existing item
+    // is replaced by the items of Dolphin.
+    KDE_struct_stat buf;
+    if (KDE_lstat(to, &buf) == 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    return ::rename(from, to);
+}
+
+/** Maps the error number \a errnum to an error code of KIO. */
+static int kioError(int errnum)
+{
+    switch (errnum) {
+        case EACCES:
+        case EPERM:  return KIO::ERR_ACCESS_DENIED;
+        case EROFS:  return KIO::ERR_WRITE_ACCESS_DENIED;
+        case ENOENT: return KIO::ERR_DOES_NOT_EXIST;
+        default:     return KIO::ERR_CANNOT_RENAME;
+    }
+}
+
+/**
+ * @brief Renames the items of a LocalMoveJob.
+ *
+ * All data is deep copied when the job is created, so that the worker
+ * thread does not share any implicitly shared Qt data with the GUI thread.
+ */
+class RenameJob : public WorkerJob
+{
+public:
+    RenameJob(const QValueVector<QCString>& sourcePaths,
+              const QCString& destDir,
+              const ConflictResolutions& resolutions);
+    virtual ~RenameJob();
+
+    /** Returns the error number of the first error, or 0 if no error occured. */
+    int error() const { return m_error; }
+
+    /** Returns the path of the item, which caused the error. */
+    const QCString& errorPath() const { return m_errorPath; }
+
+    /**
+     * Returns the indices of the items, which have not been renamed because
+     * the destination already exists or is located on another file system.
+     */
+    const QValueVector<uint>& skippedItems() const { return m_skippedItems; }
+
+    /** Returns the indices of the items, which are kept in the source folder. */
+    const QValueVector<uint>& keptItems() const { return m_keptItems; }
+
+protected:
+    virtual void run();
+
+private:
+    enum Result
+    {
+        Moved,
+        Kept,       // the item is kept corresponding to its conflict resolution
+        Skipped,    // the item could not be renamed and has no conflict resolution
+        Failed
+    };
+
+    /**
+     * Moves the item \a sourcePath to \a destPath, where \a relativePath
+     * is the path relative to the destination folder. Existing folders are
+     * merged by moving the items of the source folder.
+     */
+    Result moveItem(const QCString& sourcePath,
+                    const QCString& destPath,
+                    const QCString& relativePath);
+
+    /** Moves the items of the folder \a sourcePath into the existing folder \a destPath. */
+    Result mergeFolder(const QCString& sourcePath,
+                       const QCString& destPath,
+                       const QCString& relativePath);
+
+    QValueVector<QCString> m_sourcePaths;
+    QCString m_destDir;
+    ConflictResolutions m_resolutions;
+    QValueVector<uint> m_skippedItems;
+    QValueVector<uint> m_keptItems;
+    int m_error;
+    QCString m_errorPath;
+};
+
+RenameJob::RenameJob(const QValueVector<QCString>& sourcePaths,
+                     const QCString& destDir,
+                     const ConflictResolutions& resolutions) :
+    m_destDir(destDir.copy()),
+    m_error(0)
+{
+    m_sourcePaths.reserve(sourcePaths.count());
+    QValueVector<QCString>::ConstIterator it = sourcePaths.begin();
+    const QValueVector<QCString>::ConstIterator end = sourcePaths.end();
+    while (it != end) {
+        m_sourcePaths.append((*it).copy());
+        ++it;
+    }
+
+    ConflictResolutions::ConstIterator resolutionIt = resolutions.begin();
+    const ConflictResolutions::ConstIterator resolutionsEnd = resolutions.end();
+    while (resolutionIt != resolutionsEnd) {
+        ConflictResolution resolution(resolutionIt.data());
+        resolution.newName = resolution.newName.copy();
+        m_resolutions.insert(resolutionIt.key().copy(), resolution);
+        ++resolutionIt;
+    }
+}
+
+RenameJob::~RenameJob()
+{
+}
+
+void RenameJob::run()
+{
+    const uint count = m_sourcePaths.count();
+    for (uint i = 0; (i < count) && !isCancelled(); ++i) {
+        const QCString& sourcePath = m_sourcePaths[i];
+        const QCString name(sourcePath.mid(sourcePath.findRev('/') + 1));
+        QCString destPath(m_destDir);
+        destPath += '/';
+        destPath += name;
+
+        const Result result = moveItem(sourcePath, destPath, name);
+        if (result == Failed) {
+            return;
+        }
+        if (result == Skipped) {
+            // the conflicts are resolved by KIO::move() afterwards
+            m_skippedItems.append(i);
+        }
+        else if (result == Kept) {
+            m_keptItems.append(i);
+        }
+    }
+}
+
+RenameJob::Result RenameJob::moveItem(const QCString& sourcePath,
+                                      const QCString& destPath,
+                                      const QCString& relativePath)
+{
+    int result = 0;
+    const ConflictResolutions::ConstIterator it = m_resolutions.find(relativePath);
+    if (it == m_resolutions.end()) {
+        result = renameNoReplace(sourcePath, destPath);
+    }
+    else {
+        const ConflictResolution& resolution = it.data();
+        switch (resolution.action) {
+            case ConflictResolution::Skip:
+                return Kept;
+
+            case ConflictResolution::Overwrite:
+                // rename() replaces the existing file atomically
+                result = ::rename(sourcePath, destPath);
+                break;
+
+            case ConflictResolution::Rename: {
+                const QCString renamedPath(destPath.left(destPath.findRev('/') + 1) + resolution.newName);
+                result = renameNoReplace(sourcePath, renamedPath);
+                break;
+            }
+        }
+    }
+
+    if (result == 0) {
+        return Moved;
+    }
+
+    const bool isResolved = (it != m_resolutions.end());
+    if (!isResolved && ((errno == EEXIST) || (errno == ENOTEMPTY))) {
+        KDE_struct_stat sourceBuf;
+        KDE_struct_stat destBuf;
+        if ((KDE_lstat(sourcePath, &sourceBuf) == 0) && S_ISDIR(sourceBuf.st_mode) &&
+            (KDE_lstat(destPath, &destBuf) == 0) && S_ISDIR(destBuf.st_mode)) {
+            return mergeFolder(sourcePath, destPath, relativePath);
+        }
+        return Skipped;
+    }
+
+    if (errno == EXDEV) {
+        return Skipped;
+    }
+
+    m_error = errno;
+    m_errorPath = sourcePath;
+    return Failed;
+}
+
+RenameJob::Result RenameJob::mergeFolder(const QCString& sourcePath,
+                                         const QCString& destPath,
+                                         const QCString& relativePath)
+{
+    DIR* dir = ::opendir(sourcePath);
+    if (dir == 0) {
+        m_error = errno;
+        m_errorPath = sourcePath;
+        return Failed;
+    }
+
+    bool isComplete = true;
+    KDE_struct_dirent* dirEntry = 0;
+    while (!isCancelled() && ((dirEntry = KDE_readdir(dir)) != 0)) {
+        const char* name = dirEntry->d_name;
+        if ((qstrcmp(name, ".") == 0) || (qstrcmp(name, "..") == 0)) {
+            continue;
+        }
+
+        QCString childSourcePath(sourcePath);
+        childSourcePath += '/';
+        childSourcePath += name;
+        QCString childDestPath(destPath);
+        childDestPath += '/';
+        childDestPath += name;
+        QCString childRelativePath(relativePath);
+        childRelativePath += '/';
+        childRelativePath += name;
+
+        const Result result = moveItem(childSourcePath, childDestPath, childRelativePath);
+        if (result == Failed) {
+            ::closedir(dir);
+            return Failed;
+        }
+        if (result != Moved) {
+            // Unresolved conflicts inside a merged folder are kept in the source
+            // folder too, as KIO::move() would move them into the wrong folder.
+            isComplete = false;
+        }
+    }
+    ::closedir(dir);
+
+    if (isComplete && (::rmdir(sourcePath) != 0) && (errno != ENOTEMPTY) && (errno != EEXIST)) {
+        m_error = errno;
+        m_errorPath = sourcePath;
+        return Failed;
+    }
+
+    return isComplete ? Moved : Kept;
+}
+
+LocalMoveJob::LocalMoveJob(const KURL::List& source,
+                           const KURL& dest,
+                           const ConflictResolutions& resolutions) :
+    KIO::Job(true),
+    m_source(source),
+    m_dest(dest),
+    m_resolutions(resolutions),
+    m_renameJob(0)
+{
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotJobFinished(WorkerJob*)));
+
+    // like the jobs of KIO the moving is started when returning to the event loop
+    QTimer::singleShot(0, this, SLOT(start()));
+}
+
+LocalMoveJob::~LocalMoveJob()
+{
+    WorkerPool::instance().cancel(m_renameJob);
+    m_renameJob = 0;
+}
+
+bool LocalMoveJob::canMove(const KURL::List& source, const KURL& dest)
+{
+    if (source.isEmpty() || !dest.isLocalFile()) {
+        return false;
+    }
+
+    const QString destPath(dest.path(-1));
+    KDE_struct_stat buf;
+    if ((KDE_stat(QFile::encodeName(destPath), &buf) != 0) || !S_ISDIR(buf.st_mode)) {
+        return false;
+    }
+    const dev_t destDevice = buf.st_dev;
+
+    KURL::List::ConstIterator it = source.begin();
+    const KURL::List::ConstIterator end = source.end();
+    while (it != end) {
+        const KURL& url = *it;
+        if (!url.isLocalFile() || url.fileName().isEmpty()) {
+            return false;
+        }
+
+        const QString sourcePath(url.path(-1));
+        if ((KDE_lstat(QFile::encodeName(sourcePath), &buf) != 0) || (buf.st_dev != destDevice)) {
+            return false;
+        }
+
+        // KIO::move() reports an error if a folder should be moved into itself
+        if ((destPath + '/').startsWith(sourcePath + '/')) {
+            return false;
+        }
+
+        ++it;
+    }
+
+    return true;
+}
+
+void LocalMoveJob::kill(bool quietly)
+{
+    WorkerPool::instance().cancel(m_renameJob);
+    m_renameJob = 0;
+    KIO::Job::kill(quietly);
+}
+
+void LocalMoveJob::start()
+{
+    emit infoMessage(this, i18n("Moving..."));
+
+    QValueVector<QCString> sourcePaths;
+    sourcePaths.reserve(m_source.count());
+    KURL::List::ConstIterator it = m_source.begin();
+    const KURL::List::ConstIterator end = m_source.end();
+    while (it != end) {
+        sourcePaths.append(QFile::encodeName((*it).path(-1)));
+        ++it;
+    }
+
+    m_renameJob = new RenameJob(sourcePaths, QFile::encodeName(m_dest.path(-1)), m_resolutions);
+    WorkerPool::instance().enqueue(m_renameJob, WorkerJob::Transfer);
+}
+
+void LocalMoveJob::slotJobFinished(WorkerJob* job)
+{
+    if ((job == 0) || (job != m_renameJob)) {
+        // the job does not belong to this move job
+        return;
+    }
+    m_renameJob = 0;
+    const RenameJob* renameJob = static_cast<RenameJob*>(job);
+
+    // inform other applications (e. g. Konqueror) about the moved items
+    const QValueVector<uint>& skippedItems = renameJob->skippedItems();
+    const QValueVector<uint>& keptItems = renameJob->keptItems();
+    KURL::List renamedURLs;
+    KURL::List skippedURLs;
+    KURL::List keptURLs;
+    uint skippedIndex = 0;
+    uint keptIndex = 0;
+    uint index = 0;
+    KURL::List::ConstIterator it = m_source.begin();
+    const KURL::List::ConstIterator end = m_source.end();
+    while (it != end) {
+        if ((skippedIndex < skippedItems.count()) && (skippedItems[skippedIndex] == index)) {
+            skippedURLs.append(*it);
+            ++skippedIndex;
+        }
+        else if ((keptIndex < keptItems.count()) && (keptItems[keptIndex] == index)) {
+            keptURLs.append(*it);
+            ++keptIndex;
+        }
+        else {
+            renamedURLs.append(*it);
+        }
+        ++index;
+        ++it;
+    }
+
+    KDirNotify_stub allDirNotify("*", "KDirNotify*");
+    if (!renamedURLs.isEmpty()) {
+        allDirNotify.FilesRemoved(renamedURLs);
+    }
+    // the items of kept folders might have been merged partly into the destination
+    for (it = keptURLs.begin(); it != keptURLs.end(); ++it) {
+        allDirNotify.FilesAdded(*it);
+    }
+    allDirNotify.FilesAdded(m_dest);
+
+    if (renameJob->error() != 0) {
+        m_error = kioError(renameJob->error());
+        m_errorText = QFile::decodeName(renameJob->errorPath());
+        emitResult();
+    }
+    else if (skippedURLs.isEmpty()) {
+        emitResult();
+    }
+    else {
+        // The result is emitted as soon as the sub job has been finished,
+        // see KIO::Job::slotResult().
+        addSubjob(KIO::move(skippedURLs, m_dest));
+    }
+}
+
+#include "localmovejob.moc"
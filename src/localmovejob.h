@@ -0,0 +1,87 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef LOCALMOVEJOB_H
+#define LOCALMOVEJOB_H
+
+#include <kio/job.h>
+#include <kurl.h>
+
+#include "conflictscanjob.h"
+
+class WorkerJob;
+class RenameJob;
+
+/**
+ * @brief Moves local items inside one file system by renaming them.
+ *
+ * KIO::move() moves the items one after the other by the file I/O slave,
+ * which results in several round trips for each item. If the items and the
+ * destination folder are located on the same file system, the LocalMoveJob
+ * renames all items by one job of the WorkerPool. renameat2() with the flag
+ * RENAME_NOREPLACE is used, so that an existing item is never overwritten.
+ * Existing items are handled corresponding to the conflict resolutions
+ * found by a ConflictScanJob, existing folders are merged. Items, for
+ * which no resolution is available, are collected and moved afterwards
+ * by KIO::move() as sub job, which asks the user how to resolve the
+ * conflicts.
+ *
+ * The LocalMoveJob is a KIO::Job, hence the whole move operation is
+ * registered as one undo command by Dolphin::addPendingUndoJob(). It
+ * may only be used if LocalMoveJob::canMove() returns true.
+ */
+class LocalMoveJob : public KIO::Job
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Moves the local items \a source into the local folder \a dest. Items,
+     * which already exist inside \a dest, are handled corresponding
+     * to \a resolutions.
+     */
+    LocalMoveJob(const KURL::List& source,
+                 const KURL& dest,
+                 const ConflictResolutions& resolutions = ConflictResolutions());
+    virtual ~LocalMoveJob();
+
+    /**
+     * Returns true, if the URLs \a source can be moved by a LocalMoveJob
+     * into \a dest. This is the case if all URLs are local, \a dest is an
+     * existing folder located on the same file system as the source items
+     * and \a dest is not located inside a source folder.
+     */
+    static bool canMove(const KURL::List& source, const KURL& dest);
+
+    /** @see KIO::Job::kill() */
+    virtual void kill(bool quietly = true);
+
+private slots:
+    void start();
+    void slotJobFinished(WorkerJob* job);
+
+private:
+    KURL::List m_source;
+    KURL m_dest;
+    ConflictResolutions m_resolutions;
+    RenameJob* m_renameJob;
+};
+
+#endif
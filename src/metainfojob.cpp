@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "metainfojob.h"
+
+#include <sys/stat.h>
+
+#include <qdeepcopy.h>
+#include <qfile.h>
+#include <qmutex.h>
+
+#include <kde_file.h>
+#include <kfilemetainfo.h>
+
+static QMutex metaInfoMutex;
+
+MetaInfoJob::MetaInfoJob(const QString& path, const QString& mimeType, time_t knownMTime) :
+    m_valid(false),
+    m_unchanged(false),
+    m_path(QDeepCopy<QString>(path)),
+    m_mimeType(QDeepCopy<QString>(mimeType)),
+    m_knownMTime(knownMTime)
+{
+    // QString uses a non-atomic reference counting, hence the worker
+    // thread must operate on deep copies
+}
+
+MetaInfoJob::~MetaInfoJob()
+{
+}
+
+bool MetaInfoJob::prepare(const QString& mimeType)
+{
+    QMutexLocker locker(&metaInfoMutex);
+    return KFileMetaInfoProvider::self()->plugin(mimeType) != 0;
+}
+
+QMutex* MetaInfoJob::pluginMutex()
+{
+    return &metaInfoMutex;
+}
+
+bool MetaInfoJob::showMetaInfo(const QString& key)
+{
+    // sorted list of keys, where it's data should be shown
+    static const char* keys[] = {
+        "Album",
+        "Artist",
+        "Author",
+        "Bitrate",
+        "Date",
+        "Dimensions",
+        "Genre",
+        "Length",
+        "Lines",
+        "Pages",
+        "Title",
+        "Words"
+    };
+
+    // do a binary search for the key...
+    int top = 0;
+    int bottom = sizeof(keys) / sizeof(char*) - 1;
+    while (top <= bottom) {
+        const int middle = (top + bottom) / 2;
+        const int result = key.compare(keys[middle]);
+        if (result < 0) {
+            bottom = middle - 1;
+        }
+        else if (result > 0) {
+            top = middle + 1;
+        }
+        else {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MetaInfoJob::run()
+{
+    KDE_struct_stat buf;
+    if (KDE_stat(QFile::encodeName(m_path), &buf) != 0) {
+        return;
+    }
+
+    m_valid = true;
+    m_info.isDir = S_ISDIR(buf.st_mode);
+    m_info.size = buf.st_size;
+    m_info.mtime = buf.st_mtime;
+
+    if (m_info.mtime == m_knownMTime) {
+        m_unchanged = true;
+        return;
+    }
+
+    if (m_info.isDir || isCancelled()) {
+        return;
+    }
+
+    // The MIME type is passed explicitly, so that no lookup inside
+    // the service database is required from the worker thread. The strings
+    // returned by the plugin are deep copied before the lock is released,
+    // as they might share their data with the plugin.
+    QMutexLocker locker(&metaInfoMutex);
+    const KFileMetaInfo metaInfo(m_path, m_mimeType, KFileMetaInfo::Fastest);
+    if (metaInfo.isValid()) {
+        const QStringList keys(metaInfo.supportedKeys());
+        for (QStringList::ConstIterator it = keys.begin(); it != keys.end(); ++it) {
+            if (showMetaInfo(*it)) {
+                m_info.keys.append(QDeepCopy<QString>(*it));
+                m_info.values.append(QDeepCopy<QString>(metaInfo.item(*it).string()));
+            }
+        }
+    }
+}
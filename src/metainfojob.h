@@ -0,0 +1,108 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef METAINFOJOB_H
+#define METAINFOJOB_H
+
+#include <qstringlist.h>
+#include <kio/global.h>
+
+class QMutex;
+
+#include "workerpool.h"
+
+/**
+ * @brief Reads the size, the modification time and the meta information
+ *        of a local file inside a worker thread.
+ *
+ * The KFilePlugin for the MIME type must have been loaded inside the GUI
+ * thread before the job is enqueued (see MetaInfoJob::prepare()), as loading
+ * plugins is not thread-safe. As the KFile plugins and KFileMetaInfoProvider
+ * are not thread-safe either, the meta information is read while holding
+ * MetaInfoJob::pluginMutex(). If the modification time of the file is equal
+ * to the given known modification time, the meta information is not read
+ * again and MetaInfoJob::isUnchanged() returns true.
+ */
+class MetaInfoJob : public WorkerJob
+{
+public:
+    /** Contains the information, which has been read from a file. */
+    struct Info
+    {
+        Info() : isDir(false), size(0), mtime(0) {}
+
+        bool isDir;
+        KIO::filesize_t size;
+        time_t mtime;
+
+        /** Keys and values of the meta information, which should be shown. */
+        QStringList keys;
+        QStringList values;
+    };
+
+    MetaInfoJob(const QString& path, const QString& mimeType, time_t knownMTime);
+    virtual ~MetaInfoJob();
+
+    /**
+     * Loads the KFilePlugin for the MIME type \a mimeType. Must be invoked
+     * inside the GUI thread before a job for this MIME type is enqueued.
+     * Returns false, if no plugin is available for the MIME type.
+     */
+    static bool prepare(const QString& mimeType);
+
+    /**
+     * Returns the mutex, which serializes all accesses to the KFile plugins.
+     * It must be locked by each thread, which uses KFileMetaInfo.
+     */
+    static QMutex* pluginMutex();
+
+    const QString& path() const { return m_path; }
+
+    /** Returns false, if the file could not be accessed. */
+    bool isValid() const { return m_valid; }
+
+    /**
+     * Returns true, if the modification time of the file is equal to the
+     * known modification time given in the constructor. In this case only
+     * MetaInfoJob::Info::mtime is valid.
+     */
+    bool isUnchanged() const { return m_unchanged; }
+
+    const Info& info() const { return m_info; }
+
+    /**
+     * Returns true, if the string \a key represents a meta information
+     * that should be shown.
+     */
+    static bool showMetaInfo(const QString& key);
+
+protected:
+    virtual void run();
+
+private:
+    bool m_valid;
+    bool m_unchanged;
+    QString m_path;
+    QString m_mimeType;
+    time_t m_knownMTime;
+    Info m_info;
+};
+
+#endif
@@ -0,0 +1,318 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "metainfoservice.h"
+
+#include <qapplication.h>
+#include <qdatastream.h>
+#include <qfile.h>
+
+#include <kstandarddirs.h>
+
+// Increase the version if the format of the cached meta information changes.
+#define CACHE_MAGIC   0xD3A1E7A1
+#define CACHE_VERSION 1
+
+// Maximum number of files, for which the meta information is cached.
+#define MAX_INFOS 100000
+
+MetaInfoService& MetaInfoService::instance()
+{
+    static MetaInfoService* instance = 0;
+    if (instance == 0) {
+        instance = new MetaInfoService();
+    }
+    return *instance;
+}
+
+const MetaInfoJob::Info* MetaInfoService::metaInfo(const QString& path)
+{
+    loadCache();
+
+    QMap<QString, CacheEntry>::Iterator it = m_infos.find(path);
+    if (it == m_infos.end()) {
+        return 0;
+    }
+
+    markAsUsed(*it, path);
+    return &(*it).info;
+}
+
+void MetaInfoService::insert(const QString& path, const MetaInfoJob::Info& info)
+{
+    loadCache();
+
+    QMap<QString, CacheEntry>::Iterator it = m_infos.find(path);
+    if (it != m_infos.end()) {
+        (*it).info = info;
+        markAsUsed(*it, path);
+    }
+    else {
+        // drop the least recently used meta information
+        while (m_infos.count() >= MAX_INFOS) {
+            m_infos.remove(m_recentPaths.first());
+            m_recentPaths.pop_front();
+        }
+
+        CacheEntry entry;
+        entry.info = info;
+        entry.recentIt = m_recentPaths.append(path);
+        m_infos.insert(path, entry);
+    }
+    m_modified = true;
+}
+
+void MetaInfoService::requestMetaInfo(const QString& path,
+                                      const QString& mimeType,
+                                      time_t mtime,
+                                      WorkerJob::Priority priority,
+                                      const void* owner)
+{
+    const MetaInfoJob::Info* info = metaInfo(path);
+    if ((info != 0) && (info->mtime == mtime)) {
+        return;
+    }
+
+    QMap<QString, Request>::Iterator it = m_requests.find(path);
+    if (it != m_requests.end()) {
+        Request& request = *it;
+        if (!request.owners.contains(owner)) {
+            request.owners.append(owner);
+        }
+        if ((priority < request.priority) && (request.job == 0)) {
+            // move the queued request to the queue of the higher priority
+            request.priority = priority;
+            m_queues[priority].append(path);
+        }
+        return;
+    }
+
+    if (!isSupported(mimeType)) {
+        // no meta information is available for the MIME type
+        return;
+    }
+
+    Request request;
+    request.job = 0;
+    request.mimeType = mimeType;
+    request.priority = priority;
+    request.owners.append(owner);
+    m_requests.insert(path, request);
+    m_queues[priority].append(path);
+    startNextJob();
+}
+
+void MetaInfoService::cancelRequests(const void* owner)
+{
+    QStringList cancelledPaths;
+
+    QMap<QString, Request>::Iterator it = m_requests.begin();
+    const QMap<QString, Request>::Iterator end = m_requests.end();
+    while (it != end) {
+        Request& request = *it;
+        request.owners.remove(owner);
+        if (request.owners.isEmpty()) {
+            if (request.job != 0) {
+                WorkerPool::instance().cancel(request.job);
+                m_runningPath = QString::null;
+            }
+            cancelledPaths.append(it.key());
+        }
+        ++it;
+    }
+
+    // the paths inside the queues are skipped as soon as they are reached
+    QStringList::ConstIterator pathIt = cancelledPaths.begin();
+    const QStringList::ConstIterator pathEnd = cancelledPaths.end();
+    while (pathIt != pathEnd) {
+        m_requests.remove(*pathIt);
+        ++pathIt;
+    }
+
+    startNextJob();
+}
+
+MetaInfoService::MetaInfoService() :
+    QObject(0),
+    m_loaded(false),
+    m_modified(false)
+{
+    connect(qApp, SIGNAL(aboutToQuit()),
+            this, SLOT(saveCache()));
+
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotJobFinished(WorkerJob*)));
+}
+
+MetaInfoService::~MetaInfoService()
+{
+    QMap<QString, Request>::Iterator it = m_requests.find(m_runningPath);
+    if (it != m_requests.end()) {
+        WorkerPool::instance().cancel((*it).job);
+    }
+    m_requests.clear();
+
+    saveCache();
+}
+
+void MetaInfoService::slotJobFinished(WorkerJob* job)
+{
+    QMap<QString, Request>::Iterator it = m_requests.find(m_runningPath);
+    if ((it == m_requests.end()) || (static_cast<WorkerJob*>((*it).job) != job)) {
+        // the job has not been requested by the service
+        return;
+    }
+
+    // the job is deleted by the worker pool
+    const MetaInfoJob* metaInfoJob = (*it).job;
+    const QString path(it.key());
+    m_requests.remove(it);
+    m_runningPath = QString::null;
+    startNextJob();
+
+    if (!metaInfoJob->isValid() || metaInfoJob->info().isDir) {
+        return;
+    }
+
+    insert(path, metaInfoJob->info());
+    emit metaInfoAvailable(path);
+}
+
+void MetaInfoService::markAsUsed(CacheEntry& entry, const QString& path)
+{
+    m_recentPaths.remove(entry.recentIt);
+    entry.recentIt = m_recentPaths.append(path);
+}
+
+void MetaInfoService::startNextJob()
+{
+    if (!m_runningPath.isEmpty()) {
+        return;
+    }
+
+    for (int priority = WorkerJob::Listing; priority <= WorkerJob::Transfer; ++priority) {
+        QValueList<QString>& queue = m_queues[priority];
+        while (!queue.isEmpty()) {
+            const QString path(queue.first());
+            queue.pop_front();
+
+            // skip cancelled requests and requests, which have got a higher priority
+            QMap<QString, Request>::Iterator it = m_requests.find(path);
+            if ((it == m_requests.end()) || ((*it).job != 0) || ((*it).priority != priority)) {
+                continue;
+            }
+
+            Request& request = *it;
+            request.job = new MetaInfoJob(path, request.mimeType, -1);
+            m_runningPath = path;
+            WorkerPool::instance().enqueue(request.job, request.priority);
+            return;
+        }
+    }
+}
+
+void MetaInfoService::saveCache()
+{
+    if (!m_loaded || !m_modified) {
+        return;
+    }
+    m_modified = false;
+
+    QString fileName(KGlobal::dirs()->saveLocation("cache", "d3lphin/"));
+    fileName.append("metainfo");
+    QFile file(fileName);
+    if (!file.open(IO_WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << static_cast<Q_UINT32>(CACHE_MAGIC)
+           << static_cast<Q_UINT32>(CACHE_VERSION)
+           << static_cast<Q_UINT32>(m_infos.count());
+
+    // the paths are written in the order of their usage, so that
+    // the order is restored when the cache is read again
+    QValueList<QString>::ConstIterator it = m_recentPaths.begin();
+    const QValueList<QString>::ConstIterator end = m_recentPaths.end();
+    while (it != end) {
+        const MetaInfoJob::Info& info = m_infos[*it].info;
+        stream << *it
+               << static_cast<Q_UINT64>(info.size)
+               << static_cast<Q_INT64>(info.mtime)
+               << info.keys
+               << info.values;
+        ++it;
+    }
+    file.close();
+}
+
+void MetaInfoService::loadCache()
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    QString fileName(KGlobal::dirs()->saveLocation("cache", "d3lphin/"));
+    fileName.append("metainfo");
+    QFile file(fileName);
+    if (!file.open(IO_ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    Q_UINT32 magic = 0;
+    Q_UINT32 version = 0;
+    Q_UINT32 count = 0;
+    stream >> magic >> version >> count;
+    if ((magic != CACHE_MAGIC) || (version != CACHE_VERSION)) {
+        return;
+    }
+
+    for (Q_UINT32 i = 0; (i < count) && !stream.atEnd(); ++i) {
+        QString path;
+        MetaInfoJob::Info info;
+        Q_UINT64 size = 0;
+        Q_INT64 mtime = 0;
+        stream >> path >> size >> mtime >> info.keys >> info.values;
+        info.size = size;
+        info.mtime = mtime;
+        if (!m_infos.contains(path)) {
+            CacheEntry entry;
+            entry.info = info;
+            entry.recentIt = m_recentPaths.append(path);
+            m_infos.insert(path, entry);
+        }
+    }
+}
+
+bool MetaInfoService::isSupported(const QString& mimeType)
+{
+    QMap<QString, bool>::ConstIterator it = m_supportedMimeTypes.find(mimeType);
+    if (it != m_supportedMimeTypes.end()) {
+        return *it;
+    }
+
+    const bool supported = MetaInfoJob::prepare(mimeType);
+    m_supportedMimeTypes.insert(mimeType, supported);
+    return supported;
+}
+
+#include "metainfoservice.moc"
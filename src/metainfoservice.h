@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef METAINFOSERVICE_H
+#define METAINFOSERVICE_H
+
+#include <qmap.h>
+#include <qobject.h>
+#include <qvaluelist.h>
+
+#include "metainfojob.h"
+
+/**
+ * @brief Reads the meta information of local files in the background and keeps
+ *        a persistent cache of the results.
+ *
+ * The meta information (e. g. the dimensions of images, the length of
+ * audio files or the number of pages of documents) is read by MetaInfoJobs
+ * inside the WorkerPool. As the KFile plugins are not thread-safe, only
+ * one job is handed to the worker pool at a time, the remaining requests
+ * wait in one queue per priority class. The results are cached for each path together
+ * with the modification time of the file and stored inside the cache
+ * directory of Dolphin, so that the meta information of a large directory
+ * is available immediately when the directory is opened again. If the
+ * cache is full, the least recently used meta information is dropped.
+ *
+ * The cache is shared by all users of meta information: the details view
+ * fills its meta information columns by it and the information sidebar
+ * stores the meta information of the shown file inside it.
+ *
+ * Sample code:
+ * \code
+ * MetaInfoService& service = MetaInfoService::instance();
+ * const MetaInfoJob::Info* info = service.metaInfo(path);
+ * if ((info == 0) || (info->mtime != mtime)) {
+ *     service.requestMetaInfo(path, mimeType, mtime, WorkerJob::Preview, this);
+ *     // wait for MetaInfoService::metaInfoAvailable()
+ * }
+ * \endcode
+ */
+class MetaInfoService : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MetaInfoService& instance();
+
+    /**
+     * Returns the cached meta information of the local file \a path or 0,
+     * if no meta information is cached. The caller must check whether
+     * the modification time of the information matches the modification
+     * time of the file.
+     */
+    const MetaInfoJob::Info* metaInfo(const QString& path);
+
+    /** Stores the meta information \a info of the local file \a path inside the cache. */
+    void insert(const QString& path, const MetaInfoJob::Info& info);
+
+    /**
+     * Requests reading the meta information of the local file \a path having
+     * the MIME type \a mimeType and the modification time \a mtime. Nothing
+     * happens, if matching meta information is already cached or if no
+     * plugin is available for the MIME type. If the file is already requested
+     * with a lower priority, the request is restarted with the priority
+     * \a priority. All requests of \a owner can be cancelled by
+     * MetaInfoService::cancelRequests().
+     */
+    void requestMetaInfo(const QString& path,
+                         const QString& mimeType,
+                         time_t mtime,
+                         WorkerJob::Priority priority,
+                         const void* owner);
+
+    /**
+     * Cancels all requests of \a owner. A request is only cancelled if it
+     * has not been done by another owner too.
+     */
+    void cancelRequests(const void* owner);
+
+signals:
+    /**
+     * Is emitted if the meta information of the file \a path has been read.
+     * The information can be retrieved by MetaInfoService::metaInfo().
+     */
+    void metaInfoAvailable(const QString& path);
+
+protected:
+    MetaInfoService();
+    virtual ~MetaInfoService();
+
+private slots:
+    /** Takes over the meta information read by the job \a job. */
+    void slotJobFinished(WorkerJob* job);
+
+    /**
+     * Writes the cached meta information to the cache directory of Dolphin,
+     * if it has been modified. Serializing the whole cache is expensive, hence
+     * it is only done when the application quits.
+     */
+    void saveCache();
+
+private:
+    struct Request
+    {
+        /** Job, which reads the meta information. Is 0 as long as the request is queued. */
+        MetaInfoJob* job;
+        QString mimeType;
+        WorkerJob::Priority priority;
+        QValueList<const void*> owners;
+    };
+
+    struct CacheEntry
+    {
+        MetaInfoJob::Info info;
+        /** Position of the path inside MetaInfoService::m_recentPaths. */
+        QValueList<QString>::Iterator recentIt;
+    };
+
+    /** Marks the cached entry \a entry for the path \a path as most recently used. */
+    void markAsUsed(CacheEntry& entry, const QString& path);
+
+    /** Starts the job for the next queued request, if no other job is running. */
+    void startNextJob();
+
+    /** Reads the cached meta information on the first access. */
+    void loadCache();
+
+    /**
+     * Returns true, if a plugin for the MIME type \a mimeType is available.
+     * The result is remembered, as looking up a missing plugin is expensive.
+     */
+    bool isSupported(const QString& mimeType);
+
+    bool m_loaded;
+    bool m_modified;
+    QMap<QString, CacheEntry> m_infos;
+
+    /** Paths of the cached meta information, the least recently used path first. */
+    QValueList<QString> m_recentPaths;
+    QMap<QString, Request> m_requests;
+
+    /**
+     * Paths of the queued requests for each priority class. A path might be
+     * contained in several queues, only the queue corresponding to the
+     * priority of the request is respected.
+     */
+    QValueList<QString> m_queues[WorkerJob::Transfer + 1];
+
+    /** Path of the request, whose job is running, or an empty string. */
+    QString m_runningPath;
+    QMap<QString, bool> m_supportedMimeTypes;
+};
+
+#endif
@@ -0,0 +1,138 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "mimetypehistogram.h"
+
+MimeTypeHistogram::MimeTypeHistogram() :
+    m_itemCount(0),
+    m_directoryCount(0),
+    m_nonLocalCount(0),
+    m_totalFileSize(0)
+{
+    m_items.setAutoDelete(true);
+}
+
+MimeTypeHistogram::~MimeTypeHistogram()
+{
+}
+
+void MimeTypeHistogram::add(const KFileItem* item)
+{
+    if (m_items.find(const_cast<KFileItem*>(item)) == 0) {
+        insertItem(item);
+    }
+}
+
+void MimeTypeHistogram::remove(const KFileItem* item)
+{
+    void* key = const_cast<KFileItem*>(item);
+    const ItemInfo* info = m_items.find(key);
+    if (info != 0) {
+        removeItemInfo(info);
+        m_items.remove(key);
+    }
+}
+
+void MimeTypeHistogram::clear()
+{
+    m_itemCount = 0;
+    m_directoryCount = 0;
+    m_nonLocalCount = 0;
+    m_totalFileSize = 0;
+    m_mimeTypes.clear();
+    m_mimeGroups.clear();
+    m_items.clear();
+}
+
+QStringList MimeTypeHistogram::mimeTypes() const
+{
+    return m_mimeTypes.keys();
+}
+
+int MimeTypeHistogram::count(const QString& mimeType) const
+{
+    QMap<QString, int>::ConstIterator it = m_mimeTypes.find(mimeType);
+    return (it == m_mimeTypes.end()) ? 0 : it.data();
+}
+
+QString MimeTypeHistogram::commonMimeType() const
+{
+    return (m_mimeTypes.count() == 1) ? m_mimeTypes.begin().key() : QString::null;
+}
+
+QString MimeTypeHistogram::commonMimeGroup() const
+{
+    return (m_mimeGroups.count() == 1) ? m_mimeGroups.begin().key() : QString::null;
+}
+
+MimeTypeHistogram::ItemInfo* MimeTypeHistogram::insertItem(const KFileItem* item)
+{
+    ItemInfo* info = new ItemInfo();
+    info->mimeType = item->mimetype();
+    info->isDir = item->isDir();
+    info->isLocal = item->url().isLocalFile();
+    info->size = info->isDir ? 0 : item->size();
+    m_items.insert(const_cast<KFileItem*>(item), info);
+
+    // grow the dictionary, so that the lookups stay fast for large selections
+    if (m_items.count() > 2 * m_items.size()) {
+        m_items.resize(4 * m_items.count() + 1);
+    }
+
+    ++m_itemCount;
+    if (info->isDir) {
+        ++m_directoryCount;
+    }
+    if (!info->isLocal) {
+        ++m_nonLocalCount;
+    }
+    m_totalFileSize += info->size;
+    ++m_mimeTypes[info->mimeType];
+    ++m_mimeGroups[mimeGroup(info->mimeType)];
+
+    return info;
+}
+
+void MimeTypeHistogram::removeItemInfo(const ItemInfo* info)
+{
+    --m_itemCount;
+    if (info->isDir) {
+        --m_directoryCount;
+    }
+    if (!info->isLocal) {
+        --m_nonLocalCount;
+    }
+    m_totalFileSize -= info->size;
+
+    QMap<QString, int>::Iterator typeIt = m_mimeTypes.find(info->mimeType);
+    if (--typeIt.data() == 0) {
+        m_mimeTypes.remove(typeIt);
+    }
+
+    QMap<QString, int>::Iterator groupIt = m_mimeGroups.find(mimeGroup(info->mimeType));
+    if (--groupIt.data() == 0) {
+        m_mimeGroups.remove(groupIt);
+    }
+}
+
+QString MimeTypeHistogram::mimeGroup(const QString& mimeType)
+{
+    return mimeType.left(mimeType.find('/'));
+}
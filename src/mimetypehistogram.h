@@ -0,0 +1,124 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef MIMETYPEHISTOGRAM_H
+#define MIMETYPEHISTOGRAM_H
+
+#include <qmap.h>
+#include <qptrdict.h>
+#include <qstringlist.h>
+
+#include <kfileitem.h>
+#include <kio/global.h>
+
+/**
+ * @brief Counts the MIME types and MIME groups of a set of items.
+ *
+ * Beside the MIME types the histogram keeps the running totals of the
+ * files, the directories and the file sizes. It is used by DolphinView to
+ * describe the current selection.
+ *
+ * The histogram is updated incrementally by MimeTypeHistogram::add() and
+ * MimeTypeHistogram::remove() for each item, where the selection state has
+ * been changed. This allows to match service types against large
+ * selections by iterating the distinct MIME types instead of all items, and
+ * to show the selection totals without iterating the selection again.
+ *
+ * The items are only used as keys: removed items are never dereferenced.
+ * The owner must remove an item before it gets deleted or clear the
+ * histogram.
+ */
+class MimeTypeHistogram
+{
+public:
+    MimeTypeHistogram();
+    ~MimeTypeHistogram();
+
+    /** Adds the item \a item to the histogram, if it is not already part of it. */
+    void add(const KFileItem* item);
+
+    /** Removes the item \a item from the histogram. The item is not dereferenced. */
+    void remove(const KFileItem* item);
+
+    void clear();
+
+    /** Returns the number of items. */
+    int itemCount() const { return m_itemCount; }
+
+    /** Returns the number of directories. */
+    int directoryCount() const { return m_directoryCount; }
+
+    /** Returns the number of items, which are no directories. */
+    int fileCount() const { return m_itemCount - m_directoryCount; }
+
+    /** Returns true, if the items don't contain any directory. */
+    bool isFilesOnly() const { return m_directoryCount == 0; }
+
+    /** Returns the summarized size of all items, which are no directories. */
+    KIO::filesize_t totalFileSize() const { return m_totalFileSize; }
+
+    /** Returns the number of items, which are not local files. */
+    int nonLocalCount() const { return m_nonLocalCount; }
+
+    /** Returns the distinct MIME types of all items. */
+    QStringList mimeTypes() const;
+
+    /** Returns the number of items having the MIME type \a mimeType. */
+    int count(const QString& mimeType) const;
+
+    /**
+     * Returns the MIME type, if all items have the same MIME type. Otherwise
+     * QString::null is returned.
+     */
+    QString commonMimeType() const;
+
+    /**
+     * Returns the MIME group (e. g. "image" for "image/png"), if all items
+     * are part of the same MIME group. Otherwise QString::null is returned.
+     */
+    QString commonMimeGroup() const;
+
+private:
+    MimeTypeHistogram(const MimeTypeHistogram&);
+    MimeTypeHistogram& operator=(const MimeTypeHistogram&);
+
+    struct ItemInfo
+    {
+        QString mimeType;
+        bool isDir;
+        bool isLocal;
+        KIO::filesize_t size;
+    };
+
+    ItemInfo* insertItem(const KFileItem* item);
+    void removeItemInfo(const ItemInfo* info);
+
+    static QString mimeGroup(const QString& mimeType);
+
+    int m_itemCount;
+    int m_directoryCount;
+    int m_nonLocalCount;
+    KIO::filesize_t m_totalFileSize;
+    QMap<QString, int> m_mimeTypes;
+    QMap<QString, int> m_mimeGroups;
+    QPtrDict<ItemInfo> m_items;
+};
+
+#endif
@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "openwithcache.h"
+
+#include <qtimer.h>
+
+#include <kiconloader.h>
+#include <ksycoca.h>
+#include <ktrader.h>
+
+OpenWithCache& OpenWithCache::instance()
+{
+    static OpenWithCache* instance = 0;
+    if (instance == 0) {
+        instance = new OpenWithCache();
+    }
+    return *instance;
+}
+
+const QValueVector<OpenWithCache::Offer>& OpenWithCache::offers(const QString& mimeType)
+{
+    QMap<QString, QValueVector<Offer> >::Iterator it = m_offers.find(mimeType);
+    if (it != m_offers.end()) {
+        return it.data();
+    }
+
+    QValueVector<Offer>& offers = m_offers[mimeType];
+
+    KTrader::OfferList services = KTrader::self()->query(mimeType, "Type == 'Application'");
+
+    // The offer list from the KTrader returns duplicate
+    // application entries. Although this seems to be a configuration
+    // problem outside the scope of Dolphin, duplicated entries just
+    // will be skipped here.
+    QMap<QString, bool> names;
+    KTrader::OfferList::ConstIterator serviceIt = services.begin();
+    while (serviceIt != services.end()) {
+        const QString name((*serviceIt)->name());
+        if (!names.contains(name)) {
+            names.insert(name, true);
+
+            Offer offer;
+            offer.service = *serviceIt;
+            offer.icon = (*serviceIt)->pixmap(KIcon::Small);
+            offers.append(offer);
+        }
+        ++serviceIt;
+    }
+
+    return offers;
+}
+
+void OpenWithCache::warmUp(const KFileItemList& items)
+{
+    QMap<QString, bool> mimeTypes;
+    KFileItemListIterator it(items);
+    KFileItem* item = 0;
+    while ((item = it.current()) != 0) {
+        // Determining an unknown MIME type might read the file content,
+        // which is too expensive for all items of a folder.
+        if (!item->isDir() && item->isMimeTypeKnown()) {
+            mimeTypes.insert(item->mimetype(), true);
+        }
+        ++it;
+    }
+
+    QMap<QString, bool>::ConstIterator mimeIt = mimeTypes.begin();
+    while (mimeIt != mimeTypes.end()) {
+        const QString& mimeType = mimeIt.key();
+        if (!m_offers.contains(mimeType) && !m_pendingMimeTypes.contains(mimeType)) {
+            m_pendingMimeTypes.append(mimeType);
+        }
+        ++mimeIt;
+    }
+
+    if (!m_pendingMimeTypes.isEmpty() && !m_warmUpTimer->isActive()) {
+        m_warmUpTimer->start(0, false);
+    }
+}
+
+OpenWithCache::OpenWithCache() :
+    QObject(0),
+    m_warmUpTimer(0)
+{
+    m_warmUpTimer = new QTimer(this);
+    connect(m_warmUpTimer, SIGNAL(timeout()),
+            this, SLOT(warmUpNext()));
+
+    connect(KSycoca::self(), SIGNAL(databaseChanged()),
+            this, SLOT(clear()));
+}
+
+OpenWithCache::~OpenWithCache()
+{
+}
+
+void OpenWithCache::clear()
+{
+    m_offers.clear();
+}
+
+void OpenWithCache::warmUpNext()
+{
+    if (m_pendingMimeTypes.isEmpty()) {
+        m_warmUpTimer->stop();
+        return;
+    }
+
+    // only one MIME type is queried per timeout, so that
+    // user input can be processed in between
+    const QString mimeType(m_pendingMimeTypes.first());
+    m_pendingMimeTypes.pop_front();
+    offers(mimeType);
+}
+
+#include "openwithcache.moc"
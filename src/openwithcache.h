@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef OPENWITHCACHE_H
+#define OPENWITHCACHE_H
+
+#include <qobject.h>
+#include <qmap.h>
+#include <qpixmap.h>
+#include <qstringlist.h>
+#include <qvaluevector.h>
+
+#include <kfileitem.h>
+#include <kservice.h>
+
+class QTimer;
+
+/**
+ * @brief Caches the applications, which are offered to open items of a MIME type.
+ *
+ * Querying the KTrader for the 'Open With' offers of a MIME type is
+ * expensive for a large service database. The cache keeps the offers per
+ * MIME type, where duplicated applications have already been removed and
+ * the icons have already been loaded. The cache is cleared as soon as the
+ * service database has been changed.
+ *
+ * To prevent a lag when opening the first context menu inside a directory,
+ * the offers for the MIME types of the directory can be requested
+ * in advance by OpenWithCache::warmUp().
+ */
+class OpenWithCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** Describes one application, which can open items of a MIME type. */
+    struct Offer
+    {
+        KService::Ptr service;
+        QPixmap icon;
+    };
+
+    static OpenWithCache& instance();
+
+    /** Returns the applications, which are registered to open items of the MIME type \a mimeType. */
+    const QValueVector<Offer>& offers(const QString& mimeType);
+
+    /**
+     * Requests the offers for the MIME types of the items \a items. Items, where
+     * the MIME type has not been determined yet, are skipped. The offers
+     * are queried step by step when the application is idle, so that the user
+     * interface stays responsive.
+     */
+    void warmUp(const KFileItemList& items);
+
+protected:
+    OpenWithCache();
+    virtual ~OpenWithCache();
+
+private slots:
+    /** Clears the cache. Is invoked if the service database has been changed. */
+    void clear();
+
+    /** Queries the offers for the next MIME type, which has been requested by warmUp(). */
+    void warmUpNext();
+
+private:
+    QMap<QString, QValueVector<Offer> > m_offers;
+    QStringList m_pendingMimeTypes;
+    QTimer* m_warmUpTimer;
+};
+
+#endif
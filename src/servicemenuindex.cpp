@@ -0,0 +1,174 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "servicemenuindex.h"
+
+#include <qdir.h>
+#include <qfileinfo.h>
+
+#include <kglobal.h>
+#include <ksimpleconfig.h>
+#include <kstandarddirs.h>
+
+#include "mimetypehistogram.h"
+
+ServiceMenuIndex& ServiceMenuIndex::instance()
+{
+    static ServiceMenuIndex* instance = 0;
+    if (instance == 0) {
+        instance = new ServiceMenuIndex();
+    }
+    return *instance;
+}
+
+QValueList<ServiceMenuIndex::Menu> ServiceMenuIndex::menus(const MimeTypeHistogram& histogram)
+{
+    update();
+
+    QValueList<Menu> menus;
+    if (histogram.itemCount() == 0) {
+        return menus;
+    }
+
+    // A service menu is offered if one of its service types matches to all items.
+    const QString mimeType(histogram.commonMimeType());
+    const QString mimeGroup(histogram.commonMimeGroup());
+
+    // collect the indices of all matching entries
+    QValueList<uint> indices;
+    if (histogram.isFilesOnly()) {
+        indices = m_allFilesIndex;
+    }
+    if (!mimeType.isNull()) {
+        QMap<QString, QValueList<uint> >::ConstIterator typeIt = m_mimeTypeIndex.find(mimeType);
+        if (typeIt != m_mimeTypeIndex.end()) {
+            QValueList<uint>::ConstIterator indexIt = typeIt.data().begin();
+            while (indexIt != typeIt.data().end()) {
+                addIndex(indices, *indexIt);
+                ++indexIt;
+            }
+        }
+    }
+    if (!mimeGroup.isNull()) {
+        QMap<QString, QValueList<uint> >::ConstIterator groupIt = m_mimeGroupIndex.find(mimeGroup);
+        if (groupIt != m_mimeGroupIndex.end()) {
+            QValueList<uint>::ConstIterator indexIt = groupIt.data().begin();
+            while (indexIt != groupIt.data().end()) {
+                addIndex(indices, *indexIt);
+                ++indexIt;
+            }
+        }
+    }
+
+    QValueList<uint>::ConstIterator indexIt = indices.begin();
+    while (indexIt != indices.end()) {
+        const Entry& entry = m_entries[*indexIt];
+        Menu menu;
+        menu.submenuName = entry.submenuName;
+        menu.services = entry.isDynamic ?
+                        KDEDesktopMimeType::userDefinedServices(entry.path, true) :
+                        entry.services;
+        menus.append(menu);
+        ++indexIt;
+    }
+
+    return menus;
+}
+
+ServiceMenuIndex::ServiceMenuIndex()
+{
+}
+
+ServiceMenuIndex::~ServiceMenuIndex()
+{
+}
+
+void ServiceMenuIndex::update()
+{
+    const QStringList dirs(KGlobal::dirs()->findDirs("data", "d3lphin/servicemenus/"));
+
+    QValueList<QDateTime> dirModifications;
+    for (QStringList::ConstIterator dirIt = dirs.begin(); dirIt != dirs.end(); ++dirIt) {
+        dirModifications.append(QFileInfo(*dirIt).lastModified());
+    }
+
+    if ((dirs == m_dirs) && (dirModifications == m_dirModifications)) {
+        // the index is still up to date
+        return;
+    }
+
+    m_dirs = dirs;
+    m_dirModifications = dirModifications;
+    m_entries.clear();
+    m_mimeTypeIndex.clear();
+    m_mimeGroupIndex.clear();
+    m_allFilesIndex.clear();
+
+    for (QStringList::ConstIterator dirIt = dirs.begin(); dirIt != dirs.end(); ++dirIt) {
+        QDir dir(*dirIt);
+        QStringList entries = dir.entryList("*.desktop", QDir::Files);
+
+        for (QStringList::ConstIterator entryIt = entries.begin(); entryIt != entries.end(); ++entryIt) {
+            KSimpleConfig cfg(*dirIt + *entryIt, true);
+            cfg.setDesktopGroup();
+            const bool isDynamic = cfg.hasKey("X-KDE-GetActionMenu");
+            if (!(cfg.hasKey("Actions") || isDynamic) || !cfg.hasKey("ServiceTypes")) {
+                continue;
+            }
+
+            Entry entry;
+            entry.path = *dirIt + *entryIt;
+            entry.submenuName = cfg.readEntry("X-KDE-Submenu");
+            entry.isDynamic = isDynamic;
+            if (!isDynamic) {
+                entry.services = KDEDesktopMimeType::userDefinedServices(entry.path, true);
+            }
+
+            const uint index = m_entries.count();
+            m_entries.append(entry);
+
+            const QStringList types = cfg.readListEntry("ServiceTypes");
+            for (QStringList::ConstIterator it = types.begin(); it != types.end(); ++it) {
+                const QString& type = *it;
+                if (type == "all/allfiles") {
+                    addIndex(m_allFilesIndex, index);
+                }
+                else if (type.right(2) == "/*") {
+                    addIndex(m_mimeGroupIndex[type.left(type.length() - 2)], index);
+                }
+                else {
+                    addIndex(m_mimeTypeIndex[type], index);
+                }
+            }
+        }
+    }
+}
+
+void ServiceMenuIndex::addIndex(QValueList<uint>& list, uint index)
+{
+    // the list is sorted ascending, which keeps the order of the service menus
+    QValueList<uint>::Iterator it = list.begin();
+    while ((it != list.end()) && (*it < index)) {
+        ++it;
+    }
+    if ((it == list.end()) || (*it != index)) {
+        list.insert(it, index);
+    }
+}
@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef SERVICEMENUINDEX_H
+#define SERVICEMENUINDEX_H
+
+#include <qdatetime.h>
+#include <qmap.h>
+#include <qstringlist.h>
+#include <qvaluelist.h>
+#include <qvaluevector.h>
+
+#include <kmimetype.h>
+
+class MimeTypeHistogram;
+
+/**
+ * @brief Index of the service menus, which are offered for a set of items.
+ *
+ * The service menus are stored as .desktop files inside the directories
+ * "d3lphin/servicemenus/". Instead of parsing all files each time a context
+ * menu is opened or the information sidebar is updated, the files are parsed
+ * once and the service menus are indexed by their service types: by the exact
+ * MIME type (e. g. "image/png"), by the MIME group (e. g. "image/*") and by
+ * "all/allfiles". The index is rebuilt if the modification time of one of
+ * the service menu directories has been changed.
+ *
+ * Both DolphinContextMenu and InfoSidebarPage use the index.
+ */
+class ServiceMenuIndex
+{
+public:
+    /** Describes a service menu, which matches to a set of items. */
+    struct Menu
+    {
+        /** Name of the sub menu, where the services are grouped. Might be empty. */
+        QString submenuName;
+        QValueList<KDEDesktopMimeType::Service> services;
+    };
+
+    static ServiceMenuIndex& instance();
+
+    /**
+     * Returns the service menus which match to all items represented
+     * by the MIME type histogram \a histogram.
+     * The menus are returned in the order of the service menu directories
+     * and the files inside the directories.
+     */
+    QValueList<Menu> menus(const MimeTypeHistogram& histogram);
+
+private:
+    ServiceMenuIndex();
+    ~ServiceMenuIndex();
+
+    /** Rebuilds the index, if a service menu directory has been changed. */
+    void update();
+
+    /** Adds the index of the entry \a index to the list \a list. */
+    static void addIndex(QValueList<uint>& list, uint index);
+
+    struct Entry
+    {
+        QString path;
+        QString submenuName;
+
+        /**
+         * True if the services are provided by X-KDE-GetActionMenu. In this
+         * case the services must be requested each time, as the
+         * provided actions might change.
+         */
+        bool isDynamic;
+
+        QValueList<KDEDesktopMimeType::Service> services;
+    };
+
+    QStringList m_dirs;
+    QValueList<QDateTime> m_dirModifications;
+
+    QValueVector<Entry> m_entries;
+    QMap<QString, QValueList<uint> > m_mimeTypeIndex;
+    QMap<QString, QValueList<uint> > m_mimeGroupIndex;
+    QValueList<uint> m_allFilesIndex;
+};
+
+#endif
@@ -20,21 +20,75 @@
 
 #include "statusbarspaceinfo.h"
 
+#include <sys/statvfs.h>
+
+#include <qfile.h>
 #include <qpainter.h>
 #include <qtimer.h>
 #include <kglobalsettings.h>
-#include <kdiskfreesp.h>
 #include <klocale.h>
 #include <kio/job.h>
 
+#include "workerpool.h"
+
+/**
+ * @brief Reads the size and the available space of a local file system.
+ *
+ * statvfs() might block for file systems of unreachable servers,
+ * hence it is invoked by a thread of the worker pool.
+ */
+class SpaceInfoJob : public WorkerJob
+{
+public:
+    SpaceInfoJob(const QCString& path);
+    virtual ~SpaceInfoJob();
+
+    unsigned long kBSize() const { return m_kBSize; }
+    unsigned long kBAvailable() const { return m_kBAvailable; }
+
+protected:
+    virtual void run();
+
+private:
+    QCString m_path;
+    unsigned long m_kBSize;
+    unsigned long m_kBAvailable;
+};
+
+SpaceInfoJob::SpaceInfoJob(const QCString& path) :
+    m_path(path.copy()),
+    m_kBSize(0),
+    m_kBAvailable(0)
+{
+}
+
+SpaceInfoJob::~SpaceInfoJob()
+{
+}
+
+void SpaceInfoJob::run()
+{
+    struct statvfs buf;
+    if (::statvfs(m_path, &buf) == 0) {
+        const Q_UINT64 blockSize = buf.f_frsize;
+        m_kBSize = static_cast<unsigned long>((buf.f_blocks * blockSize) / 1024);
+        m_kBAvailable = static_cast<unsigned long>((buf.f_bavail * blockSize) / 1024);
+    }
+}
+
 StatusBarSpaceInfo::StatusBarSpaceInfo(QWidget* parent) :
     QWidget(parent),
     m_gettingSize(false),
+    m_urlChanged(false),
     m_kBSize(0),
-    m_kBAvailable(0)
+    m_kBAvailable(0),
+    m_job(0)
 {
     setMinimumWidth(200);
 
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotJobFinished(WorkerJob*)));
+
     // Update the space information each 10 seconds. Polling is useful
     // here, as files can be deleted/added outside the scope of Dolphin.
     QTimer* timer = new QTimer(this);
@@ -44,12 +98,24 @@ StatusBarSpaceInfo::StatusBarSpaceInfo(QWidget* parent) :
 
 StatusBarSpaceInfo::~StatusBarSpaceInfo()
 {
+    WorkerPool::instance().cancelJobs(this);
 }
 
 void StatusBarSpaceInfo::setURL(const KURL& url)
 {
     m_url = url;
-    refresh();
+    if (m_job != 0) {
+        // The pending request is not cancelled, as it might block a worker
+        // thread already. Its result is skipped and the space information
+        // for the new URL is requested as soon as it has been finished.
+        m_urlChanged = true;
+        m_gettingSize = true;
+        m_kBSize = 0;
+        m_kBAvailable = 0;
+    }
+    else {
+        refresh();
+    }
     update();
 }
 
@@ -110,30 +176,23 @@ void StatusBarSpaceInfo::paintEvent(QPaintEvent* /* event */)
 }
 
 
-void StatusBarSpaceInfo::slotFoundMountPoint(const unsigned long& kBSize,
-                                             const unsigned long& /* kBUsed */,
-                                             const unsigned long& kBAvailable,
-                                             const QString& /* mountPoint */)
+void StatusBarSpaceInfo::slotJobFinished(WorkerJob* job)
 {
-    m_gettingSize = false;
-    m_kBSize = kBSize;
-    m_kBAvailable = kBAvailable;
-
-    // Bypass a the issue (?) of KDiskFreeSp that for protocols like
-    // FTP, SMB the size of root partition is returned.
-    // TODO: check whether KDiskFreeSp is buggy or Dolphin uses it in a wrong way
-    const QString protocol(m_url.protocol());
-    if (!protocol.isEmpty() && (protocol != "file")) {
-        m_kBSize = 0;
-        m_kBAvailable = 0;
+    if (job != m_job) {
+        return;
     }
 
-    update();
-}
-
-void StatusBarSpaceInfo::slotDone()
-{
+    const SpaceInfoJob* spaceInfoJob = static_cast<SpaceInfoJob*>(job);
+    m_job = 0;
+    if (m_urlChanged) {
+        m_urlChanged = false;
+        refresh();
+        update();
+        return;
+    }
     m_gettingSize = false;
+    m_kBSize = spaceInfoJob->kBSize();
+    m_kBAvailable = spaceInfoJob->kBAvailable();
     if ((m_kBSize > 0) && (m_kBAvailable > 0)) {
        show();
     }
@@ -143,25 +202,25 @@ void StatusBarSpaceInfo::slotDone()
 
 void StatusBarSpaceInfo::refresh()
 {
+    if (m_job != 0) {
+        // Don't start a second request, if the file system does not respond.
+        return;
+    }
+
     m_gettingSize = true;
     m_kBSize = 0;
     m_kBAvailable = 0;
 
-    const QString mountPoint(KIO::findPathMountPoint(m_url.path()));
-
-    KDiskFreeSp* job = new KDiskFreeSp(this);
-    connect(job, SIGNAL(foundMountPoint(const unsigned long&,
-                                        const unsigned long&,
-                                        const unsigned long&,
-                                        const QString& )),
-            this, SLOT(slotFoundMountPoint(const unsigned long&,
-                                           const unsigned long&,
-                                           const unsigned long&,
-                                           const QString& )));
-    connect(job, SIGNAL(done()),
-            this, SLOT(slotDone()));
-
-    job->readDF(mountPoint);
+    // The available space is only known for local file systems. For
+    // protocols like FTP or SMB no space information is shown.
+    if (!m_url.isLocalFile()) {
+        m_gettingSize = false;
+        update();
+        return;
+    }
+
+    m_job = new SpaceInfoJob(QFile::encodeName(m_url.path()));
+    WorkerPool::instance().enqueue(m_job, WorkerJob::Preview, this);
 }
 
 QColor StatusBarSpaceInfo::progressColor(const QColor& bgColor) const
@@ -25,7 +25,8 @@
 #include <kurl.h>
 #include <qcolor.h>
 
-class KDiskFreeSp;
+class SpaceInfoJob;
+class WorkerJob;
 
 /**
  * @short Shows the available space for the current volume as part
@@ -47,16 +48,8 @@ protected:
     virtual void paintEvent(QPaintEvent* event);
 
 private slots:
-    /**
-     * The strange signature of this method is due to a compiler
-     * bug (?). More details are given inside the class KDiskFreeSp (see
-     * KDE Libs documentation).
-     */
-    void slotFoundMountPoint(const unsigned long& kBSize,
-                             const unsigned long& kBUsed,
-                             const unsigned long& kBAvailable,
-                             const QString& mountPoint);
-    void slotDone();
+    /** Takes over the space information read by the job \a job. */
+    void slotJobFinished(WorkerJob* job);
 
     /** Refreshs the space information for the current set URL. */
     void refresh();
@@ -71,9 +64,15 @@ private:
 
     KURL m_url;
     bool m_gettingSize;
+    bool m_urlChanged;
     unsigned long m_kBSize;
     unsigned long m_kBAvailable;
-
+    /**
+     * Request for the space information. At most one request is pending,
+     * as a request for an unreachable file system might block a thread of
+     * the worker pool until the server responds.
+     */
+    SpaceInfoJob* m_job;
 };
 
 #endif
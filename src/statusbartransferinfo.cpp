@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "statusbartransferinfo.h"
+
+#include <qstylesheet.h>
+#include <qtooltip.h>
+
+#include <kio/global.h>
+#include <klocale.h>
+#include <kpopupmenu.h>
+
+#include "transferscheduler.h"
+
+/** Returns a description of the operation and the progress of \a transfer. */
+static QString transferDescription(const TransferScheduler::Transfer& transfer)
+{
+    const DolphinCommand& command = transfer.command;
+    const int count = command.source().count();
+    const QString dest(command.destination().prettyURL());
+
+    QString text;
+    if (command.type() == DolphinCommand::Move) {
+        text = i18n("Moving 1 item to %1", "Moving %n items to %1", count).arg(dest);
+    }
+    else {
+        text = i18n("Copying 1 item to %1", "Copying %n items to %1", count).arg(dest);
+    }
+
+    if (transfer.scanJob != 0) {
+        text += " " + i18n("(checking)");
+    }
+    else if (transfer.job == 0) {
+        text += " " + i18n("(queued)");
+    }
+    else if (transfer.totalSize > 0) {
+        text += " " + i18n("(%1 of %2)").arg(KIO::convertSize(transfer.processedSize))
+                                        .arg(KIO::convertSize(transfer.totalSize));
+    }
+
+    return text;
+}
+
+StatusBarTransferInfo::StatusBarTransferInfo(QWidget* parent) :
+    QLabel(parent)
+{
+    hide();
+    connect(&TransferScheduler::instance(), SIGNAL(transfersChanged()),
+            this, SLOT(refresh()));
+    refresh();
+}
+
+StatusBarTransferInfo::~StatusBarTransferInfo()
+{
+}
+
+void StatusBarTransferInfo::mousePressEvent(QMouseEvent* /* event */)
+{
+    TransferScheduler& scheduler = TransferScheduler::instance();
+    const QValueList<TransferScheduler::Transfer>& transfers = scheduler.transfers();
+    if (transfers.isEmpty()) {
+        return;
+    }
+
+    KPopupMenu popup(this);
+    popup.insertTitle(i18n("Cancel Transfer"));
+    QValueList<TransferScheduler::Transfer>::ConstIterator it = transfers.begin();
+    const QValueList<TransferScheduler::Transfer>::ConstIterator end = transfers.end();
+    while (it != end) {
+        popup.insertItem(transferDescription(*it), (*it).id);
+        ++it;
+    }
+
+    const int id = popup.exec(mapToGlobal(QPoint(0, 0)));
+    if (id > 0) {
+        scheduler.cancel(id);
+    }
+}
+
+void StatusBarTransferInfo::refresh()
+{
+    const TransferScheduler& scheduler = TransferScheduler::instance();
+    const int running = scheduler.runningCount();
+    const int queued = scheduler.queuedCount();
+    if ((running == 0) && (queued == 0)) {
+        hide();
+        return;
+    }
+
+    QString text(i18n("1 transfer running", "%n transfers running", running));
+    if (queued > 0) {
+        text += ", " + i18n("1 queued", "%n queued", queued);
+    }
+    const unsigned long speed = scheduler.speed();
+    if (speed > 0) {
+        text += " - " + i18n("%1/s").arg(KIO::convertSize(speed));
+    }
+    setText(text);
+
+    QString tip;
+    const QValueList<TransferScheduler::Transfer>& transfers = scheduler.transfers();
+    QValueList<TransferScheduler::Transfer>::ConstIterator it = transfers.begin();
+    const QValueList<TransferScheduler::Transfer>::ConstIterator end = transfers.end();
+    while (it != end) {
+        if (!tip.isEmpty()) {
+            tip += "<br>";
+        }
+        tip += QStyleSheet::escape(transferDescription(*it));
+        ++it;
+    }
+    QToolTip::remove(this);
+    QToolTip::add(this, "<qt>" + tip + "</qt>");
+
+    show();
+}
+
+#include "statusbartransferinfo.moc"
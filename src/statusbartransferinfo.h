@@ -0,0 +1,53 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef STATUSBARTRANSFERINFO_H
+#define STATUSBARTRANSFERINFO_H
+
+#include <qlabel.h>
+
+/**
+ * @short Shows the queued and running transfers of the
+ *        TransferScheduler as part of the status bar.
+ *
+ * The number of running and queued transfers is shown together
+ * with the summarized throughput. The tooltip lists the progress
+ * of each transfer. Clicking on the widget opens a menu, which
+ * allows to cancel a transfer. The widget is hidden as long as
+ * no transfer is queued or running.
+ */
+class StatusBarTransferInfo : public QLabel
+{
+    Q_OBJECT
+
+public:
+    StatusBarTransferInfo(QWidget* parent);
+    virtual ~StatusBarTransferInfo();
+
+protected:
+    /** @see QWidget::mousePressEvent */
+    virtual void mousePressEvent(QMouseEvent* event);
+
+private slots:
+    /** Updates the text and the tooltip for the current transfers. */
+    void refresh();
+};
+
+#endif
@@ -0,0 +1,322 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "transferjournal.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <qbuffer.h>
+#include <qdatastream.h>
+#include <qdir.h>
+#include <qfile.h>
+
+#include <kstandarddirs.h>
+
+// Increase the version if the format of the journal changes.
+#define JOURNAL_MAGIC   0xD3A1F11E
+#define JOURNAL_VERSION 1
+
+// Value of the progress slot of a completely copied file.
+#define COMPLETED_SLOT (~static_cast<Q_UINT64>(0))
+
+/** Writes \a size bytes of \a data to \a fd. */
+static bool writeAll(int fd, const char* data, size_t size)
+{
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+TransferJournal* TransferJournal::create(const DolphinCommand& command,
+                                         const ConflictResolutions& resolutions,
+                                         const QValueVector<File>& files)
+{
+    QBuffer buffer;
+    buffer.open(IO_WriteOnly);
+    QDataStream stream(&buffer);
+    stream << static_cast<Q_UINT32>(JOURNAL_MAGIC)
+           << static_cast<Q_UINT32>(JOURNAL_VERSION)
+           << static_cast<Q_INT32>(command.type())
+           << command.source()
+           << command.destination()
+           << static_cast<Q_UINT32>(resolutions.count());
+
+    ConflictResolutions::ConstIterator resolutionIt = resolutions.begin();
+    const ConflictResolutions::ConstIterator resolutionsEnd = resolutions.end();
+    while (resolutionIt != resolutionsEnd) {
+        stream << resolutionIt.key()
+               << static_cast<Q_INT32>(resolutionIt.data().action)
+               << resolutionIt.data().newName;
+        ++resolutionIt;
+    }
+
+    stream << static_cast<Q_UINT32>(files.count());
+    QValueVector<File>::ConstIterator it = files.begin();
+    const QValueVector<File>::ConstIterator end = files.end();
+    while (it != end) {
+        stream << (*it).sourcePath
+               << static_cast<Q_UINT64>((*it).size)
+               << static_cast<Q_UINT32>((*it).mtime);
+        ++it;
+    }
+
+    // the progress slots are aligned, so that they can be updated atomically
+    const uint headerSize = buffer.at();
+    const uint slotsOffset = (headerSize + 7) & ~7;
+    const size_t size = slotsOffset + files.count() * sizeof(Q_UINT64);
+    buffer.close();
+
+    // The journal is written under a temporary name, so that it is not
+    // taken for the journal of an interrupted transfer before it is locked.
+    static uint counter = 0;
+    const QString fileName(journalDir() + QString("%1-%2-%3.journal")
+                                          .arg(::getpid()).arg(::time(0)).arg(counter++));
+    const QCString tempFile(QFile::encodeName(fileName + ".part"));
+    const int fd = ::open(tempFile, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return 0;
+    }
+
+    TransferJournal* journal = new TransferJournal(fileName, fd);
+    const bool ok = (::flock(fd, LOCK_EX | LOCK_NB) == 0) &&
+                    writeAll(fd, buffer.buffer().data(), headerSize) &&
+                    (::ftruncate(fd, size) == 0) &&
+                    journal->map() &&
+                    (::rename(tempFile, QFile::encodeName(fileName)) == 0);
+    if (!ok) {
+        ::unlink(tempFile);
+        delete journal;
+        return 0;
+    }
+
+    journal->m_slots = reinterpret_cast<volatile Q_UINT64*>(journal->m_data + slotsOffset);
+    journal->m_command = command;
+    journal->m_resolutions = resolutions;
+    journal->m_files = files;
+    return journal;
+}
+
+TransferJournal* TransferJournal::open(const QString& fileName)
+{
+    const int fd = ::open(QFile::encodeName(fileName), O_RDWR);
+    if (fd < 0) {
+        return 0;
+    }
+
+    TransferJournal* journal = new TransferJournal(fileName, fd);
+    if ((::flock(fd, LOCK_EX | LOCK_NB) != 0) || !journal->map() || !journal->read()) {
+        delete journal;
+        return 0;
+    }
+
+    return journal;
+}
+
+QStringList TransferJournal::interruptedJournals()
+{
+    QStringList journals;
+
+    const QString dir(journalDir());
+    const QStringList entries(QDir(dir).entryList("*.journal", QDir::Files));
+    QStringList::ConstIterator it = entries.begin();
+    const QStringList::ConstIterator end = entries.end();
+    while (it != end) {
+        const QString fileName(dir + *it);
+        const int fd = ::open(QFile::encodeName(fileName), O_RDONLY);
+        if (fd >= 0) {
+            // the journal of a running transfer is locked
+            if (::flock(fd, LOCK_SH | LOCK_NB) == 0) {
+                journals.append(fileName);
+            }
+            ::close(fd);
+        }
+        ++it;
+    }
+
+    return journals;
+}
+
+TransferJournal::~TransferJournal()
+{
+    if (m_data != 0) {
+        ::munmap(m_data, m_size);
+    }
+    if (m_fd >= 0) {
+        // releases the lock
+        ::close(m_fd);
+    }
+}
+
+KIO::filesize_t TransferJournal::progress(uint index) const
+{
+    assert(index < m_files.count());
+    const Q_UINT64 slot = m_slots[index];
+    return (slot == COMPLETED_SLOT) ? m_files[index].size : slot;
+}
+
+bool TransferJournal::isCompleted(uint index) const
+{
+    assert(index < m_files.count());
+    return m_slots[index] == COMPLETED_SLOT;
+}
+
+void TransferJournal::setProgress(uint index, KIO::filesize_t size)
+{
+    m_slots[index] = size;
+}
+
+void TransferJournal::setCompleted(uint index)
+{
+    m_slots[index] = COMPLETED_SLOT;
+}
+
+void TransferJournal::flush(uint index)
+{
+    assert(index < m_files.count());
+
+    // the mapped area starts at a page boundary, the slot might cross one
+    static const long pageSize = ::sysconf(_SC_PAGESIZE);
+    const char* slot = reinterpret_cast<const char*>(const_cast<Q_UINT64*>(m_slots + index));
+    const size_t offset = slot - m_data;
+    const size_t start = offset - (offset % pageSize);
+    ::msync(m_data + start, offset + sizeof(Q_UINT64) - start, MS_SYNC);
+}
+
+void TransferJournal::remove()
+{
+    m_removed = true;
+    ::unlink(QFile::encodeName(m_fileName));
+}
+
+TransferJournal::TransferJournal(const QString& fileName, int fd) :
+    m_fileName(fileName),
+    m_fd(fd),
+    m_data(0),
+    m_size(0),
+    m_slots(0),
+    m_removed(false)
+{
+}
+
+bool TransferJournal::map()
+{
+    struct stat buf;
+    if ((::fstat(m_fd, &buf) != 0) || (buf.st_size == 0)) {
+        return false;
+    }
+
+    void* data = ::mmap(0, buf.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    m_data = static_cast<char*>(data);
+    m_size = buf.st_size;
+    return true;
+}
+
+bool TransferJournal::read()
+{
+    QByteArray data;
+    data.setRawData(m_data, m_size);
+
+    bool ok = false;
+    uint headerSize = 0;
+    {
+        QBuffer buffer(data);
+        buffer.open(IO_ReadOnly);
+        QDataStream stream(&buffer);
+
+        Q_UINT32 magic = 0;
+        Q_UINT32 version = 0;
+        Q_INT32 type = 0;
+        KURL::List source;
+        KURL dest;
+        Q_UINT32 resolutionCount = 0;
+        Q_UINT32 count = 0;
+        stream >> magic >> version;
+        if ((magic == JOURNAL_MAGIC) && (version == JOURNAL_VERSION)) {
+            stream >> type >> source >> dest >> resolutionCount;
+            ok = ((type == DolphinCommand::Copy) || (type == DolphinCommand::Move));
+        }
+
+        for (Q_UINT32 i = 0; ok && (i < resolutionCount); ++i) {
+            QCString path;
+            Q_INT32 action = 0;
+            ConflictResolution resolution;
+            stream >> path >> action >> resolution.newName;
+            resolution.action = static_cast<ConflictResolution::Action>(action);
+            m_resolutions.insert(path, resolution);
+            ok = !stream.atEnd();
+        }
+
+        if (ok) {
+            stream >> count;
+            ok = (count <= m_size / sizeof(Q_UINT64));
+        }
+
+        if (ok) {
+            m_command = DolphinCommand(static_cast<DolphinCommand::Type>(type), source, dest);
+            m_files.reserve(count);
+            for (Q_UINT32 i = 0; (i < count) && !stream.atEnd(); ++i) {
+                File file;
+                Q_UINT64 size = 0;
+                Q_UINT32 mtime = 0;
+                stream >> file.sourcePath >> size >> mtime;
+                file.size = size;
+                file.mtime = mtime;
+                m_files.append(file);
+            }
+            ok = (m_files.count() == count);
+            headerSize = buffer.at();
+        }
+        buffer.close();
+    }
+    data.resetRawData(m_data, m_size);
+
+    const uint slotsOffset = (headerSize + 7) & ~7;
+    if (!ok || (slotsOffset + m_files.count() * sizeof(Q_UINT64) > m_size)) {
+        return false;
+    }
+
+    m_slots = reinterpret_cast<volatile Q_UINT64*>(m_data + slotsOffset);
+    return true;
+}
+
+QString TransferJournal::journalDir()
+{
+    return KGlobal::dirs()->saveLocation("data", "d3lphin/transfers/");
+}
@@ -0,0 +1,159 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef TRANSFERJOURNAL_H
+#define TRANSFERJOURNAL_H
+
+#include <qcstring.h>
+#include <qshared.h>
+#include <qstringlist.h>
+#include <qvaluevector.h>
+
+#include <kio/global.h>
+
+#include "conflictscanjob.h"
+#include "undomanager.h"
+
+/**
+ * @brief Records the progress of a copy or move operation on the disk.
+ *
+ * If Dolphin gets closed or crashes while a large transfer is running,
+ * the KIO job is gone and the transfer would have to be started again from
+ * the beginning. The transfer journal stores the operation, the conflict
+ * resolutions and the list of the transferred files inside a file of the
+ * local data directory. For each
+ * file a progress slot is kept inside a memory mapped area of the journal,
+ * which is updated by the copying threads without further locking:
+ * - 0 if the file has not been copied yet,
+ * - the number of bytes, which have been written to the disk for partially
+ *   copied files,
+ * - a special value for completely copied files.
+ *
+ * As long as a journal is opened, the journal file is locked. The locks
+ * are released by the kernel when the process terminates, hence the
+ * journals of interrupted transfers are the unlocked ones (see
+ * TransferJournal::interruptedJournals()).
+ *
+ * The journal is reference counted, as the jobs of the worker pool might
+ * still access the progress slots after the transfer has been cancelled.
+ * The reference count may only be changed inside the GUI thread.
+ */
+class TransferJournal : public QShared
+{
+public:
+    /** Describes one file of the transfer. */
+    struct File
+    {
+        /** Absolute path of the source file. */
+        QCString sourcePath;
+
+        KIO::filesize_t size;
+        time_t mtime;
+    };
+
+    /**
+     * Creates a journal for the operation \a command, which transfers the
+     * files \a files. The conflicts with existing items of the destination
+     * are resolved by \a resolutions. 0 is returned if the journal could
+     * not be written.
+     */
+    static TransferJournal* create(const DolphinCommand& command,
+                                   const ConflictResolutions& resolutions,
+                                   const QValueVector<File>& files);
+
+    /**
+     * Opens the journal \a fileName of an interrupted transfer. 0 is returned
+     * if the journal is invalid or is used by a running transfer.
+     */
+    static TransferJournal* open(const QString& fileName);
+
+    /** Returns the file names of the journals of all interrupted transfers. */
+    static QStringList interruptedJournals();
+
+    ~TransferJournal();
+
+    const QString& fileName() const { return m_fileName; }
+    const DolphinCommand& command() const { return m_command; }
+    const ConflictResolutions& resolutions() const { return m_resolutions; }
+    const QValueVector<File>& files() const { return m_files; }
+
+    /**
+     * Returns the number of bytes of the file with the index \a index,
+     * which are stored on the disk. Is thread-safe.
+     */
+    KIO::filesize_t progress(uint index) const;
+
+    /** Returns true, if the file with the index \a index has been copied completely. Is thread-safe. */
+    bool isCompleted(uint index) const;
+
+    /**
+     * Remembers that the first \a size bytes of the file with the index
+     * \a index are stored on the disk. Is thread-safe.
+     */
+    void setProgress(uint index, KIO::filesize_t size);
+
+    /** Remembers that the file with the index \a index has been copied completely. Is thread-safe. */
+    void setCompleted(uint index);
+
+    /**
+     * Writes the progress slot of the file with the index \a index to the
+     * disk and returns after the write has been finished. Is thread-safe.
+     */
+    void flush(uint index);
+
+    /**
+     * Deletes the journal file. Must be invoked when the transfer has been
+     * finished or cancelled. The progress slots stay accessible until
+     * the journal is deleted.
+     */
+    void remove();
+
+    /** Returns true, if the journal file has been deleted by TransferJournal::remove(). Is thread-safe. */
+    bool isRemoved() const { return m_removed; }
+
+private:
+    TransferJournal(const QString& fileName, int fd);
+
+    /** Maps the whole journal file into the memory. */
+    bool map();
+
+    /**
+     * Reads the operation and the file list from the mapped journal and
+     * sets the start of the progress slots. False is returned if the journal
+     * is invalid.
+     */
+    bool read();
+
+    /** Returns the directory, where the journals are stored. */
+    static QString journalDir();
+
+    QString m_fileName;
+    int m_fd;
+    char* m_data;
+    size_t m_size;
+    volatile Q_UINT64* m_slots;
+    volatile bool m_removed;
+
+    DolphinCommand m_command;
+    ConflictResolutions m_resolutions;
+    QValueVector<File> m_files;
+};
+
+#endif
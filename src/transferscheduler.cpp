@@ -0,0 +1,554 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "transferscheduler.h"
+
+#include <assert.h>
+#include <sys/stat.h>
+
+#include <qfile.h>
+#include <qmap.h>
+#include <qtimer.h>
+#include <qtl.h>
+
+#include <kde_file.h>
+#include <kio/job.h>
+#include <klocale.h>
+#include <kmessagebox.h>
+
+#include "conflictdialog.h"
+#include "dolphinsettings.h"
+#include "localcopyjob.h"
+#include "localmovejob.h"
+#include "transferjournal.h"
+#include "workerpool.h"
+
+// Maximum number of running transfers, which may access the same device.
+#define MAX_TRANSFERS_PER_DEVICE 1
+
+TransferScheduler& TransferScheduler::instance()
+{
+    static TransferScheduler* instance = 0;
+    if (instance == 0) {
+        instance = new TransferScheduler();
+    }
+    return *instance;
+}
+
+void TransferScheduler::enqueue(const DolphinCommand& command)
+{
+    // The conflicts are checked when the transfer is about to be started,
+    // as previous transfers into the same folder might add conflicts.
+    Transfer transfer(createTransfer(command));
+    transfer.needsScan = isLocalTransfer(command);
+
+    m_transfers.append(transfer);
+    startTransfers();
+}
+
+void TransferScheduler::cancel(int id)
+{
+    QValueList<Transfer>::Iterator it = m_transfers.begin();
+    const QValueList<Transfer>::Iterator end = m_transfers.end();
+    while (it != end) {
+        if ((*it).id == id) {
+            if ((*it).job == 0) {
+                if ((*it).scanJob != 0) {
+                    WorkerPool::instance().cancel((*it).scanJob);
+                }
+                if ((*it).journal != 0) {
+                    // the user does not want to resume the transfer anymore
+                    (*it).journal->remove();
+                    delete (*it).journal;
+                }
+                m_transfers.remove(it);
+
+                // the reserved devices might be used by another transfer now
+                startTransfers();
+            }
+            else {
+                // the transfer is removed by slotJobDestroyed()
+                (*it).job->kill(false);
+            }
+            return;
+        }
+        ++it;
+    }
+}
+
+int TransferScheduler::runningCount() const
+{
+    int count = 0;
+    QValueList<Transfer>::ConstIterator it = m_transfers.begin();
+    const QValueList<Transfer>::ConstIterator end = m_transfers.end();
+    while (it != end) {
+        if ((*it).job != 0) {
+            ++count;
+        }
+        ++it;
+    }
+    return count;
+}
+
+int TransferScheduler::queuedCount() const
+{
+    return m_transfers.count() - runningCount();
+}
+
+unsigned long TransferScheduler::speed() const
+{
+    unsigned long speed = 0;
+    QValueList<Transfer>::ConstIterator it = m_transfers.begin();
+    const QValueList<Transfer>::ConstIterator end = m_transfers.end();
+    while (it != end) {
+        speed += (*it).speed;
+        ++it;
+    }
+    return speed;
+}
+
+void TransferScheduler::resumeInterruptedTransfers()
+{
+    const QStringList journals(TransferJournal::interruptedJournals());
+    QStringList::ConstIterator it = journals.begin();
+    const QStringList::ConstIterator end = journals.end();
+    while (it != end) {
+        TransferJournal* journal = TransferJournal::open(*it);
+        ++it;
+        if (journal == 0) {
+            continue;
+        }
+
+        const DolphinCommand& command = journal->command();
+        if (!LocalCopyJob::canCopy(command.source(), command.destination())) {
+            // The destination is not available (e. g. the disk is not mounted).
+            // The journal is kept, so that the transfer can be resumed later.
+            delete journal;
+            continue;
+        }
+
+        KIO::filesize_t totalSize = 0;
+        KIO::filesize_t copiedSize = 0;
+        const uint count = journal->files().count();
+        for (uint i = 0; i < count; ++i) {
+            totalSize += journal->files()[i].size;
+            copiedSize += journal->progress(i);
+        }
+
+        const QString destination(command.destination().prettyURL());
+        const QString text = (command.type() == DolphinCommand::Move) ?
+            i18n("Moving items to '%1' has been interrupted after %2 of %3 "
+                 "have been copied. Do you want to resume it?") :
+            i18n("Copying items to '%1' has been interrupted after %2 of %3 "
+                 "have been copied. Do you want to resume it?");
+        const int result = KMessageBox::questionYesNoCancel(0,
+                                text.arg(destination)
+                                    .arg(KIO::convertSize(copiedSize))
+                                    .arg(KIO::convertSize(totalSize)),
+                                i18n("Interrupted Transfer"),
+                                KGuiItem(i18n("Resume")),
+                                KGuiItem(i18n("Discard")));
+        if (result == KMessageBox::Yes) {
+            Transfer transfer(createTransfer(command));
+            transfer.resolutions = journal->resolutions();
+            transfer.journal = journal;
+            m_transfers.append(transfer);
+        }
+        else {
+            // on 'Cancel' the user is asked again on the next start
+            if (result == KMessageBox::No) {
+                journal->remove();
+            }
+            delete journal;
+        }
+    }
+
+    startTransfers();
+}
+
+TransferScheduler::TransferScheduler() :
+    QObject(0),
+    m_nextId(1),
+    m_updateTimer(0)
+{
+    m_updateTimer = new QTimer(this);
+    connect(m_updateTimer, SIGNAL(timeout()),
+            this, SIGNAL(transfersChanged()));
+
+    connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+            this, SLOT(slotScanFinished(WorkerJob*)));
+}
+
+TransferScheduler::~TransferScheduler()
+{
+}
+
+void TransferScheduler::startTransfers()
+{
+    QMap<QString, int> usedDevices;
+    QValueList<Transfer>::Iterator it = m_transfers.begin();
+    const QValueList<Transfer>::Iterator end = m_transfers.end();
+    while (it != end) {
+        if (isActive(*it)) {
+            QStringList::ConstIterator deviceIt = (*it).devices.begin();
+            while (deviceIt != (*it).devices.end()) {
+                ++usedDevices[*deviceIt];
+                ++deviceIt;
+            }
+        }
+        ++it;
+    }
+
+    for (it = m_transfers.begin(); it != end; ++it) {
+        Transfer& transfer = *it;
+        if (isActive(transfer)) {
+            continue;
+        }
+
+        bool isDeviceAvailable = true;
+        QStringList::ConstIterator deviceIt = transfer.devices.begin();
+        while (isDeviceAvailable && (deviceIt != transfer.devices.end())) {
+            isDeviceAvailable = (usedDevices[*deviceIt] < MAX_TRANSFERS_PER_DEVICE);
+            ++deviceIt;
+        }
+        if (!isDeviceAvailable) {
+            continue;
+        }
+
+        for (deviceIt = transfer.devices.begin(); deviceIt != transfer.devices.end(); ++deviceIt) {
+            ++usedDevices[*deviceIt];
+        }
+
+        if (transfer.needsScan) {
+            // the devices stay reserved until the conflicts have been resolved
+            startScan(transfer);
+            continue;
+        }
+
+        KIO::Job* job = createJob(transfer);
+        transfer.job = job;
+        connect(job, SIGNAL(totalSize(KIO::Job*, KIO::filesize_t)),
+                this, SLOT(slotTotalSize(KIO::Job*, KIO::filesize_t)));
+        connect(job, SIGNAL(processedSize(KIO::Job*, KIO::filesize_t)),
+                this, SLOT(slotProcessedSize(KIO::Job*, KIO::filesize_t)));
+        connect(job, SIGNAL(speed(KIO::Job*, unsigned long)),
+                this, SLOT(slotSpeed(KIO::Job*, unsigned long)));
+        connect(job, SIGNAL(destroyed(QObject*)),
+                this, SLOT(slotJobDestroyed(QObject*)));
+
+        DolphinCommand command(transfer.command);
+        if (isLocalTransfer(command)) {
+            command.setDestNames(destNames(transfer));
+        }
+        emit transferStarted(job, command);
+    }
+
+    scheduleUpdate();
+}
+
+void TransferScheduler::slotTotalSize(KIO::Job* job, KIO::filesize_t size)
+{
+    Transfer* transfer = findTransfer(job);
+    if (transfer != 0) {
+        transfer->totalSize = size;
+        scheduleUpdate();
+    }
+}
+
+void TransferScheduler::slotProcessedSize(KIO::Job* job, KIO::filesize_t size)
+{
+    Transfer* transfer = findTransfer(job);
+    if (transfer != 0) {
+        transfer->processedSize = size;
+        scheduleUpdate();
+    }
+}
+
+void TransferScheduler::slotSpeed(KIO::Job* job, unsigned long speed)
+{
+    Transfer* transfer = findTransfer(job);
+    if (transfer != 0) {
+        transfer->speed = speed;
+        scheduleUpdate();
+    }
+}
+
+void TransferScheduler::slotJobDestroyed(QObject* job)
+{
+    QValueList<Transfer>::Iterator it = m_transfers.begin();
+    const QValueList<Transfer>::Iterator end = m_transfers.end();
+    while (it != end) {
+        if (static_cast<QObject*>((*it).job) == job) {
+            m_transfers.remove(it);
+            break;
+        }
+        ++it;
+    }
+
+    // the devices of the finished job might be used by a queued transfer now
+    startTransfers();
+}
+
+void TransferScheduler::slotScanFinished(WorkerJob* job)
+{
+    QValueList<Transfer>::Iterator it = m_transfers.begin();
+    const QValueList<Transfer>::Iterator end = m_transfers.end();
+    while ((it != end) && (static_cast<WorkerJob*>((*it).scanJob) != job)) {
+        ++it;
+    }
+    if (it == end) {
+        // the job does not belong to a transfer
+        return;
+    }
+
+    const ConflictScanJob* scanJob = static_cast<ConflictScanJob*>(job);
+    (*it).scanJob = 0;
+    (*it).needsScan = false;
+    (*it).mergedFolders = scanJob->mergedFolders();
+
+    const QValueVector<ConflictScanJob::Conflict>& conflicts = scanJob->conflicts();
+    if (!conflicts.isEmpty()) {
+        // Other transfers might be finished while the modal dialog is open. The
+        // transfer stays marked as resolving, so that it is not started before the
+        // user has decided. It might get cancelled by the user though, hence it is
+        // looked up again by its ID.
+        (*it).isResolving = true;
+        const int id = (*it).id;
+        ConflictDialog dialog(conflicts, (*it).command.destination());
+        const bool accepted = (dialog.exec() == QDialog::Accepted);
+
+        it = m_transfers.begin();
+        while ((it != end) && ((*it).id != id)) {
+            ++it;
+        }
+        if (it == end) {
+            startTransfers();
+            return;
+        }
+
+        (*it).isResolving = false;
+        if (accepted) {
+            (*it).resolutions = dialog.resolutions();
+        }
+        else {
+            m_transfers.remove(it);
+        }
+    }
+
+    startTransfers();
+}
+
+TransferScheduler::Transfer TransferScheduler::createTransfer(const DolphinCommand& command)
+{
+    Transfer transfer;
+    transfer.id = m_nextId++;
+    transfer.command = command;
+    transfer.devices = devices(command);
+    transfer.needsScan = false;
+    transfer.scanJob = 0;
+    transfer.isResolving = false;
+    transfer.journal = 0;
+    transfer.job = 0;
+    transfer.totalSize = 0;
+    transfer.processedSize = 0;
+    transfer.speed = 0;
+
+    const bool isLocalRename = (command.type() == DolphinCommand::Move) &&
+                               (transfer.devices.count() == 1) &&
+                               transfer.devices.first().startsWith("dev:");
+    if (isLocalRename) {
+        // moving inside one device does not block the device
+        transfer.devices.clear();
+    }
+
+    return transfer;
+}
+
+void TransferScheduler::startScan(Transfer& transfer)
+{
+    QValueVector<QCString> sourcePaths;
+    const KURL::List& source = transfer.command.source();
+    KURL::List::ConstIterator it = source.begin();
+    const KURL::List::ConstIterator end = source.end();
+    while (it != end) {
+        sourcePaths.append(QFile::encodeName((*it).path(-1)));
+        ++it;
+    }
+
+    transfer.scanJob = new ConflictScanJob(sourcePaths,
+                                           QFile::encodeName(transfer.command.destination().path(-1)));
+    WorkerPool::instance().enqueue(transfer.scanJob, WorkerJob::Listing);
+}
+
+bool TransferScheduler::isActive(const Transfer& transfer)
+{
+    return (transfer.job != 0) || (transfer.scanJob != 0) || transfer.isResolving;
+}
+
+QStringList TransferScheduler::destNames(const Transfer& transfer)
+{
+    QStringList names;
+    const KURL::List& source = transfer.command.source();
+    KURL::List::ConstIterator it = source.begin();
+    const KURL::List::ConstIterator end = source.end();
+    while (it != end) {
+        const QString name((*it).fileName());
+        const QCString encodedName(QFile::encodeName(name));
+
+        // Skipped items and folders, which are merged into existing folders,
+        // are not written as new items. Renamed items use their new name.
+        QString destName(name);
+        const ConflictResolutions::ConstIterator resolutionIt = transfer.resolutions.find(encodedName);
+        if (resolutionIt != transfer.resolutions.end()) {
+            const ConflictResolution& resolution = resolutionIt.data();
+            if (resolution.action == ConflictResolution::Skip) {
+                destName = "";
+            }
+            else if (resolution.action == ConflictResolution::Rename) {
+                destName = QFile::decodeName(resolution.newName);
+            }
+        }
+        else if (qFind(transfer.mergedFolders.begin(), transfer.mergedFolders.end(), encodedName) !=
+                 transfer.mergedFolders.end()) {
+            destName = "";
+        }
+
+        names.append(destName);
+        ++it;
+    }
+    return names;
+}
+
+TransferScheduler::Transfer* TransferScheduler::findTransfer(const QObject* job)
+{
+    QValueList<Transfer>::Iterator it = m_transfers.begin();
+    const QValueList<Transfer>::Iterator end = m_transfers.end();
+    while (it != end) {
+        if (static_cast<const QObject*>((*it).job) == job) {
+            return &(*it);
+        }
+        ++it;
+    }
+    return 0;
+}
+
+void TransferScheduler::scheduleUpdate()
+{
+    // The progress of each job is reported several times per second.
+    // Collect the changes to prevent expensive updates of the user interface.
+    if (!m_updateTimer->isActive()) {
+        m_updateTimer->start(500, true);
+    }
+}
+
+QStringList TransferScheduler::devices(const DolphinCommand& command)
+{
+    QStringList devices;
+    devices.append(device(command.destination()));
+
+    // The items of a folder are usually located on the same device, hence
+    // only the folder of each source item is checked.
+    QMap<QString, bool> checkedDirs;
+    const KURL::List& source = command.source();
+    KURL::List::ConstIterator it = source.begin();
+    const KURL::List::ConstIterator end = source.end();
+    while (it != end) {
+        KURL dirURL(*it);
+        dirURL.setPath(dirURL.directory());
+        const QString dir(dirURL.url());
+        if (!checkedDirs.contains(dir)) {
+            checkedDirs.insert(dir, true);
+            const QString sourceDevice(device(dirURL));
+            if (!devices.contains(sourceDevice)) {
+                devices.append(sourceDevice);
+            }
+        }
+        ++it;
+    }
+
+    return devices;
+}
+
+QString TransferScheduler::device(const KURL& url)
+{
+    if (url.isLocalFile()) {
+        // The destination might not exist yet. In this case
+        // the device of the next existing parent folder is used.
+        KURL checkedURL(url);
+        KDE_struct_stat buf;
+        while (KDE_stat(QFile::encodeName(checkedURL.path()), &buf) != 0) {
+            const KURL parentURL(checkedURL.upURL());
+            if (parentURL.path() == checkedURL.path()) {
+                return QString("file:");
+            }
+            checkedURL = parentURL;
+        }
+        return QString("dev:%1").arg(static_cast<Q_ULLONG>(buf.st_dev));
+    }
+
+    return url.protocol() + "://" + url.host();
+}
+
+bool TransferScheduler::isLocalTransfer(const DolphinCommand& command)
+{
+    const KURL::List& source = command.source();
+    const KURL& dest = command.destination();
+
+    switch (command.type()) {
+        case DolphinCommand::Copy: return LocalCopyJob::canCopy(source, dest);
+        case DolphinCommand::Move: return LocalMoveJob::canMove(source, dest) ||
+                                          LocalCopyJob::canCopy(source, dest);
+        default: break;
+    }
+
+    return false;
+}
+
+KIO::Job* TransferScheduler::createJob(const Transfer& transfer)
+{
+    const DolphinCommand& command = transfer.command;
+    const KURL::List& source = command.source();
+    const KURL& dest = command.destination();
+
+    // only copy and move operations are scheduled
+    const bool isMove = (command.type() == DolphinCommand::Move);
+    assert(isMove || (command.type() == DolphinCommand::Copy));
+
+    if (isMove && (transfer.journal == 0) && LocalMoveJob::canMove(source, dest)) {
+        return new LocalMoveJob(source, dest, transfer.resolutions);
+    }
+
+    // Moving items between different local file systems is done
+    // by a LocalCopyJob, which deletes the sources afterwards.
+    if (LocalCopyJob::canCopy(source, dest)) {
+        LocalCopyJob* job = new LocalCopyJob(source, dest, transfer.resolutions);
+        job->setVerifyEnabled(DolphinSettings::instance().isVerifyCopiesEnabled());
+        job->setMoveEnabled(isMove);
+        job->setResumeJournal(transfer.journal);
+        return job;
+    }
+
+    // the destination of a resumed transfer has been removed in the meantime
+    delete transfer.journal;
+
+    return isMove ? KIO::move(source, dest) : KIO::copy(source, dest);
+}
+
+#include "transferscheduler.moc"
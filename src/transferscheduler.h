@@ -0,0 +1,214 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef TRANSFERSCHEDULER_H
+#define TRANSFERSCHEDULER_H
+
+#include <qobject.h>
+#include <qstringlist.h>
+#include <qvaluelist.h>
+
+#include <kio/global.h>
+
+#include "conflictscanjob.h"
+#include "undomanager.h"
+
+class QTimer;
+class TransferJournal;
+class WorkerJob;
+namespace KIO {
+    class Job;
+}
+
+/**
+ * @brief Schedules the copy and move operations per device.
+ *
+ * Starting each transfer immediately lets several transfers to the same
+ * disk compete for it, which results in many seeks, while transfers to
+ * different disks are independent from each other. The transfer scheduler
+ * assigns each transfer the devices of its source and destination items.
+ * A transfer is only started if none of its devices is used by another
+ * running transfer, so that transfers for one device are executed one
+ * after the other and transfers for different devices in parallel.
+ *
+ * Moving items inside one local device only renames them and is
+ * started immediately.
+ *
+ * Large local transfers are recorded in a TransferJournal. When Dolphin
+ * is started again after it has been closed or has crashed during such
+ * a transfer, TransferScheduler::resumeInterruptedTransfers() offers
+ * to resume it.
+ *
+ * When the devices of a local transfer are available, a ConflictScanJob
+ * first checks whether items of the destination would be overwritten.
+ * If this is the case, the user decides once by the ConflictDialog how
+ * all conflicts should be resolved, so that the transfer can run without
+ * further questions. The devices stay reserved until the transfer has
+ * been started, so that no other transfer changes the destination in
+ * the meantime.
+ *
+ * As soon as the job for a transfer has been created, the signal
+ * TransferScheduler::transferStarted() is emitted, which allows to
+ * register the undo operation for the job. The command contains the
+ * names of the items, which are written into the destination (see
+ * DolphinCommand::setDestNames()).
+ */
+class TransferScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** Describes a queued or running transfer. */
+    struct Transfer
+    {
+        int id;
+        DolphinCommand command;
+        QStringList devices;
+
+        /** Is true as long as the conflicts of a local transfer have not been checked. */
+        bool needsScan;
+
+        /** Job which checks the conflicts of a local transfer. Is 0 if no check is running. */
+        ConflictScanJob* scanJob;
+
+        /** Is true while the user resolves the conflicts by the ConflictDialog. */
+        bool isResolving;
+
+        ConflictResolutions resolutions;
+
+        /** Names of the source folders, which are merged with existing destination folders. */
+        QValueVector<QCString> mergedFolders;
+
+        /** Journal of the interrupted transfer, which is resumed. Is 0 for new transfers. */
+        TransferJournal* journal;
+
+        /** Job which executes the transfer. Is 0 as long as the transfer is queued. */
+        KIO::Job* job;
+
+        KIO::filesize_t totalSize;
+        KIO::filesize_t processedSize;
+        unsigned long speed;
+    };
+
+    static TransferScheduler& instance();
+
+    /**
+     * Adds the copy or move operation \a command to the queue. The
+     * operation is started as soon as its devices are not used by
+     * another transfer.
+     */
+    void enqueue(const DolphinCommand& command);
+
+    /** Cancels the queued or running transfer with the ID \a id. */
+    void cancel(int id);
+
+    /** Returns all queued and running transfers in the order they have been added. */
+    const QValueList<Transfer>& transfers() const { return m_transfers; }
+
+    int runningCount() const;
+    int queuedCount() const;
+
+    /** Returns the summarized speed of all running transfers in bytes per second. */
+    unsigned long speed() const;
+
+public slots:
+    /**
+     * Asks the user for each transfer, which has been interrupted when
+     * Dolphin has been closed or has crashed, whether it should be resumed.
+     */
+    void resumeInterruptedTransfers();
+
+signals:
+    /** Is emitted if the job \a job for the operation \a command has been created. */
+    void transferStarted(KIO::Job* job, const DolphinCommand& command);
+
+    /**
+     * Is emitted if a transfer has been added, started or finished
+     * or if the progress of a transfer has been changed.
+     */
+    void transfersChanged();
+
+protected:
+    TransferScheduler();
+    virtual ~TransferScheduler();
+
+private slots:
+    /** Starts all queued transfers, whose devices are not used by a running transfer. */
+    void startTransfers();
+
+    void slotTotalSize(KIO::Job* job, KIO::filesize_t size);
+    void slotProcessedSize(KIO::Job* job, KIO::filesize_t size);
+    void slotSpeed(KIO::Job* job, unsigned long speed);
+
+    /** Removes the transfer of the job \a job, which has been finished or killed. */
+    void slotJobDestroyed(QObject* job);
+
+    /**
+     * Asks the user how to resolve the conflicts found by the job
+     * \a job and queues the corresponding transfer.
+     */
+    void slotScanFinished(WorkerJob* job);
+
+private:
+    /** Returns a transfer for the operation \a command, which has not been queued yet. */
+    Transfer createTransfer(const DolphinCommand& command);
+
+    /** Enqueues the ConflictScanJob for the local transfer \a transfer. */
+    void startScan(Transfer& transfer);
+
+    /**
+     * Returns true, if the transfer \a transfer uses its devices. This is the case
+     * if its conflicts are checked or resolved or if its job is running.
+     */
+    static bool isActive(const Transfer& transfer);
+
+    /**
+     * Returns the names of the items, which are written into the destination
+     * by the transfer \a transfer (see DolphinCommand::setDestNames()).
+     */
+    static QStringList destNames(const Transfer& transfer);
+
+    /** Returns the running transfer for the job \a job or 0. */
+    Transfer* findTransfer(const QObject* job);
+
+    /** Emits TransferScheduler::transfersChanged() after a short delay. */
+    void scheduleUpdate();
+
+    /** Returns the devices, which are accessed by the operation \a command. */
+    static QStringList devices(const DolphinCommand& command);
+
+    /**
+     * Returns an identifier for the device of \a url. For local URLs the
+     * device number of the file system is used, for remote URLs
+     * the protocol and the host.
+     */
+    static QString device(const KURL& url);
+
+    /** Returns true, if the transfer \a command is executed by a LocalCopyJob or LocalMoveJob. */
+    static bool isLocalTransfer(const DolphinCommand& command);
+
+    static KIO::Job* createJob(const Transfer& transfer);
+
+    int m_nextId;
+    QValueList<Transfer> m_transfers;
+    QTimer* m_updateTimer;
+};
+
+#endif
@@ -27,6 +27,7 @@
 #include "dolphin.h"
 #include "dolphinstatusbar.h"
 #include "progressindicator.h"
+#include "verificationlog.h"
 
 DolphinCommand::DolphinCommand() :
     m_type(Copy),
@@ -58,6 +59,7 @@ DolphinCommand& DolphinCommand::operator = (const DolphinCommand& command)
     m_type = command.m_type;
     m_source = command.m_source;
     m_dest = command.m_dest;
+    m_destNames = command.m_destNames;
     return *this;
 }
 
@@ -149,17 +151,27 @@ void UndoManager::undo()
         const KURL::List::Iterator end = sourceURLs.end();
         const QString destURL(command.destination().prettyURL(+1));
 
+        // only the items, which have been written by the operation, are undone
+        const QStringList& destNames = command.destNames();
+        QStringList::ConstIterator nameIt = destNames.begin();
+
         KIO::Job* job = 0;
         switch (command.type()) {
             case DolphinCommand::Link:
             case DolphinCommand::Copy: {
                 KURL::List list;
                 while (it != end) {
-                    const KURL deleteURL(destURL + (*it).filename());
-                    list.append(deleteURL);
+                    const QString name(destNames.isEmpty() ? (*it).filename() : *nameIt++);
+                    if (!name.isEmpty()) {
+                        const KURL deleteURL(destURL + name);
+                        list.append(deleteURL);
+                    }
                     ++it;
                 }
-                job = KIO::del(list, false, false);
+                if (!list.isEmpty()) {
+                    job = KIO::del(list, false, false);
+                    VerificationLog::instance().update(list, KURL::List());
+                }
                 break;
             }
 
@@ -167,11 +179,20 @@ void UndoManager::undo()
                 KURL::List list;
                 const KURL newDestURL((*it).directory());
                 while (it != end) {
-                    const KURL newSourceURL(destURL + (*it).filename());
-                    list.append(newSourceURL);
+                    const QString name(destNames.isEmpty() ? (*it).filename() : *nameIt++);
+                    if (name == (*it).filename()) {
+                        const KURL newSourceURL(destURL + name);
+                        list.append(newSourceURL);
+                    }
+                    else if (!name.isEmpty()) {
+                        // the item has been renamed because of a conflict
+                        KIO::NetAccess::move(KURL(destURL + name), *it);
+                    }
                     ++it;
                 }
-                job = KIO::move(list, newDestURL, false);
+                if (!list.isEmpty()) {
+                    job = KIO::move(list, newDestURL, false);
+                }
                 break;
             }
 
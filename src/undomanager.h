@@ -23,6 +23,7 @@
 
 #include <qobject.h>
 #include <qvaluelist.h>
+#include <qstringlist.h>
 #include <kurl.h>
 #include <kio/jobclasses.h>
 
@@ -63,11 +64,23 @@ public:
     const KURL::List& source() const { return m_source; }
     const KURL& destination() const { return m_dest; }
 
+    /**
+     * Sets the names of the items, which have been written into the destination
+     * by a copy or move operation, in the order of the source URLs. An empty
+     * name indicates that the source item has not been written as new item
+     * (e. g. because it has been skipped or merged into an existing folder),
+     * hence it is not touched by the undo operation. If no names are set, the
+     * names of the source items are used.
+     */
+    void setDestNames(const QStringList& names) { m_destNames = names; }
+    const QStringList& destNames() const { return m_destNames; }
+
 private:
     Type m_type;
     int m_macroIndex;
     KURL::List m_source;
     KURL m_dest;
+    QStringList m_destNames;
 
     friend class UndoManager;   // allow to modify m_macroIndex
 };
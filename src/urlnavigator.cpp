@@ -384,42 +384,6 @@ void URLNavigator::updateHistoryElem()
 
 void URLNavigator::updateContent()
 {
-    const QObjectList* list = children();
-    if (list == 0) {
-        return;
-    }
-
-    // set the iterator to the first URL navigator button
-    QObjectListIterator it(*list);
-    QObject* object = 0;
-    while ((object = it.current()) != 0) {
-        if (object->inherits("URLNavigatorButton")) {
-            break;
-        }
-        ++it;
-    }
-
-    // delete all existing URL navigator buttons
-    QPtrList<QWidget> deleteList;
-    while ((object = it.current()) != 0) {
-        if (object->inherits("URLNavigatorButton")) {
-            // Don't close and delete the navigator button immediatly, otherwise
-            // the iterator won't work anymore and an object would get deleted more
-            // than once (-> crash).
-            deleteList.append(static_cast<QWidget*>(object));
-        }
-        ++it;
-    }
-
-    // now close and delete all unused navigator buttons
-    QPtrListIterator<QWidget> deleteIter(deleteList);
-    QWidget* widget = 0;
-    while ((widget = deleteIter.current()) != 0) {
-        widget->close();
-        widget->deleteLater();
-        ++deleteIter;
-    }
-
     m_bookmarkSelector->updateSelection(url());
 
     QToolTip::remove(m_toggleButton);
@@ -431,6 +395,14 @@ void URLNavigator::updateContent()
         setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
         m_pathBox->show();
         m_pathBox->setURL(url());
+
+        // the URL navigator buttons are kept hidden for a later reuse
+        QValueList<URLNavigatorButton*>::Iterator it = m_navButtons.begin();
+        const QValueList<URLNavigatorButton*>::Iterator end = m_navButtons.end();
+        while (it != end) {
+            (*it)->hide();
+            ++it;
+        }
     }
     else {
         // TODO: don't hardcode the shortcut as part of the text
@@ -473,7 +445,11 @@ void URLNavigator::updateContent()
             --slashCount;
         }
 
-        // create URL navigator buttons
+        // Update the URL navigator buttons. Existing buttons are retargeted
+        // to the new path segments, so that only the buttons for additional
+        // segments must be created. As the unchanged segments keep their
+        // text and font, no relayout is triggered for them.
+        QValueList<URLNavigatorButton*>::Iterator buttonIt = m_navButtons.begin();
         int idx = slashCount;
         bool hasNext = true;
         do {
@@ -481,20 +457,41 @@ void URLNavigator::updateContent()
             const bool isFirstButton = (idx == slashCount);
             hasNext = isFirstButton || !dir_name.isEmpty();
             if (hasNext) {
-                URLNavigatorButton* button = new URLNavigatorButton(idx, this);
+                // the first URL navigator button should get the name of the bookmark
+                // instead of the directory name
+                QString text;
                 if (isFirstButton) {
-                    // the first URL navigator button should get the name of the bookmark
-                    // instead of the directory name
-                    QString text = bookmark.text();
+                    text = bookmark.text();
                     if (text.isEmpty()) {
                         text = bookmarkPath;
                     }
-                    button->setText(text);
+                }
+
+                URLNavigatorButton* button = 0;
+                if (buttonIt != m_navButtons.end()) {
+                    button = *buttonIt;
+                    button->setIndex(idx, text);
+                    ++buttonIt;
+                }
+                else {
+                    button = new URLNavigatorButton(idx, this, text);
+                    m_navButtons.append(button);
+                    buttonIt = m_navButtons.end();
                 }
                 button->show();
                 ++idx;
             }
         } while (hasNext);
+
+        // Close and delete the remaining buttons, which are not needed
+        // for the current URL. Don't delete the buttons immediately, as
+        // updateContent() might be invoked by a button itself.
+        while (buttonIt != m_navButtons.end()) {
+            URLNavigatorButton* button = *buttonIt;
+            buttonIt = m_navButtons.remove(buttonIt);
+            button->close();
+            button->deleteLater();
+        }
     }
 }
 
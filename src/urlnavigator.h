@@ -24,6 +24,7 @@
 #include <qhbox.h>
 #include <kurl.h>
 #include <qstring.h>
+#include <qvaluelist.h>
 
 class DolphinView;
 class QPopupMenu;
@@ -32,6 +33,7 @@ class QComboBox;
 class BookmarkSelector;
 class KURLComboBox;
 class KFileItem;
+class URLNavigatorButton;
 
 /**
  * @brief Navigation bar which contains the current shown URL.
@@ -199,6 +201,9 @@ private:
     BookmarkSelector* m_bookmarkSelector;
     KURLComboBox* m_pathBox;
 
+    /** URL navigator buttons from the left to the right, which are reused for each URL. */
+    QValueList<URLNavigatorButton*> m_navButtons;
+
     /**
      * Updates the history element with the current file item
      * and the contents position.
@@ -38,50 +38,58 @@
 #include "dolphinview.h"
 #include "dolphin.h"
 
-URLNavigatorButton::URLNavigatorButton(int index, URLNavigator* parent) :
+URLNavigatorButton::URLNavigatorButton(int index, URLNavigator* parent, const QString& text) :
     URLButton(parent),
     m_index(-1),
+    m_popupDelay(0),
     m_listJob(0)
 {
     setAcceptDrops(true);
     setMinimumWidth(arrowWidth());
-    setIndex(index);
-    connect(this, SIGNAL(clicked()), this, SLOT(updateNavigatorURL()));
 
     m_popupDelay = new QTimer(this);
     connect(m_popupDelay, SIGNAL(timeout()), this, SLOT(startListJob()));
     connect(this, SIGNAL(pressed()), this, SLOT(startPopupDelay()));
+
+    setIndex(index, text);
+    connect(this, SIGNAL(clicked()), this, SLOT(updateNavigatorURL()));
 }
 
 URLNavigatorButton::~URLNavigatorButton()
 {
 }
 
-void URLNavigatorButton::setIndex(int index)
+void URLNavigatorButton::setIndex(int index, const QString& text)
 {
     if (index < 0) {
         index = 0;
     }
 
-    m_index = index;
+    if (index != m_index) {
+        // the button has been retargeted to another part of the URL
+        stopPopupDelay();
+        m_index = index;
+    }
+
+    // Only change the text and the font if required, as both operations
+    // trigger a font measurement and a relayout of the URL navigator.
     QString path(urlNavigator()->url().prettyURL());
-    setText(path.section('/', index, index));
+    const QString buttonText(text.isEmpty() ? path.section('/', index, index) : text);
+    if (buttonText != this->text()) {
+        setText(buttonText);
+    }
 
     // Check whether the button indicates the full path of the URL. If
     // this is the case, the button is marked as 'active'.
     ++index;
-    QFont adjustedFont(font());
-    if (path.section('/', index, index).isEmpty()) {
-        setDisplayHintEnabled(ActivatedHint, true);
-        adjustedFont.setBold(true);
-    }
-    else {
-        setDisplayHintEnabled(ActivatedHint, false);
-        adjustedFont.setBold(false);
+    const bool isActive = path.section('/', index, index).isEmpty();
+    if (isActive != isDisplayHintEnabled(ActivatedHint)) {
+        setDisplayHintEnabled(ActivatedHint, isActive);
+        QFont adjustedFont(font());
+        adjustedFont.setBold(isActive);
+        setFont(adjustedFont);
+        update();
     }
-
-    setFont(adjustedFont);
-    update();
 }
 
 int URLNavigatorButton::index() const
@@ -230,6 +238,11 @@ void URLNavigatorButton::dragLeaveEvent(QDragLeaveEvent* event)
 
 void URLNavigatorButton::updateNavigatorURL()
 {
+    // The press of the click has started the popup delay. The button might
+    // be reused for the new URL with the same index, hence the popup must
+    // not be opened after an ordinary click.
+    stopPopupDelay();
+
     URLNavigator* navigator = urlNavigator();
     assert(navigator != 0);
     navigator->setURL(navigator->url(m_index));
@@ -48,9 +48,14 @@ class URLNavigatorButton : public URLButton
     Q_OBJECT
 
 public:
-    URLNavigatorButton(int index, URLNavigator* parent = 0);
+    URLNavigatorButton(int index, URLNavigator* parent = 0, const QString& text = QString::null);
     virtual ~URLNavigatorButton();
-    void setIndex(int index);
+
+    /**
+     * Retargets the button to the part \a index of the URL. If \a text is
+     * empty, the name of the URL part is used as button text.
+     */
+    void setIndex(int index, const QString& text = QString::null);
     int index() const;
 
 protected:
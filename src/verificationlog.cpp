@@ -0,0 +1,117 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "verificationlog.h"
+
+#include <qstringlist.h>
+
+#include <kapplication.h>
+#include <kconfig.h>
+
+// Maximum number of recorded files. If the limit is exceeded, no further
+// files are recorded until entries have been removed.
+#define MAX_FAILED_FILES 10000
+
+VerificationLog& VerificationLog::instance()
+{
+    static VerificationLog* instance = 0;
+    if (instance == 0) {
+        instance = new VerificationLog();
+    }
+    return *instance;
+}
+
+void VerificationLog::update(const KURL::List& items, const KURL::List& failedFiles)
+{
+    bool changed = false;
+
+    if (!m_failedFiles.isEmpty()) {
+        KURL::List::ConstIterator itemIt = items.begin();
+        const KURL::List::ConstIterator itemEnd = items.end();
+        while (itemIt != itemEnd) {
+            const QString path((*itemIt).path(-1));
+            if (m_failedFiles.contains(path)) {
+                m_failedFiles.remove(path);
+                changed = true;
+            }
+
+            // the files inside the folder 'path' are adjacent inside the map
+            const QString folderPath(path + '/');
+            QMap<QString, bool>::Iterator it = m_failedFiles.lowerBound(folderPath);
+            while ((it != m_failedFiles.end()) && it.key().startsWith(folderPath)) {
+                QMap<QString, bool>::Iterator removeIt = it;
+                ++it;
+                m_failedFiles.remove(removeIt);
+                changed = true;
+            }
+            ++itemIt;
+        }
+    }
+
+    KURL::List::ConstIterator it = failedFiles.begin();
+    const KURL::List::ConstIterator end = failedFiles.end();
+    while ((it != end) && (m_failedFiles.count() < MAX_FAILED_FILES)) {
+        m_failedFiles.insert((*it).path(-1), true);
+        changed = true;
+        ++it;
+    }
+
+    if (changed) {
+        save();
+    }
+}
+
+bool VerificationLog::hasFailed(const QString& path) const
+{
+    return m_failedFiles.contains(path);
+}
+
+VerificationLog::VerificationLog()
+{
+    KConfig* config = kapp->config();
+    config->setGroup("Verification");
+    const QStringList files(config->readPathListEntry("Failed Files"));
+    QStringList::ConstIterator it = files.begin();
+    const QStringList::ConstIterator end = files.end();
+    while (it != end) {
+        m_failedFiles.insert(*it, true);
+        ++it;
+    }
+}
+
+VerificationLog::~VerificationLog()
+{
+}
+
+void VerificationLog::save()
+{
+    QStringList files;
+    QMap<QString, bool>::ConstIterator it = m_failedFiles.begin();
+    const QMap<QString, bool>::ConstIterator end = m_failedFiles.end();
+    while (it != end) {
+        files.append(it.key());
+        ++it;
+    }
+
+    KConfig* config = kapp->config();
+    config->setGroup("Verification");
+    config->writePathEntry("Failed Files", files);
+    config->sync();
+}
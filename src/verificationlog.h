@@ -0,0 +1,64 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef VERIFICATIONLOG_H
+#define VERIFICATIONLOG_H
+
+#include <qmap.h>
+#include <qstring.h>
+
+#include <kurl.h>
+
+/**
+ * @brief Remembers the copied files, which did not pass the verification.
+ *
+ * If verifying is enabled, a LocalCopyJob compares the hash of each
+ * source file with the hash of the written copy. The copies with a different
+ * hash are recorded persistently by the verification log. As a corrupted copy
+ * has the same size and modification time as its source, the ConflictDialog
+ * checks the log and overwrites recorded files when copying them again. The
+ * entries of a file are removed as soon as the file passed a verification
+ * or the copy operation has been undone.
+ */
+class VerificationLog
+{
+public:
+    static VerificationLog& instance();
+
+    /**
+     * Removes all recorded files, which are located at or inside the
+     * local items \a items, and records the files \a failedFiles afterwards.
+     */
+    void update(const KURL::List& items, const KURL::List& failedFiles);
+
+    /** Returns true, if the local file \a path did not pass the last verification. */
+    bool hasFailed(const QString& path) const;
+
+protected:
+    VerificationLog();
+    virtual ~VerificationLog();
+
+private:
+    void save();
+
+    QMap<QString, bool> m_failedFiles;
+};
+
+#endif
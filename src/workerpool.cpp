@@ -0,0 +1,295 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "workerpool.h"
+
+#include <assert.h>
+#include <unistd.h>
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#endif
+
+#include <qapplication.h>
+#include <qthread.h>
+
+// Maximum number of threads, which are used by the worker pool.
+#define MAX_THREADS 4
+
+static const int JobFinishedEvent = QEvent::User + 28;
+
+// I/O scheduling classes of the Linux kernel (see ioprio_set(2)).
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_BE    2
+#define IOPRIO_CLASS_IDLE  3
+#define IOPRIO_VALUE(ioClass, level) (((ioClass) << 13) | (level))
+
+class WorkerThread : public QThread
+{
+public:
+    WorkerThread(WorkerPool* pool) : m_pool(pool) {}
+    virtual ~WorkerThread() {}
+
+protected:
+    virtual void run();
+
+private:
+    WorkerPool* m_pool;
+};
+
+void WorkerThread::run()
+{
+    // the I/O priority is only changed if a job of another class is executed
+    int ioPriority = -1;
+
+    WorkerJob* job = 0;
+    while ((job = m_pool->takeJob()) != 0) {
+        if (!job->isCancelled()) {
+            if (job->m_priority != ioPriority) {
+                ioPriority = job->m_priority;
+                WorkerPool::setIOPriority(0, job->m_priority);
+            }
+            job->run();
+        }
+        m_pool->finishJob(job);
+    }
+}
+
+WorkerJob::WorkerJob() :
+    m_cancelled(false),
+    m_priority(Preview),
+    m_owner(0)
+{
+}
+
+WorkerJob::~WorkerJob()
+{
+}
+
+bool WorkerJob::isCancelled() const
+{
+    return m_cancelled;
+}
+
+WorkerPool& WorkerPool::instance()
+{
+    static WorkerPool* instance = 0;
+    if (instance == 0) {
+        instance = new WorkerPool();
+    }
+    return *instance;
+}
+
+void WorkerPool::enqueue(WorkerJob* job, WorkerJob::Priority priority, const void* owner)
+{
+    assert(job != 0);
+    job->m_priority = priority;
+    job->m_owner = owner;
+
+    QMutexLocker locker(&m_mutex);
+
+    // insert the job behind all pending jobs having the same or a higher priority
+    uint index = m_pendingJobs.count();
+    while ((index > 0) && (m_pendingJobs.at(index - 1)->m_priority > priority)) {
+        --index;
+    }
+    m_pendingJobs.insert(index, job);
+
+    // The threads are created lazily: a new thread is only created
+    // if no idle thread is available for the job. The thread above
+    // m_maxThreads is reserved for jobs running in the foreground.
+    const int maxThreads = isBackground(priority) ? m_maxThreads : m_maxThreads + 1;
+    if ((m_idleThreads == 0) && (static_cast<int>(m_threads.count()) < maxThreads)) {
+        WorkerThread* thread = new WorkerThread(this);
+        m_threads.append(thread);
+        thread->start(QThread::LowPriority);
+    }
+
+    m_jobAvailable.wakeOne();
+}
+
+void WorkerPool::cancel(WorkerJob* job)
+{
+    if (job == 0) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_pendingJobs.removeRef(job)) {
+        // the job has not been started yet
+        delete job;
+    }
+    else {
+        // the job is currently executed and gets deleted by customEvent()
+        job->m_cancelled = true;
+    }
+}
+
+void WorkerPool::cancelJobs(const void* owner)
+{
+    if (owner == 0) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    QPtrList<WorkerJob> pendingJobs;
+    QPtrListIterator<WorkerJob> pendingIt(m_pendingJobs);
+    while (pendingIt.current() != 0) {
+        WorkerJob* job = pendingIt.current();
+        if (job->m_owner == owner) {
+            delete job;
+        }
+        else {
+            pendingJobs.append(job);
+        }
+        ++pendingIt;
+    }
+    m_pendingJobs = pendingJobs;
+
+    // the running jobs get deleted by customEvent()
+    QPtrListIterator<WorkerJob> runningIt(m_runningJobs);
+    while (runningIt.current() != 0) {
+        if (runningIt.current()->m_owner == owner) {
+            runningIt.current()->m_cancelled = true;
+        }
+        ++runningIt;
+    }
+}
+
+void WorkerPool::setIOPriority(int pid, WorkerJob::Priority priority)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_ioprio_set)
+    int value = 0;
+    switch (priority) {
+        case WorkerJob::Listing:  value = IOPRIO_VALUE(IOPRIO_CLASS_BE, 2); break;
+        case WorkerJob::Preview:  value = IOPRIO_VALUE(IOPRIO_CLASS_BE, 4); break;
+        case WorkerJob::MetaData: value = IOPRIO_VALUE(IOPRIO_CLASS_BE, 7); break;
+        case WorkerJob::Transfer: value = IOPRIO_VALUE(IOPRIO_CLASS_IDLE, 0); break;
+        default: assert(false); break;
+    }
+
+    // failures are ignored, as the priority is only a hint for the I/O scheduler
+    ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, pid, value);
+#else
+    Q_UNUSED(pid);
+    Q_UNUSED(priority);
+#endif
+}
+WorkerPool::WorkerPool() :
+    QObject(0),
+    m_quit(false),
+    m_idleThreads(0),
+    m_maxThreads(2),
+    m_runningBackgroundJobs(0)
+{
+    const long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpuCount > m_maxThreads) {
+        m_maxThreads = QMIN(static_cast<int>(cpuCount), MAX_THREADS);
+    }
+
+    m_pendingJobs.setAutoDelete(false);
+    m_runningJobs.setAutoDelete(false);
+    m_threads.setAutoDelete(true);
+}
+
+WorkerPool::~WorkerPool()
+{
+    m_mutex.lock();
+    m_quit = true;
+    QPtrListIterator<WorkerJob> jobIt(m_pendingJobs);
+    while (jobIt.current() != 0) {
+        delete jobIt.current();
+        ++jobIt;
+    }
+    m_pendingJobs.clear();
+    m_jobAvailable.wakeAll();
+    m_mutex.unlock();
+
+    QPtrListIterator<WorkerThread> threadIt(m_threads);
+    while (threadIt.current() != 0) {
+        threadIt.current()->wait();
+        ++threadIt;
+    }
+    m_threads.clear();
+}
+
+void WorkerPool::customEvent(QCustomEvent* event)
+{
+    if (event->type() != JobFinishedEvent) {
+        return;
+    }
+
+    WorkerJob* job = static_cast<WorkerJob*>(event->data());
+
+    m_mutex.lock();
+    const bool cancelled = job->m_cancelled;
+    m_runningJobs.removeRef(job);
+    m_mutex.unlock();
+
+    if (!cancelled) {
+        emit jobFinished(job);
+    }
+    delete job;
+}
+
+WorkerJob* WorkerPool::takeJob()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        // The pending jobs are ordered by their priority. If the first job
+        // runs in the background, all other pending jobs do it too.
+        WorkerJob* job = m_pendingJobs.getFirst();
+        const bool isAvailable = (job != 0) &&
+                                 (!isBackground(job->m_priority) ||
+                                  (m_runningBackgroundJobs < m_maxThreads));
+        if (isAvailable) {
+            m_pendingJobs.removeFirst();
+            m_runningJobs.append(job);
+            if (isBackground(job->m_priority)) {
+                ++m_runningBackgroundJobs;
+            }
+            return job;
+        }
+
+        ++m_idleThreads;
+        m_jobAvailable.wait(&m_mutex);
+        --m_idleThreads;
+    }
+
+    return 0;
+}
+
+void WorkerPool::finishJob(WorkerJob* job)
+{
+    m_mutex.lock();
+    if (isBackground(job->m_priority)) {
+        --m_runningBackgroundJobs;
+    }
+    m_mutex.unlock();
+
+    QApplication::postEvent(this, new QCustomEvent(JobFinishedEvent, job));
+}
+
+bool WorkerPool::isBackground(WorkerJob::Priority priority)
+{
+    return priority >= WorkerJob::MetaData;
+}
+
+#include "workerpool.moc"
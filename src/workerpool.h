@@ -0,0 +1,188 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <qobject.h>
+#include <qmutex.h>
+#include <qptrlist.h>
+#include <qwaitcondition.h>
+
+class WorkerThread;
+
+/**
+ * @brief Represents a task which is executed by the WorkerPool.
+ *
+ * Derived classes implement WorkerJob::run(), which is invoked
+ * inside a worker thread. As the KDE libraries are not thread-safe,
+ * run() may only work on data which has been prepared by the GUI
+ * thread. The results are fetched inside the GUI thread as soon
+ * as WorkerPool::jobFinished() is emitted.
+ */
+class WorkerJob
+{
+public:
+    /**
+     * Priority classes of the jobs, ordered from the highest to the lowest
+     * priority. Pending jobs of a higher class are started first, and the
+     * I/O priority of the worker thread is adjusted to the class of the
+     * executed job.
+     */
+    enum Priority
+    {
+        /** Listing of directories, where the user waits for the result. */
+        Listing,
+
+        /** Information about items, which are currently visible. */
+        Preview,
+
+        /** Meta information, sizes and indices, which are shown later. */
+        MetaData,
+
+        /** Copying, moving and deleting items. Uses the disk only if it is idle otherwise. */
+        Transfer
+    };
+
+    WorkerJob();
+    virtual ~WorkerJob();
+
+    /**
+     * Returns true, if the job has been cancelled by WorkerPool::cancel().
+     * Long running jobs should check this periodically inside run().
+     */
+    bool isCancelled() const;
+
+protected:
+    virtual void run() = 0;
+
+private:
+    friend class WorkerPool;
+    friend class WorkerThread;
+
+    volatile bool m_cancelled;
+    Priority m_priority;
+    const void* m_owner;
+};
+
+/**
+ * @brief Executes jobs inside a small number of background threads.
+ *
+ * Jobs are executed corresponding to their priority class (see
+ * WorkerJob::Priority) and in the order they have been added. If a job
+ * has been finished, the signal WorkerPool::jobFinished() is emitted inside
+ * the GUI thread and the job is deleted afterwards. Jobs which have been
+ * cancelled are deleted without emitting the signal.
+ *
+ * Long running background jobs (meta data and transfers) never occupy
+ * all threads: one additional thread is reserved for listing and preview
+ * jobs, so that browsing stays responsive while items are copied.
+ *
+ * Jobs can be enqueued for an owner (e. g. a DolphinView). All jobs
+ * of an owner can be cancelled at once by WorkerPool::cancelJobs(),
+ * for example if the view shows another directory.
+ *
+ * Sample code:
+ * \code
+ * MyJob* job = new MyJob(...);
+ * connect(&WorkerPool::instance(), SIGNAL(jobFinished(WorkerJob*)),
+ *         this, SLOT(slotJobFinished(WorkerJob*)));
+ * WorkerPool::instance().enqueue(job, WorkerJob::Preview, this);
+ * \endcode
+ */
+class WorkerPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    static WorkerPool& instance();
+
+    /**
+     * Adds the job \a job with the priority class \a priority to the queue
+     * of pending jobs. The ownership of the job is passed to the worker
+     * pool. If \a owner is given, the job can be cancelled together with
+     * all other jobs of the owner by WorkerPool::cancelJobs().
+     */
+    void enqueue(WorkerJob* job, WorkerJob::Priority priority, const void* owner = 0);
+
+    /**
+     * Cancels the job \a job. A pending job is deleted immediately, a running
+     * job is deleted after WorkerJob::run() has been left. In both cases
+     * the signal WorkerPool::jobFinished() won't be emitted for the job.
+     */
+    void cancel(WorkerJob* job);
+
+    /** Cancels all pending and running jobs, which have been enqueued for the owner \a owner. */
+    void cancelJobs(const void* owner);
+
+    /**
+     * Applies the I/O priority, which corresponds to the priority class
+     * \a priority, to the thread or process \a pid. If \a pid is 0, the
+     * calling thread is used. Is only supported on Linux.
+     */
+    static void setIOPriority(int pid, WorkerJob::Priority priority);
+
+signals:
+    /**
+     * Is emitted inside the GUI thread if the job \a job has been finished. The job
+     * gets deleted after all receivers have been invoked.
+     */
+    void jobFinished(WorkerJob* job);
+
+protected:
+    WorkerPool();
+    virtual ~WorkerPool();
+
+    /** @see QObject::customEvent() */
+    virtual void customEvent(QCustomEvent* event);
+
+private:
+    /**
+     * Returns the next pending job. Is invoked by the worker threads and
+     * blocks until a job is available. 0 is returned if the worker
+     * thread should quit.
+     */
+    WorkerJob* takeJob();
+
+    /** Informs the GUI thread that the job \a job has been finished. */
+    void finishJob(WorkerJob* job);
+
+    /** Returns true, if jobs of the class \a priority run in the background. */
+    static bool isBackground(WorkerJob::Priority priority);
+
+    friend class WorkerThread;
+
+    bool m_quit;
+    int m_idleThreads;
+    int m_maxThreads;
+
+    /** Number of running jobs, for which WorkerPool::isBackground() returns true. */
+    int m_runningBackgroundJobs;
+
+    QMutex m_mutex;
+    QWaitCondition m_jobAvailable;
+
+    /** Pending jobs, ordered by their priority classes. */
+    QPtrList<WorkerJob> m_pendingJobs;
+    QPtrList<WorkerJob> m_runningJobs;
+    QPtrList<WorkerThread> m_threads;
+};
+
+#endif
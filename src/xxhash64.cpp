@@ -0,0 +1,161 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#include "xxhash64.h"
+
+#include <string.h>
+
+// The algorithm is described at https://github.com/Cyan4973/xxHash.
+
+static const Q_UINT64 PRIME1 = 11400714785074694791ULL;
+static const Q_UINT64 PRIME2 = 14029467366897019727ULL;
+static const Q_UINT64 PRIME3 = 1609587929392839161ULL;
+static const Q_UINT64 PRIME4 = 9650029242287828579ULL;
+static const Q_UINT64 PRIME5 = 2870177450012600261ULL;
+
+static inline Q_UINT64 rotateLeft(Q_UINT64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/** Reads a little endian 64 bit value independent from the byte order of the CPU. */
+static inline Q_UINT64 read64(const unsigned char* p)
+{
+    return static_cast<Q_UINT64>(p[0])        | (static_cast<Q_UINT64>(p[1]) << 8)  |
+           (static_cast<Q_UINT64>(p[2]) << 16) | (static_cast<Q_UINT64>(p[3]) << 24) |
+           (static_cast<Q_UINT64>(p[4]) << 32) | (static_cast<Q_UINT64>(p[5]) << 40) |
+           (static_cast<Q_UINT64>(p[6]) << 48) | (static_cast<Q_UINT64>(p[7]) << 56);
+}
+
+static inline Q_UINT64 read32(const unsigned char* p)
+{
+    return static_cast<Q_UINT64>(p[0])        | (static_cast<Q_UINT64>(p[1]) << 8) |
+           (static_cast<Q_UINT64>(p[2]) << 16) | (static_cast<Q_UINT64>(p[3]) << 24);
+}
+
+static inline Q_UINT64 hashRound(Q_UINT64 acc, Q_UINT64 input)
+{
+    acc += input * PRIME2;
+    acc = rotateLeft(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline Q_UINT64 mergeRound(Q_UINT64 acc, Q_UINT64 value)
+{
+    acc ^= hashRound(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+XXHash64::XXHash64(Q_UINT64 seed)
+{
+    reset(seed);
+}
+
+void XXHash64::reset(Q_UINT64 seed)
+{
+    m_seed = seed;
+    m_v1 = seed + PRIME1 + PRIME2;
+    m_v2 = seed + PRIME2;
+    m_v3 = seed;
+    m_v4 = seed - PRIME1;
+    m_totalLength = 0;
+    m_bufferSize = 0;
+}
+
+void XXHash64::update(const char* data, size_t length)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + length;
+    m_totalLength += length;
+
+    if (m_bufferSize + length < 32) {
+        // not enough data for a stripe
+        memcpy(m_buffer + m_bufferSize, p, length);
+        m_bufferSize += length;
+        return;
+    }
+
+    if (m_bufferSize > 0) {
+        // complete the buffered stripe
+        const uint fill = 32 - m_bufferSize;
+        memcpy(m_buffer + m_bufferSize, p, fill);
+        p += fill;
+        m_v1 = hashRound(m_v1, read64(m_buffer));
+        m_v2 = hashRound(m_v2, read64(m_buffer + 8));
+        m_v3 = hashRound(m_v3, read64(m_buffer + 16));
+        m_v4 = hashRound(m_v4, read64(m_buffer + 24));
+        m_bufferSize = 0;
+    }
+
+    while (p + 32 <= end) {
+        m_v1 = hashRound(m_v1, read64(p));
+        m_v2 = hashRound(m_v2, read64(p + 8));
+        m_v3 = hashRound(m_v3, read64(p + 16));
+        m_v4 = hashRound(m_v4, read64(p + 24));
+        p += 32;
+    }
+
+    if (p < end) {
+        m_bufferSize = end - p;
+        memcpy(m_buffer, p, m_bufferSize);
+    }
+}
+
+Q_UINT64 XXHash64::digest() const
+{
+    Q_UINT64 hash = 0;
+    if (m_totalLength >= 32) {
+        hash = rotateLeft(m_v1, 1) + rotateLeft(m_v2, 7) +
+               rotateLeft(m_v3, 12) + rotateLeft(m_v4, 18);
+        hash = mergeRound(hash, m_v1);
+        hash = mergeRound(hash, m_v2);
+        hash = mergeRound(hash, m_v3);
+        hash = mergeRound(hash, m_v4);
+    }
+    else {
+        hash = m_seed + PRIME5;
+    }
+    hash += m_totalLength;
+
+    const unsigned char* p = m_buffer;
+    const unsigned char* const end = m_buffer + m_bufferSize;
+    while (p + 8 <= end) {
+        hash ^= hashRound(0, read64(p));
+        hash = rotateLeft(hash, 27) * PRIME1 + PRIME4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        hash ^= read32(p) * PRIME1;
+        hash = rotateLeft(hash, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        hash ^= (*p) * PRIME5;
+        hash = rotateLeft(hash, 11) * PRIME1;
+        ++p;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
@@ -0,0 +1,67 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by the Dolphin developers                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
+ ***************************************************************************/
+
+
+#ifndef XXHASH64_H
+#define XXHASH64_H
+
+#include <qglobal.h>
+#include <stddef.h>
+
+/**
+ * @brief Calculates the 64 bit xxHash (XXH64) of a stream of data.
+ *
+ * xxHash is a fast non-cryptographic hash, which processes several gigabytes
+ * per second and core. It is used for verifying copied files, where the
+ * hash must keep pace with the disk, but no protection against manipulated
+ * data is required.
+ * \code
+ * XXHash64 hash;
+ * while (...) {
+ *     hash.update(buffer, size);
+ * }
+ * const Q_UINT64 digest = hash.digest();
+ * \endcode
+ */
+class XXHash64
+{
+public:
+    XXHash64(Q_UINT64 seed = 0);
+
+    /** Resets the hash to the initial state. */
+    void reset(Q_UINT64 seed = 0);
+
+    /** Adds \a length bytes of \a data to the hash. */
+    void update(const char* data, size_t length);
+
+    /** Returns the hash of all added data. The state of the hash is not changed. */
+    Q_UINT64 digest() const;
+
+private:
+    Q_UINT64 m_v1;
+    Q_UINT64 m_v2;
+    Q_UINT64 m_v3;
+    Q_UINT64 m_v4;
+    Q_UINT64 m_seed;
+    Q_UINT64 m_totalLength;
+    unsigned char m_buffer[32];
+    uint m_bufferSize;
+};
+
+#endif